@@ -0,0 +1,127 @@
+/**
+ * Sequential write and read of a large BinaryAdapter payload through the file stream backends.
+ * Usage: bench_file_streams [directory] [size in MB]
+ * Between the write and the read the file is dropped from the page cache, so the reads are cold.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+//
+#include <Serialization/Serialization.h>
+
+#ifdef __linux__
+#include <Serialization/DirectFileStream.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using Payload = std::vector<std::string>;
+
+	constexpr size_t chunkSize = 64 * 1024;
+
+	Payload MakePayload(const size_t megabytes)
+	{
+		Payload payload(megabytes * 1024 * 1024 / chunkSize);
+		char fill = 0;
+		for (auto & chunk : payload) chunk.assign(chunkSize, ++fill);
+		return payload;
+	}
+
+	void DropFromPageCache(const std::string & path)
+	{
+#ifdef __linux__
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) return;
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+#endif
+	}
+
+	double Seconds(const std::function<void()> & action)
+	{
+		const auto start = Clock::now();
+		action();
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	void Report(const char * name, const size_t megabytes, const double writeSeconds, const double readSeconds)
+	{
+		std::printf("%-24s write %8.1f MB/s   read %8.1f MB/s\n", name, megabytes / writeSeconds, megabytes / readSeconds);
+	}
+
+	void BenchFstream(const std::string & path, const Payload & payload, const size_t megabytes)
+	{
+		const auto writeSeconds = Seconds([&] {
+			std::fstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			Grafkit::Stream<std::fstream> stream(file);
+			Grafkit::BinarySerializer serializer(stream);
+			serializer << payload;
+			file.flush();
+		});
+		DropFromPageCache(path);
+		const auto readSeconds = Seconds([&] {
+			std::fstream file(path, std::ios::in | std::ios::binary);
+			Grafkit::Stream<std::fstream> stream(file);
+			Grafkit::BinarySerializer serializer(stream);
+			Payload readPayload;
+			serializer >> readPayload;
+		});
+		Report("Stream<std::fstream>", megabytes, writeSeconds, readSeconds);
+	}
+
+#ifdef __linux__
+	void BenchDirect(const char * name, const std::string & path, const Payload & payload, const size_t megabytes, const Grafkit::DirectFileOptions & options)
+	{
+		bool usesIoUring = false;
+		bool usesDirectIo = false;
+		const auto writeSeconds = Seconds([&] {
+			Grafkit::DirectFileStream stream(path, Grafkit::EFileMode::Write, options);
+			Grafkit::BinarySerializer serializer(stream);
+			serializer << payload;
+			stream.Close();
+			usesIoUring = stream.UsesIoUring();
+			usesDirectIo = stream.UsesDirectIo();
+		});
+		DropFromPageCache(path);
+		const auto readSeconds = Seconds([&] {
+			Grafkit::DirectFileStream stream(path, Grafkit::EFileMode::Read, options);
+			Grafkit::BinarySerializer serializer(stream);
+			Payload readPayload;
+			serializer >> readPayload;
+		});
+		Report(name, megabytes, writeSeconds, readSeconds);
+		if (options.useIoUring != usesIoUring || options.directIo != usesDirectIo)
+			std::printf("%-24s (fell back to io_uring=%d O_DIRECT=%d)\n", "", usesIoUring, usesDirectIo);
+	}
+#endif
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+	const std::filesystem::path directory = argc > 1 ? argv[1] : std::filesystem::temp_directory_path().string();
+	const size_t megabytes = argc > 2 ? std::stoul(argv[2]) : 512;
+	const auto path = (directory / "grafkit_bench_file_streams.bin").string();
+
+	const auto payload = MakePayload(megabytes);
+	std::printf("%zu MB in %zu strings of %zu bytes, %s\n", megabytes, payload.size(), chunkSize, path.c_str());
+
+	BenchFstream(path, payload, megabytes);
+#ifdef __linux__
+	BenchDirect("pread/pwrite", path, payload, megabytes, {1 << 20, 4, false, false});
+	BenchDirect("io_uring", path, payload, megabytes, {1 << 20, 4, false, true});
+	BenchDirect("io_uring + O_DIRECT", path, payload, megabytes, {1 << 20, 4, true, true});
+#endif
+
+	std::filesystem::remove(path);
+	return 0;
+}
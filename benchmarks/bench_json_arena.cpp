@@ -0,0 +1,102 @@
+/**
+ * JSON DOM on the heap against the same DOM in a JsonArena, for a large document of small nodes.
+ * Usage: bench_json_arena [line count] [repeats]
+ * Build + dump covers the serializer writing the DOM, parse + read + teardown the way back; the arena is released with the DOM.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+//
+#include <Serialization/Serialization.h>
+//
+#include "Geometry.h"
+
+using Serializable = Grafkit::Attributes::Serializable;
+
+struct Drawing
+{
+	std::vector<Line> lines;
+	std::vector<std::string> labels;
+	std::map<std::string, int> layers;
+};
+
+REFL_TYPE(Drawing, bases<>)
+REFL_FIELD(lines, Serializable())
+REFL_FIELD(labels, Serializable())
+REFL_FIELD(layers, Serializable())
+REFL_END
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	Drawing MakeDrawing(const size_t lineCount)
+	{
+		Drawing drawing;
+		drawing.lines.reserve(lineCount);
+		drawing.labels.reserve(lineCount);
+		for (size_t i = 0; i < lineCount; ++i)
+		{
+			const auto f = static_cast<float>(i);
+			drawing.lines.push_back({{f, -f}, {f * .5f, f + 1.f}});
+			drawing.labels.push_back("line" + std::to_string(i % 100));
+		}
+		for (int i = 0; i < 1000; ++i) drawing.layers["layer" + std::to_string(i)] = i;
+		return drawing;
+	}
+
+	double Seconds(const std::function<void()> & action)
+	{
+		const auto start = Clock::now();
+		action();
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	template <class JsonT, class AdapterT> void Bench(const char * name, const Drawing & drawing, const size_t repeats, const bool useArena)
+	{
+		double writeSeconds = 0;
+		double readSeconds = 0;
+		size_t textSize = 0;
+		for (size_t i = 0; i < repeats; ++i)
+		{
+			std::string text;
+			writeSeconds += Seconds([&] {
+				std::unique_ptr<Grafkit::JsonArena> arena = useArena ? std::make_unique<Grafkit::JsonArena>() : nullptr;
+				JsonT json;
+				AdapterT adapter(json);
+				adapter << drawing;
+				text = json.dump();
+			});
+			textSize = text.size();
+
+			readSeconds += Seconds([&] {
+				std::unique_ptr<Grafkit::JsonArena> arena = useArena ? std::make_unique<Grafkit::JsonArena>() : nullptr;
+				auto json = JsonT::parse(text);
+				Drawing readDrawing;
+				AdapterT adapter(json);
+				adapter >> readDrawing;
+			});
+		}
+		const double megabytes = static_cast<double>(textSize * repeats) / (1024 * 1024);
+		std::printf("%-12s build + dump %8.1f MB/s   parse + read + teardown %8.1f MB/s\n", name, megabytes / writeSeconds, megabytes / readSeconds);
+	}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+	const size_t lineCount = argc > 1 ? std::stoul(argv[1]) : 50000;
+	const size_t repeats = argc > 2 ? std::stoul(argv[2]) : 3;
+
+	const auto drawing = MakeDrawing(lineCount);
+	std::printf("%zu lines, %zu repeats\n", lineCount, repeats);
+
+	Bench<Grafkit::Json, Grafkit::JsonSerializer>("heap", drawing, repeats, false);
+	Bench<Grafkit::ArenaJson, Grafkit::ArenaJsonSerializer>("arena", drawing, repeats, true);
+	return 0;
+}
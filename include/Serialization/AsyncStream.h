@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+//
+#include <Serialization/Stream.h>
+
+namespace Grafkit
+{
+	enum class EFsyncPolicy
+	{
+		None,        // leave it to the OS
+		OnClose,     // once, after the last buffer
+		EveryBuffer, // after each buffer written
+	};
+
+	struct AsyncOutputOptions
+	{
+		size_t bufferSize = 1 << 20;
+		size_t queueDepth = 1; // buffers handed over to the background thread at most; 1 means double buffering
+		EFsyncPolicy fsyncPolicy = EFsyncPolicy::OnClose;
+	};
+
+	struct PrefetchInputOptions
+	{
+		size_t blockSize = 1 << 20;
+		size_t blocksInFlight = 2; // blocks read ahead of the one being consumed
+	};
+
+	/**
+	 * Output stream to a file, written on a background thread.
+	 * Writes are collected into a buffer; full buffers are queued up for the background thread, and the caller carries on with a free one.
+	 * The caller only waits on disk I/O when all the buffers are queued up (back-pressure).
+	 */
+	class AsyncOutputStream final : public IStream
+	{
+	public:
+		explicit AsyncOutputStream(const std::string & path, const AsyncOutputOptions & options = {});
+		~AsyncOutputStream() noexcept override;
+
+		AsyncOutputStream(const AsyncOutputStream &) = delete;
+		AsyncOutputStream & operator=(const AsyncOutputStream &) = delete;
+
+		void Read(char * const &, size_t) override { throw std::runtime_error("Can't read from an AsyncOutputStream"); }
+		void Write(const char * buffer, size_t length) override;
+		[[nodiscard]] bool IsSuccess() const override { return !mFailed && !mClosed; }
+
+		[[nodiscard]] bool ReadAll(StreamData &) override { throw std::runtime_error("Can't read from an AsyncOutputStream"); }
+
+		explicit operator std::istream &() const override { throw std::runtime_error("Can't read from an AsyncOutputStream"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("AsyncOutputStream is not an std::ostream"); }
+
+		// Hands over the pending buffer to the background thread, without waiting for it to be written
+		void Flush();
+
+		/**
+		 * Hands over the pending buffer and stops accepting writes.
+		 * The returned future gets ready once everything is written (and synced, as of the policy); it rethrows any I/O error.
+		 */
+		std::shared_future<void> Close();
+
+		[[nodiscard]] std::shared_future<void> Completion() const { return mCompletion; }
+
+		// Number of times a Write had to wait for a free buffer
+		[[nodiscard]] size_t StallCount() const { return mStallCount; }
+
+	private:
+		void Submit(bool takeFreeBuffer);
+		void Run();
+
+		AsyncOutputOptions mOptions;
+		std::FILE * mFile = nullptr;
+
+		std::vector<char> mCurrent;
+		std::deque<std::vector<char>> mQueue;
+		std::vector<std::vector<char>> mFreeBuffers;
+
+		std::mutex mMutex;
+		std::condition_variable mQueueChanged;
+		std::condition_variable mBufferFreed;
+
+		bool mStop = false;
+		bool mClosed = false;
+		std::atomic<bool> mFailed{false};
+		size_t mStallCount = 0;
+
+		std::promise<void> mPromise;
+		std::shared_future<void> mCompletion;
+		std::thread mThread;
+	};
+
+	/**
+	 * Input stream from a file, read ahead on a background thread.
+	 * While the caller decodes the current block, the next blocks are already being read, so I/O and decoding overlap.
+	 */
+	class PrefetchInputStream final : public IStream
+	{
+	public:
+		explicit PrefetchInputStream(const std::string & path, const PrefetchInputOptions & options = {});
+		~PrefetchInputStream() noexcept override;
+
+		PrefetchInputStream(const PrefetchInputStream &) = delete;
+		PrefetchInputStream & operator=(const PrefetchInputStream &) = delete;
+
+		void Read(char * const & buffer, size_t length) override;
+		void Write(const char *, size_t) override { throw std::runtime_error("Can't write to a PrefetchInputStream"); }
+		[[nodiscard]] bool IsSuccess() const override { return mSuccess; }
+
+		// Reads everything from the current position on
+		[[nodiscard]] bool ReadAll(StreamData & outBuffer) override;
+
+		explicit operator std::istream &() const override { throw std::runtime_error("PrefetchInputStream is not an std::istream"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("Can't write to a PrefetchInputStream"); }
+
+		// Number of times a Read had to wait for the next block
+		[[nodiscard]] size_t StallCount() const { return mStallCount; }
+
+	private:
+		// Moves on to the next block; false at the end of the file
+		bool NextBlock();
+		void Run();
+
+		PrefetchInputOptions mOptions;
+		std::FILE * mFile = nullptr;
+
+		std::vector<char> mCurrent;
+		size_t mPosition = 0;
+		std::deque<std::vector<char>> mReady;
+		std::vector<std::vector<char>> mFreeBuffers;
+
+		std::mutex mMutex;
+		std::condition_variable mBlockReady;
+		std::condition_variable mBufferFreed;
+
+		bool mStop = false;
+		bool mEndOfFile = false; // set by the background thread after the last block is queued
+		std::exception_ptr mError;
+		bool mSuccess = true;
+		size_t mStallCount = 0;
+
+		std::thread mThread;
+	};
+
+} // namespace Grafkit
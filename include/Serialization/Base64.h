@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+//
+#include <Serialization/Traits.h>
+
+namespace Grafkit::Utils::Base64
+{
+	/**
+	 * Base64 with the standard alphabet and padding (RFC 4648), no line breaks.
+	 * Both directions run 24 bytes at a time with AVX2 or 12 with SSSE3 when the CPU has them, checked once on first use;
+	 * the tails and other CPUs take a table driven scalar loop.
+	 */
+
+	// Instruction set the bulk of the data is coded with; Best is the one picked for the CPU
+	enum class EKernel
+	{
+		Best,
+		Scalar,
+		Ssse3,
+		Avx2,
+	};
+
+	// Whether the CPU can run the kernel
+	bool IsSupported(EKernel kernel);
+
+	constexpr size_t EncodedSize(const size_t size) { return (size + 2) / 3 * 4; }
+
+	// Writes EncodedSize(size) characters to out; kernels the CPU does not support throw std::runtime_error
+	void Encode(const void * data, size_t size, char * out, EKernel kernel = EKernel::Best);
+	std::string Encode(const void * data, size_t size);
+
+	// Size of the decoded data; throws std::runtime_error if the length or the padding is not valid
+	size_t DecodedSize(std::string_view text);
+
+	// Writes DecodedSize(text) bytes to out; throws std::runtime_error on characters outside of the alphabet
+	void Decode(std::string_view text, void * out, EKernel kernel = EKernel::Best);
+
+	// Bytes of a value for which Traits::is_blob_type_v holds, in the byte order of the machine
+	template <typename Type> std::string EncodeBlob(const Type & value)
+	{
+		static_assert(Traits::is_blob_type_v<Type>, "Blobs have to be trivially copyable, or contiguous containers of such");
+		if constexpr (Traits::has_contiguous_data_v<Type> && Traits::has_resize_v<Type>)
+			return Encode(value.data(), value.size() * sizeof(typename Type::value_type));
+		else
+			return Encode(&value, sizeof(Type));
+	}
+
+	// Decodes straight into the value, containers are resized to fit
+	template <typename Type> void DecodeBlob(const std::string_view text, Type & value)
+	{
+		static_assert(Traits::is_blob_type_v<Type>, "Blobs have to be trivially copyable, or contiguous containers of such");
+		const auto size = DecodedSize(text);
+		if constexpr (Traits::has_contiguous_data_v<Type> && Traits::has_resize_v<Type>)
+		{
+			using ValueType = typename Type::value_type;
+			if (size % sizeof(ValueType)) throw std::runtime_error("malformed data - blob size");
+			value.resize(size / sizeof(ValueType));
+			Decode(text, value.data());
+		}
+		else
+		{
+			if (size != sizeof(Type)) throw std::runtime_error("malformed data - blob size");
+			Decode(text, &value);
+		}
+	}
+
+} // namespace Grafkit::Utils::Base64
@@ -1,36 +1,70 @@
 #pragma once
 #include <algorithm>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <type_traits>
+#include <vector>
 //
 #include <refl.h>
 //
 #include <Serialization/Crc32.h>
 #include <Serialization/Dynamics.h>
+#include <Serialization/Encoding.h>
 #include <Serialization/EndianSwapper.h>
+#include <Serialization/FlatMap.h>
+#include <Serialization/MemoryStream.h>
+#include <Serialization/SequenceCodecs.h>
 #include <Serialization/SerializerBase.h>
 #include <Serialization/Signature.h>
 #include <Serialization/Stream.h>
+#include <Serialization/ThreadPool.h>
+#include <Serialization/Utf8.h>
 
 namespace Grafkit::Serializer
 {
-	class BinaryAdapter : public SerializerBase
+	/**
+	 * Large vectors of non-trivial elements (structs, strings, nested containers) are cut into chunks,
+	 * which are serialized into buffers of their own on a thread pool and decoded the same way.
+	 */
+	struct ParallelOptions
 	{
+		ThreadPool * pool = nullptr;    // nullptr: off, plain element-by-element format
+		size_t minElements = 1 << 16;   // smaller containers are written as usual
+		size_t chunkElements = 1 << 14; // elements in each independently decodable chunk
+		bool subtrees = false;          // polymorphic pointees are length-prefixed; sibling subtrees are decoded on the pool
+	};
+
+	/**
+	 * Binary serializer over any type that models the stream concept (see Traits::is_stream).
+	 * With a concrete stream type, reads and writes are direct calls the compiler can inline; BinaryAdapter is the type-erased one over IStream.
+	 * @tparam StreamT
+	 */
+	template <class StreamT> class BasicBinaryAdapter : public SerializerBase
+	{
+		static_assert(Traits::is_stream_v<StreamT>, "StreamT has to provide Read, Write and IsSuccess");
+
 	public:
 		using SizeType = uint64_t;
+		using SequenceCodecPolicy = Utils::SequenceCodecs::EPolicy;
+		using Utf8Validation = Utils::Utf8::EValidation;
 
 		static constexpr size_t StringBufferSize = 4096;
 
 		// TODO: Get rid of std::unique_ptr
 
-		explicit BinaryAdapter(IStream & stream) : stream(stream) {}
-		explicit BinaryAdapter(IStream && stream) : stream(stream) {}
+		explicit BasicBinaryAdapter(StreamT & stream) : stream(stream) {}
+		explicit BasicBinaryAdapter(StreamT && stream) : stream(stream) {}
 
-		template <class T> BinaryAdapter & operator<<(const T & value)
+		template <class T> BasicBinaryAdapter & operator<<(const T & value)
 		{
 			Write(value);
+			ReleaseBorrowed();
 			return *this;
 		}
-		template <class T> const BinaryAdapter & operator>>(T & value) const
+		template <class T> const BasicBinaryAdapter & operator>>(T & value) const
 		{
 			Read(value);
 			return *this;
@@ -38,11 +72,134 @@ namespace Grafkit::Serializer
 
 		// https://github.com/veselink1/refl-cpp/issues/29
 
+		/**
+		 * Containers of numbers get a one byte codec tag, and the codec is picked for each container by sampling its content.
+		 * Off by default, which keeps the plain element-by-element format. Both sides have to use the same setting.
+		 */
+		void SetSequenceCodecPolicy(const SequenceCodecPolicy policy) { sequenceCodecPolicy = policy; }
+		[[nodiscard]] SequenceCodecPolicy GetSequenceCodecPolicy() const { return sequenceCodecPolicy; }
+
+		/**
+		 * Containers taking the parallel path get the element count of a chunk and a table of the chunk sizes in front of the chunks.
+		 * Off by default. Both sides have to use the same pool setting and minElements.
+		 * The subtree format depends on the subtrees flag alone; without a pool the subtrees are decoded one after the other.
+		 */
+		void SetParallelOptions(const ParallelOptions & options) { parallelOptions = options; }
+		[[nodiscard]] const ParallelOptions & GetParallelOptions() const { return parallelOptions; }
+
+		/**
+		 * std::string values are checked for valid UTF-8 right after they are read, in place. Off by default; only the reading side cares.
+		 */
+		void SetUtf8Validation(const Utf8Validation validation) { utf8Validation = validation; }
+		[[nodiscard]] Utf8Validation GetUtf8Validation() const { return utf8Validation; }
+
+		// --------------------------------------------------------
+		// Chunked sequences
+		// Sequences of unknown length are written as a run of (count, elements) chunks, terminated by an empty chunk,
+		// so the producer never has to hold more than one chunk in memory.
+
+		static constexpr size_t DefaultChunkSize = 1024;
+
+		/**
+		 * Collects pushed elements and flushes them chunk by chunk.
+		 * Finish() has to be called to write the terminating chunk, unless the writer is left by an exception.
+		 * @tparam T element type
+		 */
+		template <typename T> class ChunkedWriter
+		{
+		public:
+			ChunkedWriter(BasicBinaryAdapter & adapter, const size_t chunkSize) : mAdapter(adapter), mChunkSize(std::max<size_t>(chunkSize, 1))
+			{
+				mBuffer.reserve(mChunkSize);
+			}
+
+			ChunkedWriter(const ChunkedWriter &) = delete;
+			ChunkedWriter & operator=(const ChunkedWriter &) = delete;
+
+			~ChunkedWriter() { assert(mFinished || std::uncaught_exceptions() > 0); }
+
+			void Push(const T & value)
+			{
+				assert(!mFinished);
+				mBuffer.push_back(value);
+				if (mBuffer.size() >= mChunkSize) Flush();
+			}
+
+			void Push(T && value)
+			{
+				assert(!mFinished);
+				mBuffer.push_back(std::move(value));
+				if (mBuffer.size() >= mChunkSize) Flush();
+			}
+
+			void Finish()
+			{
+				if (mFinished) return;
+				Flush();
+				mAdapter.Write(static_cast<SizeType>(0));
+				mFinished = true;
+			}
+
+		private:
+			void Flush()
+			{
+				if (mBuffer.empty()) return;
+				mAdapter.Write(static_cast<SizeType>(mBuffer.size()));
+				for (const auto & elem : mBuffer) mAdapter.Write(elem);
+				mAdapter.ReleaseBorrowed();
+				mBuffer.clear();
+			}
+
+			BasicBinaryAdapter & mAdapter;
+			std::vector<T> mBuffer;
+			size_t mChunkSize;
+			bool mFinished = false;
+		};
+
+		template <typename T> ChunkedWriter<T> BeginChunked(const size_t chunkSize = DefaultChunkSize) { return ChunkedWriter<T>(*this, chunkSize); }
+
+		// Writes an input range of unknown length
+		template <typename InputIt> void WriteChunked(InputIt first, InputIt last, const size_t chunkSize = DefaultChunkSize)
+		{
+			auto writer = BeginChunked<typename std::iterator_traits<InputIt>::value_type>(chunkSize);
+			for (; first != last; ++first) writer.Push(*first);
+			writer.Finish();
+		}
+
+		// Writes everything a generator yields, until it returns an empty std::optional
+		template <typename Generator> void WriteChunkedFrom(Generator && generator, const size_t chunkSize = DefaultChunkSize)
+		{
+			using ValueType = typename std::invoke_result_t<Generator>::value_type;
+			auto writer = BeginChunked<ValueType>(chunkSize);
+			for (auto elem = generator(); elem.has_value(); elem = generator()) writer.Push(std::move(*elem));
+			writer.Finish();
+		}
+
+		// Reads a chunked sequence and hands over each element to the callback; returns the number of elements read
+		template <typename T, typename Callback> SizeType ReadChunked(Callback && callback) const
+		{
+			SizeType total = 0;
+			for (;;)
+			{
+				SizeType count = 0;
+				Read(count);
+				if (count == 0) break;
+				for (SizeType i = 0; i < count; ++i)
+				{
+					T readValue = {};
+					Read(readValue);
+					callback(std::move(readValue));
+				}
+				total += count;
+			}
+			return total;
+		}
+
 	protected:
 		// Write
 		template <typename Type> void Write(const Type & value)
 		{
-			assert(stream);
+			assert(stream.IsSuccess());
 
 			// --
 			if constexpr (std::is_arithmetic_v<Type>)
@@ -60,7 +217,12 @@ namespace Grafkit::Serializer
 			// ---
 			else if constexpr (Traits::is_pointer_like_v<Type>)
 			{
-				Dynamics::Instance().Store(*this, value);
+				// Dynamics dispatches on the type-erased adapter only
+				if (parallelOptions.subtrees) { WriteSubtree(value); }
+				else
+				{
+					WithTypeErased(*this, [&](auto & adapter) { Dynamics::Instance().Store(adapter, value); });
+				}
 			}
 
 			// --- Wired-in std::string (and any other string-based type) support
@@ -71,7 +233,15 @@ namespace Grafkit::Serializer
 				constexpr auto charSize = sizeof(CharType);
 				const auto length = static_cast<SizeType>(value.length() + 1);
 				Write(length);
-				stream.Write(value.c_str(), charSize * length);
+				WriteBorrowed(value.c_str(), charSize * length);
+			}
+
+			// --- Bit containers are packed into words
+			else if constexpr (Traits::is_bool_vector_v<Type> || Traits::is_bitset_v<Type>)
+			{
+				const auto count = static_cast<SizeType>(value.size());
+				Write(count);
+				WriteBitWords(value.size(), [&](const size_t i) { return bool(value[i]); });
 			}
 
 			// --- STL-like container support
@@ -80,6 +250,38 @@ namespace Grafkit::Serializer
 				static_assert(Traits::has_size_v<Type> != 0);
 				const auto count = static_cast<SizeType>(value.size());
 				Write(count);
+
+				using ElemType = std::decay_t<decltype(*std::begin(value))>;
+				if constexpr (Utils::SequenceCodecs::is_codec_element_v<ElemType>)
+				{
+					if (sequenceCodecPolicy != SequenceCodecPolicy::Off)
+					{
+						if constexpr (Traits::has_contiguous_data_v<Type>) { WriteCodedSequence(value.data(), value.size()); }
+						else
+						{
+							// The codecs work on arrays, other containers are gathered into one first
+							const std::vector<ElemType> values(std::begin(value), std::end(value));
+							WriteCodedSequence(values.data(), values.size());
+						}
+						return;
+					}
+				}
+
+				if constexpr (Traits::has_contiguous_data_v<Type> && isBulkElement<ElemType>)
+				{
+					WriteBorrowed(reinterpret_cast<const char *>(value.data()), value.size() * sizeof(ElemType));
+					return;
+				}
+
+				if constexpr (isParallelContainer<Type>)
+				{
+					if (UseParallel(value.size()))
+					{
+						WriteParallel(value);
+						return;
+					}
+				}
+
 				for (const auto & elem : value)
 				{
 					Write(elem);
@@ -99,10 +301,25 @@ namespace Grafkit::Serializer
 
 				constexpr auto members =
 					refl::util::filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_readable(member); });
-				refl::util::for_each(members, [&](auto member) {
-					const auto & memberValue = member(value);
-					Write(memberValue);
-				});
+
+				PackedBools packedBools;
+				if constexpr (Traits::is_sparse_v<Type>)
+				{
+					PresenceBits<members.size> presence = {};
+					refl::util::for_each(members, [&](auto member, const size_t index) {
+						if (!IsDefaultValue(member, value)) SetPresent<members.size>(presence, index);
+					});
+					stream.Write(reinterpret_cast<const char *>(presence.data()), presence.size());
+
+					refl::util::for_each(members, [&](auto member, const size_t index) {
+						if (IsPresent<members.size>(presence, index)) WriteMember(member, value, packedBools);
+					});
+				}
+				else
+				{
+					refl::util::for_each(members, [&](auto member) { WriteMember(member, value, packedBools); });
+				}
+				FlushBools(packedBools);
 			}
 			else
 			{
@@ -122,7 +339,11 @@ namespace Grafkit::Serializer
 		{
 			const auto length = static_cast<SizeType>(N);
 			Write(length);
-			for (const auto & item : value) Write(item);
+			if constexpr (isBulkElement<T>) { WriteBorrowed(reinterpret_cast<const char *>(value.data()), N * sizeof(T)); }
+			else
+			{
+				for (const auto & item : value) Write(item);
+			}
 		}
 
 		// --------------------------------------------------------
@@ -130,15 +351,14 @@ namespace Grafkit::Serializer
 		// Read
 		template <typename Type> void Read(Type & value) const
 		{
-			assert(stream);
+			assert(stream.IsSuccess());
 
 			// ---
 			if constexpr (std::is_arithmetic_v<Type>)
 			{
-				const auto lastPos = static_cast<std::istream &>(stream).tellg();
 				Type readValue = {};
 				stream.Read((char *)(&readValue), sizeof(Type)); // TODO This part is dangerous
-				if (!stream.IsSuccess()) throw std::runtime_error("malformed data - lastPos: " + std::to_string(lastPos));
+				if (!stream.IsSuccess()) throw std::runtime_error("malformed data - unexpected end of stream");
 				value = Swap(readValue);
 			}
 			else if constexpr (std::is_enum_v<Type>)
@@ -151,7 +371,11 @@ namespace Grafkit::Serializer
 			// ---
 			else if constexpr (Traits::is_pointer_like_v<Type>)
 			{
-				Dynamics::Instance().Load(*this, value);
+				if (parallelOptions.subtrees) { DecodeSubtree(ReadSubtree(), value); }
+				else
+				{
+					WithTypeErased(*this, [&](const auto & adapter) { Dynamics::Instance().Load(adapter, value); });
+				}
 			}
 
 			// -- Wired-in std::string support
@@ -165,22 +389,60 @@ namespace Grafkit::Serializer
 
 				if (length > 0)
 				{
+					// Straight into the string; it grows as the data arrives, so a bogus length runs out of stream before memory
 					value.clear();
-					CharType buffer[StringBufferSize];
-					SizeType toRead = length * sizeof(CharType);
-					while (toRead != 0)
+					SizeType remaining = length;
+					while (remaining != 0)
 					{
-						const auto readLength = std::min(toRead, static_cast<SizeType>(sizeof(buffer)));
-						stream.Read(buffer, readLength);
-
-						value += std::string(buffer, readLength);
-						toRead -= readLength;
+						const auto offset = value.size();
+						const auto readLength = std::min(remaining, static_cast<SizeType>(std::max<size_t>(StringBufferSize, offset)));
+						value.resize(offset + static_cast<size_t>(readLength));
+						stream.Read(reinterpret_cast<char *>(value.data() + offset), static_cast<size_t>(readLength * sizeof(CharType)));
+						if (!stream.IsSuccess()) throw std::runtime_error("malformed data - string length");
+						remaining -= readLength;
 					}
 					// remove  trailing zero we stored, but don't need
 					value.pop_back();
+
+					if constexpr (std::is_same_v<Type, std::string>) Utils::Utf8::Validate(value, utf8Validation);
 				}
 			}
 
+			// Sorted vector map is built in bulk
+			else if constexpr (Traits::is_flat_map_v<Type>)
+			{
+				SizeType count = 0;
+				Read(count);
+
+				// The reserve is capped, so a corrupt count runs out of stream before it runs out of memory
+				typename Type::storage_type values;
+				values.reserve(static_cast<size_t>(std::min<SizeType>(count, BulkReadChunkSize / sizeof(typename Type::value_type))));
+				for (SizeType i = 0; i < count; ++i)
+				{
+					typename Type::value_type readValue = {};
+					Read(readValue);
+					values.push_back(std::move(readValue));
+				}
+				value.Assign(std::move(values));
+			}
+
+			// Bit containers are packed into words
+			else if constexpr (Traits::is_bool_vector_v<Type>)
+			{
+				SizeType count = 0;
+				Read(count);
+				// Appended as the words arrive, so a corrupt count runs out of stream before it runs out of memory
+				value.clear();
+				ReadBitWords(static_cast<size_t>(count), [&](const size_t, const bool bit) { value.push_back(bit); });
+			}
+			else if constexpr (Traits::is_bitset_v<Type>)
+			{
+				SizeType count = 0;
+				Read(count);
+				if (count != value.size()) throw std::runtime_error("Bitset size does not match");
+				ReadBitWords(value.size(), [&](const size_t i, const bool bit) { value[i] = bit; });
+			}
+
 			// STL-like container support
 			else if constexpr (Traits::is_iterable_v<Type>)
 			{
@@ -189,24 +451,48 @@ namespace Grafkit::Serializer
 				SizeType count = 0;
 				Read(count);
 
-				using ValueType = typename Type::value_type;
-
 				// TODO: assert if has value type
 				using ValueType = typename Type::value_type;
-				for (SizeType i = 0; i < count; ++i)
+
+				if constexpr (Utils::SequenceCodecs::is_codec_element_v<ValueType>)
 				{
-					ValueType readValue = {};
-					Read(readValue);
+					if (sequenceCodecPolicy != SequenceCodecPolicy::Off)
+					{
+						for (auto & elem : ReadCodedSequence<ValueType>(count)) InsertElement(value, std::move(elem));
+						return;
+					}
+				}
+
+				if constexpr (Traits::has_contiguous_data_v<Type> && Traits::has_resize_v<Type> && isBulkElement<ValueType>)
+				{
+					ReadBulk(value, count);
+					return;
+				}
 
-					if constexpr (Traits::has_push_back_v<Type, ValueType>)
+				if constexpr (isParallelContainer<Type>)
+				{
+					if (UseParallel(count))
 					{
-						value.push_back(std::move(readValue));
+						ReadParallel(value, count);
+						return;
 					}
-					else if constexpr (Traits::has_insert_v<Type, ValueType>)
+				}
+
+				if constexpr (Traits::is_pointer_like_v<ValueType>)
+				{
+					if (parallelOptions.subtrees)
 					{
-						value.insert(std::move(readValue));
+						ReadSubtrees(value, count);
+						return;
 					}
 				}
+
+				for (SizeType i = 0; i < count; ++i)
+				{
+					ValueType readValue = {};
+					Read(readValue);
+					InsertElement(value, std::move(readValue));
+				}
 			}
 			else if constexpr (Traits::is_pair_v<Type>)
 			{
@@ -241,22 +527,87 @@ namespace Grafkit::Serializer
 				}
 				constexpr auto members =
 					refl::util::filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_writable(member); });
-				refl::util::for_each(members, [&](auto member) {
+
+				PresenceBits<members.size> presence = {};
+				if constexpr (Traits::is_sparse_v<Type>)
+				{
+					stream.Read(reinterpret_cast<char *>(presence.data()), presence.size());
+					if (!stream.IsSuccess()) throw std::runtime_error("malformed data");
+				}
+
+				PackedBools packedBools;
+				// Pointer members in the subtree format are decoded side by side once all members are read; setters of pointer properties run after that
+				std::vector<std::function<void()>> subtrees;
+				std::vector<std::function<void()>> setters;
+				refl::util::for_each(members, [&](auto member, const size_t index) {
 					using DescriptorType = decltype(member);
 
+					if constexpr (Traits::is_sparse_v<Type>)
+					{
+						if (!IsPresent<members.size>(presence, index))
+						{
+							SetDefaultValue(member, value);
+							return;
+						}
+					}
+
 					if constexpr (Traits::is_serializable_field(member))
 					{
 						auto & memberValue = member(value);
-						Read(memberValue);
+						using MemberType = std::decay_t<decltype(memberValue)>;
+						if constexpr (Utils::Encoding::has_encoding(member))
+						{
+							packedBools.count = 0;
+							Utils::Encoding::Decode(member, memberValue, [&](auto & wire) { Read(wire); });
+						}
+						else if constexpr (std::is_same_v<MemberType, bool>) { memberValue = ReadPackedBool(packedBools); }
+						else if constexpr (Traits::is_pointer_like_v<MemberType>)
+						{
+							packedBools.count = 0;
+							if (parallelOptions.subtrees)
+							{
+								subtrees.emplace_back([this, &memberValue, blob = ReadSubtree()] { DecodeSubtree(blob, memberValue); });
+							}
+							else
+							{
+								Read(memberValue);
+							}
+						}
+						else
+						{
+							packedBools.count = 0;
+							Read(memberValue);
+						}
 					}
 					else if constexpr (Traits::is_serializable_setter(member))
 					{
 						using SetterType = Traits::SetterTypeFromDescriptor<DescriptorType>;
+						if constexpr (Traits::is_pointer_like_v<SetterType>)
+						{
+							packedBools.count = 0;
+							if (parallelOptions.subtrees)
+							{
+								// The setter is called once the subtree is complete
+								auto slot = std::make_shared<SetterType>();
+								subtrees.emplace_back([this, slot, blob = ReadSubtree()] { DecodeSubtree(blob, *slot); });
+								setters.emplace_back([&value, member, slot] { member(value, std::move(*slot)); });
+								return;
+							}
+						}
+
 						SetterType memberValue;
-						Read(memberValue);
+						if constexpr (std::is_same_v<SetterType, bool>) { memberValue = ReadPackedBool(packedBools); }
+						else
+						{
+							packedBools.count = 0;
+							Read(memberValue);
+						}
 						member(value, std::move(memberValue));
 					}
 				});
+
+				if (!subtrees.empty()) RunSubtrees(subtrees.size(), [&](const size_t i) { subtrees[i](); });
+				for (const auto & setter : setters) setter();
 			}
 			else
 			{
@@ -277,7 +628,326 @@ namespace Grafkit::Serializer
 			SizeType length = 0;
 			Read(length);
 			assert(length == N); // Todo: throw error
-			for (auto & item : value) Read(item);
+			if constexpr (isBulkElement<T>)
+			{
+				stream.Read(reinterpret_cast<char *>(value.data()), N * sizeof(T));
+				if (!stream.IsSuccess()) throw std::runtime_error("malformed data - unexpected end of stream");
+			}
+			else
+			{
+				for (auto & item : value) Read(item);
+			}
+		}
+
+		// --------------------------------------------------------
+		// Consecutive bool members of a reflectable type share bytes, up to 8 per byte, LSB first.
+		// A lone bool still takes a single 0/1 byte.
+
+		struct PackedBools
+		{
+			uint8_t bits = 0;
+			unsigned count = 0; // pending bits on write, remaining bits on read
+		};
+
+		void FlushBools(PackedBools & packed)
+		{
+			if (packed.count == 0) return;
+			Write(packed.bits);
+			packed = {};
+		}
+
+		bool ReadPackedBool(PackedBools & packed) const
+		{
+			if (packed.count == 0)
+			{
+				Read(packed.bits);
+				packed.count = 8;
+			}
+			const bool bit = packed.bits & 1u;
+			packed.bits >>= 1;
+			--packed.count;
+			return bit;
+		}
+
+		// Member of a reflectable type, with its wire encoding if there is any
+		template <typename Member, typename Type> void WriteMember(const Member member, const Type & value, PackedBools & packed)
+		{
+			const auto & memberValue = member(value);
+			using MemberType = std::decay_t<decltype(memberValue)>;
+			if constexpr (!Utils::Encoding::has_encoding(member) && std::is_same_v<MemberType, bool>)
+			{
+				if (memberValue) packed.bits |= static_cast<uint8_t>(1u << packed.count);
+				if (++packed.count == 8) FlushBools(packed);
+				return;
+			}
+			else
+			{
+				FlushBools(packed);
+				if constexpr (Utils::Encoding::has_encoding(member)) { Utils::Encoding::Encode(member, memberValue, [&](const auto wire) { Write(wire); }); }
+				else
+				{
+					Write(memberValue);
+					// A getter returning by value leaves a temporary, which must not stay borrowed by the stream
+					if constexpr (!std::is_reference_v<decltype(member(value))>) ReleaseBorrowed();
+				}
+			}
+		}
+
+		// --------------------------------------------------------
+		// Numbers that are stored the same way as in memory, so contiguous containers of them go as a single block
+
+		template <typename T>
+		static constexpr bool isBulkElement = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 1 || EndianSwapper::Endian::isLittle);
+
+		static constexpr size_t BulkReadChunkSize = 1 << 20;
+
+		// Appends count elements; grows the container chunk by chunk, so a corrupt count fails on the stream before allocating it all
+		template <typename Type> void ReadBulk(Type & container, const SizeType count) const
+		{
+			using ValueType = typename Type::value_type;
+			constexpr auto chunkElements = static_cast<SizeType>(std::max<size_t>(BulkReadChunkSize / sizeof(ValueType), 1));
+			for (SizeType done = 0; done < count;)
+			{
+				const auto take = std::min(count - done, chunkElements);
+				const auto offset = container.size();
+				container.resize(offset + static_cast<size_t>(take));
+				stream.Read(reinterpret_cast<char *>(container.data() + offset), static_cast<size_t>(take) * sizeof(ValueType));
+				if (!stream.IsSuccess()) throw std::runtime_error("malformed data - unexpected end of stream");
+				done += take;
+			}
+		}
+
+		// --------------------------------------------------------
+		// Parallel chunks
+
+		template <typename Type>
+		static constexpr bool isParallelContainer = Traits::has_contiguous_data_v<Type> && Traits::has_resize_v<Type> &&
+			!isBulkElement<typename Type::value_type> && std::is_default_constructible_v<typename Type::value_type>;
+
+		[[nodiscard]] bool UseParallel(const SizeType count) const { return parallelOptions.pool && count >= parallelOptions.minElements; }
+
+		// Element count of a chunk, the size of each chunk, then the chunks
+		template <typename Type> void WriteParallel(const Type & container)
+		{
+			const auto count = container.size();
+			const auto chunkElements = std::max<size_t>(parallelOptions.chunkElements, 1);
+			const auto chunkCount = (count + chunkElements - 1) / chunkElements;
+
+			std::vector<MemoryStream> chunks(chunkCount);
+			parallelOptions.pool->ParallelFor(chunkCount, [&](const size_t chunk) {
+				BasicBinaryAdapter<MemoryStream> adapter(chunks[chunk]);
+				adapter.SetSequenceCodecPolicy(sequenceCodecPolicy);
+				adapter.SetUtf8Validation(utf8Validation);
+				adapter.SetParallelOptions(parallelOptions);
+				const auto end = std::min(count, (chunk + 1) * chunkElements);
+				for (size_t i = chunk * chunkElements; i < end; ++i) adapter << container.data()[i];
+			});
+
+			Write(static_cast<SizeType>(chunkElements));
+			for (const auto & chunk : chunks) Write(static_cast<SizeType>(chunk.Size()));
+			for (const auto & chunk : chunks) WriteBorrowed(reinterpret_cast<const char *>(chunk.Data().data()), chunk.Size());
+			ReleaseBorrowed();
+		}
+
+		// Appends count elements, decoding the chunks straight into their place in the container
+		template <typename Type> void ReadParallel(Type & container, const SizeType count) const
+		{
+			SizeType chunkElements = 0;
+			Read(chunkElements);
+			if (chunkElements == 0) throw std::runtime_error("malformed data - chunk size");
+			const auto chunkCount = static_cast<size_t>((count + chunkElements - 1) / chunkElements);
+
+			std::vector<size_t> offsets(chunkCount + 1, 0);
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				SizeType size = 0;
+				Read(size);
+				offsets[i + 1] = offsets[i] + static_cast<size_t>(size);
+				if (offsets[i + 1] < offsets[i]) throw std::runtime_error("malformed data - chunk size");
+			}
+
+			std::vector<char> payload;
+			ReadBulk(payload, static_cast<SizeType>(offsets.back()));
+			// Every element takes at least one byte, a larger count is corrupt
+			if (count > offsets.back()) throw std::runtime_error("malformed data - element count");
+
+			const auto base = container.size();
+			container.resize(base + static_cast<size_t>(count));
+			parallelOptions.pool->ParallelFor(chunkCount, [&](const size_t chunk) {
+				SpanInputStream input(Span<const std::byte>(reinterpret_cast<const std::byte *>(payload.data()) + offsets[chunk], offsets[chunk + 1] - offsets[chunk]));
+				BasicBinaryAdapter<SpanInputStream> adapter(input);
+				adapter.SetSequenceCodecPolicy(sequenceCodecPolicy);
+				adapter.SetUtf8Validation(utf8Validation);
+				adapter.SetParallelOptions(parallelOptions);
+				const auto begin = chunk * static_cast<size_t>(chunkElements);
+				const auto end = std::min(static_cast<size_t>(count), begin + static_cast<size_t>(chunkElements));
+				for (size_t i = begin; i < end; ++i) adapter >> container.data()[base + i];
+				if (input.Remaining() != 0) throw std::runtime_error("malformed data - chunk size");
+			});
+		}
+
+		// --------------------------------------------------------
+		// Subtrees
+		// Every pointee goes into a buffer of its own and is written with its size in front,
+		// so the reader can collect sibling subtrees first and decode them side by side.
+
+		template <typename Type> void WriteSubtree(const Type & value)
+		{
+			MemoryStream buffer;
+			{
+				StreamRef<MemoryStream> bufferRef(buffer);
+				BasicBinaryAdapter<IStream> adapter(bufferRef);
+				adapter.SetSequenceCodecPolicy(sequenceCodecPolicy);
+				adapter.SetUtf8Validation(utf8Validation);
+				adapter.SetParallelOptions(parallelOptions);
+				Dynamics::Instance().Store(adapter, value);
+			}
+			Write(static_cast<SizeType>(buffer.Size()));
+			WriteBorrowed(reinterpret_cast<const char *>(buffer.Data().data()), buffer.Size());
+			ReleaseBorrowed();
+		}
+
+		// A subtree's bytes; only the outermost one is copied out of the stream, nested ones point into their parent
+		struct SubtreeBlob
+		{
+			std::vector<char> owned;
+			Span<const std::byte> view;
+
+			// Asked for on every use, a copied blob must not point into the vector of its source
+			[[nodiscard]] Span<const std::byte> Bytes() const
+			{
+				if (!owned.empty()) return Span<const std::byte>(reinterpret_cast<const std::byte *>(owned.data()), owned.size());
+				return view;
+			}
+		};
+
+		[[nodiscard]] SubtreeBlob ReadSubtree() const
+		{
+			SizeType size = 0;
+			Read(size);
+			SubtreeBlob blob;
+			SpanInputStream * input = subtreeInput;
+			if constexpr (std::is_same_v<StreamT, SpanInputStream>) input = &stream;
+			if (input)
+			{
+				blob.view = input->ReadView(size);
+				if (!input->IsSuccess()) throw std::runtime_error("malformed data - unexpected end of stream");
+			}
+			else
+			{
+				ReadBulk(blob.owned, size);
+			}
+			return blob;
+		}
+
+		template <typename Type> void DecodeSubtree(const SubtreeBlob & blob, Type & value) const
+		{
+			SpanInputStream input(blob.Bytes());
+			StreamRef<SpanInputStream> inputRef(input);
+			BasicBinaryAdapter<IStream> adapter(inputRef);
+			adapter.subtreeInput = &input;
+			adapter.SetSequenceCodecPolicy(sequenceCodecPolicy);
+			adapter.SetUtf8Validation(utf8Validation);
+			adapter.SetParallelOptions(parallelOptions);
+			Dynamics::Instance().Load(adapter, value);
+			if (input.Remaining() != 0) throw std::runtime_error("malformed data - subtree size");
+		}
+
+		// Appends count pointees, all of them decoded before any is inserted
+		template <typename Type> void ReadSubtrees(Type & container, const SizeType count) const
+		{
+			using ValueType = typename Type::value_type;
+
+			// Every subtree brings its size along, a bogus count runs out of stream before memory
+			std::vector<SubtreeBlob> blobs;
+			for (SizeType i = 0; i < count; ++i) blobs.push_back(ReadSubtree());
+
+			std::vector<ValueType> slots(blobs.size());
+			RunSubtrees(blobs.size(), [&](const size_t i) { DecodeSubtree(blobs[i], slots[i]); });
+			for (auto & slot : slots) InsertElement(container, std::move(slot));
+		}
+
+		void RunSubtrees(const size_t count, const std::function<void(size_t)> & body) const
+		{
+			if (parallelOptions.pool) { parallelOptions.pool->ParallelFor(count, body); }
+			else
+			{
+				for (size_t i = 0; i < count; ++i) body(i);
+			}
+		}
+
+		// Codec tag, then either plain elements, or the length and bytes of the encoded payload
+		template <typename T> void WriteCodedSequence(const T * values, const size_t count)
+		{
+			using namespace Utils::SequenceCodecs;
+			auto codec = Choose(values, count, sequenceCodecPolicy);
+			std::vector<uint8_t> payload;
+			if (codec != ECodec::Raw && !Encode(codec, values, count, payload)) codec = ECodec::Raw;
+
+			Write(static_cast<uint8_t>(codec));
+			if (codec == ECodec::Raw)
+			{
+				for (size_t i = 0; i < count; ++i) Write(values[i]);
+				return;
+			}
+			Write(static_cast<SizeType>(payload.size()));
+			stream.Write(reinterpret_cast<const char *>(payload.data()), payload.size());
+		}
+
+		template <typename T> std::vector<T> ReadCodedSequence(const SizeType count) const
+		{
+			using namespace Utils::SequenceCodecs;
+			uint8_t tag = 0;
+			Read(tag);
+			const auto codec = static_cast<ECodec>(tag);
+
+			std::vector<T> values;
+			if (codec == ECodec::Raw)
+			{
+				values.reserve(static_cast<size_t>(std::min<SizeType>(count, BulkReadChunkSize / sizeof(T))));
+				for (SizeType i = 0; i < count; ++i)
+				{
+					T readValue = {};
+					Read(readValue);
+					values.push_back(readValue);
+				}
+				return values;
+			}
+
+			// Neither size is trusted: the payload arrives in chunks, and the count has to fit in it before the values are allocated
+			SizeType payloadSize = 0;
+			Read(payloadSize);
+			std::vector<uint8_t> payload;
+			ReadBulk(payload, payloadSize);
+			CheckCount<T>(codec, payload.data(), payload.size(), static_cast<size_t>(count));
+
+			values.resize(static_cast<size_t>(count));
+			Decode(codec, payload.data(), payload.size(), values.data(), values.size());
+			return values;
+		}
+
+		// Bit containers go in 64 bit words, LSB first
+		template <typename BitAt> void WriteBitWords(const size_t bitCount, BitAt && bitAt)
+		{
+			for (size_t offset = 0; offset < bitCount; offset += 64)
+			{
+				const size_t end = std::min(bitCount, offset + 64);
+				uint64_t word = 0;
+				for (size_t i = offset; i < end; ++i)
+					if (bitAt(i)) word |= uint64_t(1) << (i - offset);
+				Write(word);
+			}
+		}
+
+		template <typename SetBit> void ReadBitWords(const size_t bitCount, SetBit && setBit) const
+		{
+			for (size_t offset = 0; offset < bitCount; offset += 64)
+			{
+				uint64_t word = 0;
+				Read(word);
+				const size_t end = std::min(bitCount, offset + 64);
+				for (size_t i = offset; i < end; ++i) setBit(i, (word >> (i - offset)) & 1u);
+			}
 		}
 
 	private:
@@ -285,7 +955,54 @@ namespace Grafkit::Serializer
 
 		template <class T>[[nodiscard]] T Swap(const T & v) const { return EndianSwapper::SwapByte<T, sizeof(T)>::Swap(v); }
 
-		IStream & stream;
+		// --------------------------------------------------------
+		// Optional parts of the stream concept
+
+		void WriteBorrowed(const char * buffer, const size_t length)
+		{
+			if constexpr (Traits::has_write_borrowed_v<StreamT>) { stream.WriteBorrowed(buffer, length); }
+			else
+			{
+				stream.Write(buffer, length);
+			}
+		}
+
+		void ReleaseBorrowed()
+		{
+			if constexpr (Traits::has_write_borrowed_v<StreamT>) stream.ReleaseBorrowed();
+		}
+
+		// Calls back with a type-erased adapter over the same stream, with the same settings
+		template <typename Self, typename Callback> static void WithTypeErased(Self & self, Callback && callback)
+		{
+			if constexpr (std::is_same_v<StreamT, IStream>) { callback(self); }
+			else if constexpr (std::is_base_of_v<IStream, StreamT>)
+			{
+				BasicBinaryAdapter<IStream> adapter(static_cast<IStream &>(self.stream));
+				adapter.SetSequenceCodecPolicy(self.sequenceCodecPolicy);
+				adapter.SetUtf8Validation(self.utf8Validation);
+				adapter.SetParallelOptions(self.parallelOptions);
+				callback(adapter);
+			}
+			else
+			{
+				StreamRef<StreamT> streamRef(self.stream);
+				BasicBinaryAdapter<IStream> adapter(streamRef);
+				adapter.SetSequenceCodecPolicy(self.sequenceCodecPolicy);
+				adapter.SetUtf8Validation(self.utf8Validation);
+				adapter.SetParallelOptions(self.parallelOptions);
+				callback(adapter);
+			}
+		}
+
+		StreamT & stream;
+		SequenceCodecPolicy sequenceCodecPolicy = SequenceCodecPolicy::Off;
+		Utf8Validation utf8Validation = Utf8Validation::Off;
+		ParallelOptions parallelOptions;
+		// Set when stream reads from an in-memory subtree, so nested subtrees can be decoded in place
+		SpanInputStream * subtreeInput = nullptr;
+
+		template <class> friend class BasicBinaryAdapter;
 
 		// ---
 		// SizeType has to be compatible, but not equal to size_t
@@ -294,3 +1011,90 @@ namespace Grafkit::Serializer
 	};
 
 } // namespace Grafkit::Serializer
+
+namespace Grafkit
+{
+	// --- Convenience entry points of the binary serializer
+
+	// Serialized size of a value in bytes
+	template <typename T> size_t SerializedSize(const T & value)
+	{
+		CountingStream counter;
+		Serializer::BasicBinaryAdapter<CountingStream> adapter(counter);
+		adapter << value;
+		return counter.Count();
+	}
+
+	// Serializes into a buffer of the exact size: one counting pass, one allocation, one writing pass
+	template <typename T> std::vector<std::byte> ToBytes(const T & value)
+	{
+		std::vector<std::byte> bytes(Grafkit::SerializedSize(value));
+		SpanOutputStream stream{Span<std::byte>(bytes)};
+		Serializer::BasicBinaryAdapter<SpanOutputStream> adapter(stream);
+		adapter << value;
+		return bytes;
+	}
+
+	// Serializes into a caller provided buffer; returns the bytes written, throws if it does not fit
+	template <typename T> size_t ToBytes(const T & value, const Span<std::byte> buffer)
+	{
+		SpanOutputStream stream(buffer);
+		Serializer::BasicBinaryAdapter<SpanOutputStream> adapter(stream);
+		adapter << value;
+		return stream.Position();
+	}
+
+	template <typename T> void FromBytes(const Span<const std::byte> bytes, T & value)
+	{
+		SpanInputStream stream(bytes);
+		const Serializer::BasicBinaryAdapter<SpanInputStream> adapter(stream);
+		adapter >> value;
+	}
+
+	template <typename T> T FromBytes(const Span<const std::byte> bytes)
+	{
+		T value{};
+		FromBytes(bytes, value);
+		return value;
+	}
+
+	// --- Batches of independent messages, encoded and decoded on a thread pool
+
+	/**
+	 * Serializes every value into a buffer of its own, same bytes as ToBytes of each.
+	 * A block of messages shares one scratch stream, so a message costs a single serializing pass and a copy of exact size.
+	 */
+	template <typename T> std::vector<std::vector<std::byte>> SerializeBatch(const Span<const T> values, ThreadPool & pool = ThreadPool::Default())
+	{
+		std::vector<std::vector<std::byte>> messages(values.size());
+		const auto blockSize = Detail::BatchBlockSize(values.size(), pool);
+		pool.ParallelFor((values.size() + blockSize - 1) / blockSize, [&](const size_t block) {
+			MemoryStream scratch;
+			const auto end = std::min(values.size(), (block + 1) * blockSize);
+			for (size_t i = block * blockSize; i < end; ++i)
+			{
+				scratch.Clear();
+				Serializer::BasicBinaryAdapter<MemoryStream> adapter(scratch);
+				adapter << values[i];
+				messages[i].assign(scratch.Data().begin(), scratch.Data().end());
+			}
+		});
+		return messages;
+	}
+
+	/**
+	 * Decodes a batch of messages, e.g. the buffers of SerializeBatch; every element of messages has to convert to Span<const std::byte>.
+	 * Rethrows the first error of any message.
+	 */
+	template <typename T, typename Messages> std::vector<T> DeserializeBatch(const Messages & messages, ThreadPool & pool = ThreadPool::Default())
+	{
+		std::vector<T> values(messages.size());
+		const auto blockSize = Detail::BatchBlockSize(values.size(), pool);
+		pool.ParallelFor((values.size() + blockSize - 1) / blockSize, [&](const size_t block) {
+			const auto end = std::min(values.size(), (block + 1) * blockSize);
+			for (size_t i = block * blockSize; i < end; ++i) FromBytes(Span<const std::byte>(messages[i]), values[i]);
+		});
+		return values;
+	}
+
+} // namespace Grafkit
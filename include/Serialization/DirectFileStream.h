@@ -0,0 +1,73 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+//
+#include <Serialization/Stream.h>
+
+namespace Grafkit
+{
+	enum class EFileMode
+	{
+		Read,
+		Write,
+	};
+
+	struct DirectFileOptions
+	{
+		size_t blockSize = 1 << 20; // rounded up to the page size
+		size_t queueDepth = 4;      // blocks in flight
+		bool directIo = false;      // O_DIRECT: bypass the page cache; falls back to buffered I/O where the file system does not support it
+		bool useIoUring = true;     // falls back to pread / pwrite where io_uring is not available
+	};
+
+	/**
+	 * Linux file stream with aligned, page-sized blocks, submitted through io_uring.
+	 * Up to queueDepth blocks are written behind or read ahead of the one the adapter works on.
+	 * With directIo the page cache is bypassed, so multi-GB archives do not evict other data.
+	 */
+	class DirectFileStream final : public IStream
+	{
+	public:
+		DirectFileStream(const std::string & path, EFileMode mode, const DirectFileOptions & options = {});
+		~DirectFileStream() noexcept override;
+
+		DirectFileStream(const DirectFileStream &) = delete;
+		DirectFileStream & operator=(const DirectFileStream &) = delete;
+
+		void Read(char * const & buffer, size_t length) override;
+		void Write(const char * buffer, size_t length) override;
+		[[nodiscard]] bool IsSuccess() const override { return mSuccess; }
+
+		[[nodiscard]] bool ReadAll(StreamData & outBuffer) override;
+
+		explicit operator std::istream &() const override { throw std::runtime_error("DirectFileStream is not an std::istream"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("DirectFileStream is not an std::ostream"); }
+
+		// Writes out the pending blocks and closes the file; throws on I/O errors. Called by the destructor as well.
+		void Close();
+
+		[[nodiscard]] bool UsesIoUring() const { return mIoUring; }
+		[[nodiscard]] bool UsesDirectIo() const { return mDirectIo; }
+
+	private:
+		struct Impl;
+
+		// Moves on to the next block and waits for it to be read; false at the end of the file
+		bool NextReadBlock();
+		void SubmitWriteBlock(size_t length);
+
+		std::unique_ptr<Impl> mImpl;
+		EFileMode mMode;
+		bool mIoUring = false;
+		bool mDirectIo = false;
+		bool mSuccess = true;
+		bool mClosed = false;
+	};
+
+} // namespace Grafkit
+
+#endif
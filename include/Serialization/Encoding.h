@@ -0,0 +1,436 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+//
+#include <refl.h>
+//
+#include <Serialization/Crc32.h>
+#include <Serialization/Traits.h>
+
+/**
+ * Per-field wire encodings
+ * Attach one of the attributes next to Serializable() in REFL_FIELD to store a floating point field (or every floating point
+ * component of an std::array or reflectable struct field) in a lossy, compact form:
+ *
+ * REFL_FIELD(position, Serializable(), Quantized(-1000.f, 1000.f, 16))
+ * REFL_FIELD(normal, Serializable(), Octahedral(12))
+ */
+
+namespace Grafkit
+{
+	namespace Attributes
+	{
+		/**
+		 * Maps [min, max] linearly onto an unsigned integer of `bits` width (1..32); values outside are clamped
+		 */
+		struct Quantized : refl::attr::usage::field
+		{
+			const float min;
+			const float max;
+			const unsigned bits;
+
+			constexpr Quantized(const float minValue, const float maxValue, const unsigned bitCount) noexcept : min(minValue), max(maxValue), bits(bitCount) {}
+		};
+
+		/**
+		 * IEEE 754 half precision
+		 */
+		struct HalfFloat : refl::attr::usage::field
+		{
+		};
+
+		/**
+		 * Signed 32 bit fixed point with `fractionBits` fractional bits
+		 */
+		struct FixedPoint : refl::attr::usage::field
+		{
+			const unsigned fractionBits;
+
+			constexpr explicit FixedPoint(const unsigned fractionBitCount) noexcept : fractionBits(fractionBitCount) {}
+		};
+
+		/**
+		 * Octahedral mapping of normalized 3D vectors (x, y, z members or std::array of 3), two components of `bits` width (1..16)
+		 */
+		struct Octahedral : refl::attr::usage::field
+		{
+			const unsigned bits;
+
+			constexpr explicit Octahedral(const unsigned bitCount = 16) noexcept : bits(bitCount) {}
+		};
+
+	} // namespace Attributes
+
+	namespace Traits
+	{
+		/**
+		 * Has x, y, z members
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct has_xyz : std::false_type
+		{
+		};
+
+		template <typename T> struct has_xyz<T, std::void_t<decltype(std::declval<T>().x), decltype(std::declval<T>().y), decltype(std::declval<T>().z)>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool has_xyz_v = has_xyz<T>::value;
+
+		/**
+		 * Is std::array
+		 * @tparam T
+		 */
+		template <typename T> struct is_std_array : std::false_type
+		{
+		};
+
+		template <typename T, size_t N> struct is_std_array<std::array<T, N>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool is_std_array_v = is_std_array<T>::value;
+
+	} // namespace Traits
+
+	namespace Utils::Encoding
+	{
+		// --- Scalar codecs
+
+		inline uint16_t FloatToHalf(const float value)
+		{
+			uint32_t f = 0;
+			std::memcpy(&f, &value, sizeof(f));
+
+			const auto sign = static_cast<uint16_t>((f >> 16) & 0x8000u);
+			const uint32_t floatExponent = (f >> 23) & 0xffu;
+			uint32_t mantissa = f & 0x007fffffu;
+
+			if (floatExponent == 0xffu) return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u)); // inf, nan
+
+			const int32_t exponent = static_cast<int32_t>(floatExponent) - 127 + 15;
+			if (exponent >= 0x1f) return static_cast<uint16_t>(sign | 0x7c00u); // overflow
+			if (exponent <= 0)
+			{
+				// subnormal, or underflow to zero
+				if (exponent < -10) return sign;
+				mantissa |= 0x00800000u;
+				const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+				uint32_t half = mantissa >> shift;
+				const uint32_t remainder = mantissa & ((1u << shift) - 1);
+				const uint32_t halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (half & 1u))) ++half;
+				return static_cast<uint16_t>(sign | half);
+			}
+
+			// Round to nearest even; a carry out of the mantissa correctly bumps the exponent
+			uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+			const uint32_t remainder = mantissa & 0x1fffu;
+			if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) ++half;
+			return static_cast<uint16_t>(sign | half);
+		}
+
+		inline float HalfToFloat(const uint16_t half)
+		{
+			const uint32_t sign = (half & 0x8000u) << 16;
+			uint32_t exponent = (half >> 10) & 0x1fu;
+			uint32_t mantissa = half & 0x3ffu;
+
+			uint32_t f = 0;
+			if (exponent == 0)
+			{
+				if (mantissa == 0) { f = sign; }
+				else
+				{
+					// Normalize subnormal
+					exponent = 127 - 15 + 1;
+					while (!(mantissa & 0x400u))
+					{
+						mantissa <<= 1;
+						--exponent;
+					}
+					f = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+				}
+			}
+			else if (exponent == 0x1f) { f = sign | 0x7f800000u | (mantissa << 13); }
+			else
+			{
+				f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+			}
+
+			float value = 0.f;
+			std::memcpy(&value, &f, sizeof(value));
+			return value;
+		}
+
+		inline uint32_t Quantize(const double value, const double min, const double max, const unsigned bits)
+		{
+			const double steps = static_cast<double>((static_cast<uint64_t>(1) << bits) - 1);
+			double t = max > min ? (value - min) / (max - min) : 0.;
+			if (!(t > 0.)) t = 0.; // also catches nan
+			if (t > 1.) t = 1.;
+			return static_cast<uint32_t>(std::llround(t * steps));
+		}
+
+		inline double Dequantize(const uint32_t value, const double min, const double max, const unsigned bits)
+		{
+			const double steps = static_cast<double>((static_cast<uint64_t>(1) << bits) - 1);
+			return min + (max - min) * (static_cast<double>(value) / steps);
+		}
+
+		inline int32_t ToFixedPoint(const double value, const unsigned fractionBits)
+		{
+			const double scaled = std::ldexp(value, static_cast<int>(fractionBits));
+			if (!(scaled == scaled)) return 0;
+			return static_cast<int32_t>(std::clamp(scaled, static_cast<double>(INT32_MIN), static_cast<double>(INT32_MAX)));
+		}
+
+		inline double FromFixedPoint(const int32_t value, const unsigned fractionBits) { return std::ldexp(static_cast<double>(value), -static_cast<int>(fractionBits)); }
+
+		// Maps a direction onto the [-1, 1] square
+		inline std::array<double, 2> OctahedralEncode(double x, double y, double z)
+		{
+			const double l1 = std::abs(x) + std::abs(y) + std::abs(z);
+			if (l1 == 0.) return {0., 0.};
+			x /= l1, y /= l1, z /= l1;
+			if (z >= 0.) return {x, y};
+			return {(1. - std::abs(y)) * (x >= 0. ? 1. : -1.), (1. - std::abs(x)) * (y >= 0. ? 1. : -1.)};
+		}
+
+		inline std::array<double, 3> OctahedralDecode(const double u, const double v)
+		{
+			double x = u, y = v;
+			const double z = 1. - std::abs(u) - std::abs(v);
+			if (z < 0.)
+			{
+				x = (1. - std::abs(v)) * (u >= 0. ? 1. : -1.);
+				y = (1. - std::abs(u)) * (v >= 0. ? 1. : -1.);
+			}
+			const double length = std::sqrt(x * x + y * y + z * z);
+			return {x / length, y / length, z / length};
+		}
+
+		// --- Wire types
+
+		template <unsigned Bits> using QuantizedWireType = std::conditional_t<(Bits <= 8), uint8_t, std::conditional_t<(Bits <= 16), uint16_t, uint32_t>>;
+
+		// --- Member level
+
+		template <typename Member> static constexpr bool has_encoding(const Member & member)
+		{
+			using namespace Attributes;
+			return refl::descriptor::has_attribute<Quantized>(member) || refl::descriptor::has_attribute<HalfFloat>(member) ||
+				refl::descriptor::has_attribute<FixedPoint>(member) || refl::descriptor::has_attribute<Octahedral>(member);
+		}
+
+		// Scalar values use a single wire value, everything else (vectors, structs) a list of them
+		template <typename T> static constexpr bool is_scalar_encoding_v = std::is_floating_point_v<T>;
+
+		namespace Impl
+		{
+			// Invokes fn for every floating point component of value, in serialization order
+			template <typename T, typename Fn> void ForEachComponent(T & value, Fn && fn)
+			{
+				using Type = std::remove_const_t<T>;
+				if constexpr (std::is_floating_point_v<Type>) { fn(value); }
+				else if constexpr (Traits::is_std_array_v<Type> || std::is_array_v<Type>)
+				{
+					for (auto & elem : value) ForEachComponent(elem, fn);
+				}
+				else if constexpr (refl::trait::is_reflectable_v<Type>)
+				{
+					constexpr auto members = filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_field(member); });
+					refl::util::for_each(members, [&](auto member) { ForEachComponent(member(value), fn); });
+				}
+				else
+				{
+					static_assert(std::is_floating_point_v<Type>, "Encoding attributes apply to floating point values, arrays or structs of them");
+				}
+			}
+
+			template <typename T> std::array<double, 3> GetXyz(const T & value)
+			{
+				if constexpr (Traits::has_xyz_v<T>) { return {static_cast<double>(value.x), static_cast<double>(value.y), static_cast<double>(value.z)}; }
+				else
+				{
+					static_assert(Traits::is_std_array_v<T> && std::tuple_size<T>::value == 3, "Octahedral encoding needs x, y, z members or std::array of 3");
+					return {static_cast<double>(value[0]), static_cast<double>(value[1]), static_cast<double>(value[2])};
+				}
+			}
+
+			template <typename T> void SetXyz(T & value, const std::array<double, 3> & xyz)
+			{
+				if constexpr (Traits::has_xyz_v<T>)
+				{
+					value.x = static_cast<decltype(value.x)>(xyz[0]);
+					value.y = static_cast<decltype(value.y)>(xyz[1]);
+					value.z = static_cast<decltype(value.z)>(xyz[2]);
+				}
+				else
+				{
+					for (size_t i = 0; i < 3; ++i) value[i] = static_cast<typename T::value_type>(xyz[i]);
+				}
+			}
+
+			template <unsigned long long N> static constexpr auto DigitsString()
+			{
+				if constexpr (N < 10) { return refl::make_const_string(static_cast<char>('0' + N)); }
+				else
+				{
+					return DigitsString<N / 10>() + refl::make_const_string(static_cast<char>('0' + N % 10));
+				}
+			}
+
+			// Decimal form of an integer
+			template <long long N> static constexpr auto NumberString()
+			{
+				if constexpr (N < 0) { return refl::make_const_string('-') + DigitsString<0ull - static_cast<unsigned long long>(N)>(); }
+				else
+				{
+					return DigitsString<static_cast<unsigned long long>(N)>();
+				}
+			}
+
+			// Float parameters are fingerprinted with 6 decimal digits; out of range values saturate, nan counts as zero
+			static constexpr long long FloatFingerprint(const float number)
+			{
+				const double scaled = static_cast<double>(number) * 1000000.;
+				if (!(scaled == scaled)) return 0;
+				if (scaled >= static_cast<double>(std::numeric_limits<long long>::max())) return std::numeric_limits<long long>::max();
+				if (scaled <= static_cast<double>(std::numeric_limits<long long>::min())) return std::numeric_limits<long long>::min();
+				return static_cast<long long>(scaled);
+			}
+
+		} // namespace Impl
+
+		/**
+		 * Encodes the member value and passes every resulting wire value to emit, in order
+		 */
+		template <typename Member, typename T, typename Emit> void Encode(const Member member, const T & value, Emit && emit)
+		{
+			using namespace Attributes;
+			if constexpr (refl::descriptor::has_attribute<Quantized>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<Quantized>(member);
+				static_assert(attribute.bits >= 1 && attribute.bits <= 32);
+				using WireType = QuantizedWireType<attribute.bits>;
+				Impl::ForEachComponent(value, [&](const auto & component) {
+					emit(static_cast<WireType>(Quantize(static_cast<double>(component), attribute.min, attribute.max, attribute.bits)));
+				});
+			}
+			else if constexpr (refl::descriptor::has_attribute<HalfFloat>(member))
+			{
+				Impl::ForEachComponent(value, [&](const auto & component) { emit(FloatToHalf(static_cast<float>(component))); });
+			}
+			else if constexpr (refl::descriptor::has_attribute<FixedPoint>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<FixedPoint>(member);
+				static_assert(attribute.fractionBits < 32);
+				Impl::ForEachComponent(value, [&](const auto & component) { emit(ToFixedPoint(static_cast<double>(component), attribute.fractionBits)); });
+			}
+			else if constexpr (refl::descriptor::has_attribute<Octahedral>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<Octahedral>(member);
+				static_assert(attribute.bits >= 1 && attribute.bits <= 16);
+				using WireType = QuantizedWireType<attribute.bits>;
+				const auto xyz = Impl::GetXyz(value);
+				const auto uv = OctahedralEncode(xyz[0], xyz[1], xyz[2]);
+				emit(static_cast<WireType>(Quantize(uv[0], -1., 1., attribute.bits)));
+				emit(static_cast<WireType>(Quantize(uv[1], -1., 1., attribute.bits)));
+			}
+		}
+
+		/**
+		 * Decodes the member value; fetch is called with a reference to every wire value to be filled, in order
+		 */
+		template <typename Member, typename T, typename Fetch> void Decode(const Member member, T & value, Fetch && fetch)
+		{
+			using namespace Attributes;
+			if constexpr (refl::descriptor::has_attribute<Quantized>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<Quantized>(member);
+				using WireType = QuantizedWireType<attribute.bits>;
+				Impl::ForEachComponent(value, [&](auto & component) {
+					WireType wire = 0;
+					fetch(wire);
+					component = static_cast<std::remove_reference_t<decltype(component)>>(Dequantize(wire, attribute.min, attribute.max, attribute.bits));
+				});
+			}
+			else if constexpr (refl::descriptor::has_attribute<HalfFloat>(member))
+			{
+				Impl::ForEachComponent(value, [&](auto & component) {
+					uint16_t wire = 0;
+					fetch(wire);
+					component = static_cast<std::remove_reference_t<decltype(component)>>(HalfToFloat(wire));
+				});
+			}
+			else if constexpr (refl::descriptor::has_attribute<FixedPoint>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<FixedPoint>(member);
+				Impl::ForEachComponent(value, [&](auto & component) {
+					int32_t wire = 0;
+					fetch(wire);
+					component = static_cast<std::remove_reference_t<decltype(component)>>(FromFixedPoint(wire, attribute.fractionBits));
+				});
+			}
+			else if constexpr (refl::descriptor::has_attribute<Octahedral>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<Octahedral>(member);
+				using WireType = QuantizedWireType<attribute.bits>;
+				WireType u = 0, v = 0;
+				fetch(u);
+				fetch(v);
+				Impl::SetXyz(value, OctahedralDecode(Dequantize(u, -1., 1., attribute.bits), Dequantize(v, -1., 1., attribute.bits)));
+			}
+		}
+
+		/**
+		 * Signature suffix of the member encoding, an empty string if there is none
+		 */
+		template <typename Member> static constexpr auto CalcString(const Member member)
+		{
+			using namespace Attributes;
+			using Impl::NumberString;
+			if constexpr (refl::descriptor::has_attribute<Quantized>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<Quantized>(member);
+				return refl::make_const_string(":quantized(") + NumberString<Impl::FloatFingerprint(attribute.min)>() + refl::make_const_string(',') +
+					NumberString<Impl::FloatFingerprint(attribute.max)>() + refl::make_const_string(',') + NumberString<attribute.bits>() + refl::make_const_string(')');
+			}
+			else if constexpr (refl::descriptor::has_attribute<HalfFloat>(member))
+			{
+				return refl::make_const_string(":half");
+			}
+			else if constexpr (refl::descriptor::has_attribute<FixedPoint>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<FixedPoint>(member);
+				return refl::make_const_string(":fixed(") + NumberString<attribute.fractionBits>() + refl::make_const_string(')');
+			}
+			else if constexpr (refl::descriptor::has_attribute<Octahedral>(member))
+			{
+				constexpr auto attribute = refl::descriptor::get_attribute<Octahedral>(member);
+				return refl::make_const_string(":octahedral(") + NumberString<attribute.bits>() + refl::make_const_string(')');
+			}
+			else
+			{
+				return refl::make_const_string();
+			}
+		}
+
+		/**
+		 * Fingerprint of the member encoding, an empty checksum if there is none
+		 */
+		template <typename Member> static constexpr Checksum CalcChecksum(const Member member)
+		{
+			constexpr auto string = CalcString(member);
+			return Checksum(string.data, string.size);
+		}
+
+	} // namespace Utils::Encoding
+} // namespace Grafkit
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+//
+#include <Serialization/Stream.h>
+
+namespace Grafkit
+{
+	/**
+	 * Unit of work handed from stage to stage. Blocks are moved along, never copied;
+	 * a stage transforms the data in place or swaps in a buffer of its own (e.g. compressed output).
+	 */
+	struct FilterBlock
+	{
+		std::vector<char> data;
+		bool last = false; // final block of the stream, may be empty; stages may append trailers to it
+	};
+
+	class IFilterStage
+	{
+	public:
+		virtual ~IFilterStage() = default;
+		virtual void Process(FilterBlock & block) = 0;
+	};
+
+	struct FilterPipelineOptions
+	{
+		size_t blockSize = 256 << 10;
+		bool parallel = false; // every stage on a thread of its own, and one more writing to the sink
+		size_t queueDepth = 2; // blocks waiting in front of each stage in parallel mode
+	};
+
+	/**
+	 * Output stream running everything written through a chain of stages (checksums, compression, encryption, rate limiting, ...)
+	 * before it reaches the sink. Adapters write to it like to any IStream.
+	 * Writes are cut into fixed-size blocks; in parallel mode the stages work on consecutive blocks at the same time, and
+	 * a fixed set of blocks circulates, so a slow stage holds back the writer instead of piling up memory.
+	 */
+	class FilterPipeline final : public IStream
+	{
+	public:
+		explicit FilterPipeline(IStream & sink, const FilterPipelineOptions & options = {});
+		~FilterPipeline() noexcept override;
+
+		FilterPipeline(const FilterPipeline &) = delete;
+		FilterPipeline & operator=(const FilterPipeline &) = delete;
+
+		// Stages run in the order they are added; add all of them before the first write
+		void AddStage(std::unique_ptr<IFilterStage> stage);
+
+		template <class Stage, class... Args> Stage & Emplace(Args &&... args)
+		{
+			auto stage = std::make_unique<Stage>(std::forward<Args>(args)...);
+			auto & result = *stage;
+			AddStage(std::move(stage));
+			return result;
+		}
+
+		void Read(char * const &, size_t) override { throw std::runtime_error("Can't read from a FilterPipeline"); }
+		void Write(const char * buffer, size_t length) override;
+		[[nodiscard]] bool IsSuccess() const override { return !mFailed; }
+
+		[[nodiscard]] bool ReadAll(StreamData &) override { throw std::runtime_error("Can't read from a FilterPipeline"); }
+
+		explicit operator std::istream &() const override { throw std::runtime_error("Can't read from a FilterPipeline"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("FilterPipeline is not an std::ostream"); }
+
+		/**
+		 * Sends the last block through all the stages and waits until the sink got everything.
+		 * Rethrows the first error of any stage or of the sink. Does not close the sink.
+		 */
+		void Close();
+
+	private:
+		class BlockQueue;
+
+		void Start();
+		void Dispatch();
+		void RunStage(size_t index);
+		void RunSink();
+		void Fail(std::exception_ptr error);
+		void RethrowError();
+
+		IStream & mSink;
+		FilterPipelineOptions mOptions;
+		std::vector<std::unique_ptr<IFilterStage>> mStages;
+
+		FilterBlock mCurrent;
+		bool mStarted = false;
+		bool mClosed = false;
+		std::atomic<bool> mFailed{false};
+
+		// Parallel mode: queues[i] feeds stage i, the last one the sink; free blocks return to the writer
+		std::vector<std::unique_ptr<BlockQueue>> mQueues;
+		std::unique_ptr<BlockQueue> mFreeBlocks;
+		std::vector<std::thread> mThreads;
+
+		std::mutex mErrorMutex;
+		std::exception_ptr mError;
+	};
+
+	// --- Stages
+
+	/**
+	 * Standard CRC-32 (as zlib, PNG, ...) of everything passing through; optionally appended to the stream, little-endian
+	 */
+	class Crc32Stage final : public IFilterStage
+	{
+	public:
+		explicit Crc32Stage(const bool appendToStream = false) : mAppend(appendToStream) {}
+
+		void Process(FilterBlock & block) override;
+
+		// Final once the pipeline is closed
+		[[nodiscard]] uint32_t Value() const { return ~mState; }
+
+		static uint32_t Update(uint32_t crc, const char * data, size_t length);
+
+	private:
+		bool mAppend;
+		uint32_t mState = 0xffffffff;
+	};
+
+	/**
+	 * Hook for transformations living elsewhere, such as compression or encryption
+	 */
+	class TransformStage final : public IFilterStage
+	{
+	public:
+		explicit TransformStage(std::function<void(FilterBlock &)> transform) : mTransform(std::move(transform)) {}
+		void Process(FilterBlock & block) override { mTransform(block); }
+
+	private:
+		std::function<void(FilterBlock &)> mTransform;
+	};
+
+	/**
+	 * Holds blocks back so that no more than bytesPerSecond pass on average
+	 */
+	class RateLimitStage final : public IFilterStage
+	{
+	public:
+		explicit RateLimitStage(double bytesPerSecond) : mBytesPerSecond(bytesPerSecond) {}
+		void Process(FilterBlock & block) override;
+
+	private:
+		double mBytesPerSecond;
+		uint64_t mBytes = 0;
+		std::chrono::steady_clock::time_point mStart;
+	};
+
+} // namespace Grafkit
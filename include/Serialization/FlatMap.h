@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Grafkit
+{
+
+	/**
+	 * Associative container over a sorted std::vector.
+	 * Lookups are binary searches over contiguous storage, and bulk construction costs one sort at most,
+	 * none at all when the input is already sorted (which is always the case for data written from an ordered container).
+	 * @tparam Key
+	 * @tparam Value
+	 * @tparam Compare
+	 */
+	template <typename Key, typename Value, typename Compare = std::less<Key>> class FlatMap
+	{
+	public:
+		using key_type = Key;
+		using mapped_type = Value;
+		using value_type = std::pair<Key, Value>;
+		using key_compare = Compare;
+		using storage_type = std::vector<value_type>;
+		using size_type = typename storage_type::size_type;
+		using iterator = typename storage_type::iterator;
+		using const_iterator = typename storage_type::const_iterator;
+
+		FlatMap() = default;
+		FlatMap(std::initializer_list<value_type> init) { Assign(storage_type(init)); }
+
+		/**
+		 * Takes over the given elements as the new content.
+		 * Sorts only if the input is not sorted already; on duplicate keys the first occurrence wins, like std::map::insert.
+		 */
+		void Assign(storage_type && values)
+		{
+			mValues = std::move(values);
+			const auto keyLess = [](const value_type & a, const value_type & b) { return Compare{}(a.first, b.first); };
+			if (!std::is_sorted(mValues.begin(), mValues.end(), keyLess)) { std::stable_sort(mValues.begin(), mValues.end(), keyLess); }
+			const auto keyEqual = [&keyLess](const value_type & a, const value_type & b) { return !keyLess(a, b) && !keyLess(b, a); };
+			mValues.erase(std::unique(mValues.begin(), mValues.end(), keyEqual), mValues.end());
+		}
+
+		[[nodiscard]] const storage_type & Values() const { return mValues; }
+
+		iterator begin() { return mValues.begin(); }
+		iterator end() { return mValues.end(); }
+		const_iterator begin() const { return mValues.begin(); }
+		const_iterator end() const { return mValues.end(); }
+
+		[[nodiscard]] size_type size() const { return mValues.size(); }
+		[[nodiscard]] bool empty() const { return mValues.empty(); }
+		void clear() { mValues.clear(); }
+		void reserve(size_type count) { mValues.reserve(count); }
+
+		iterator lower_bound(const Key & key) { return std::lower_bound(mValues.begin(), mValues.end(), key, KeyLess{}); }
+		const_iterator lower_bound(const Key & key) const { return std::lower_bound(mValues.begin(), mValues.end(), key, KeyLess{}); }
+
+		iterator find(const Key & key)
+		{
+			const auto it = lower_bound(key);
+			return it != mValues.end() && !Compare{}(key, it->first) ? it : mValues.end();
+		}
+
+		const_iterator find(const Key & key) const
+		{
+			const auto it = lower_bound(key);
+			return it != mValues.end() && !Compare{}(key, it->first) ? it : mValues.end();
+		}
+
+		[[nodiscard]] size_type count(const Key & key) const { return find(key) != end() ? 1 : 0; }
+
+		Value & at(const Key & key)
+		{
+			const auto it = find(key);
+			if (it == end()) throw std::out_of_range("FlatMap::at");
+			return it->second;
+		}
+
+		const Value & at(const Key & key) const
+		{
+			const auto it = find(key);
+			if (it == end()) throw std::out_of_range("FlatMap::at");
+			return it->second;
+		}
+
+		Value & operator[](const Key & key) { return insert(value_type(key, Value{})).first->second; }
+
+		// Note: Single inserts are O(n), use Assign() for bulk loads
+		std::pair<iterator, bool> insert(const value_type & value) { return insert(value_type(value)); }
+
+		std::pair<iterator, bool> insert(value_type && value)
+		{
+			const auto it = lower_bound(value.first);
+			if (it != mValues.end() && !Compare{}(value.first, it->first)) return {it, false};
+			return {mValues.insert(it, std::move(value)), true};
+		}
+
+		iterator erase(const_iterator it) { return mValues.erase(it); }
+
+		bool operator==(const FlatMap & rhs) const { return mValues == rhs.mValues; }
+		bool operator!=(const FlatMap & rhs) const { return !(rhs == *this); }
+
+	private:
+		struct KeyLess
+		{
+			bool operator()(const value_type & a, const Key & b) const { return Compare{}(a.first, b); }
+		};
+
+		storage_type mValues;
+	};
+
+	namespace Traits
+	{
+		/**
+		 * Is FlatMap
+		 * @tparam T
+		 */
+		template <typename T> struct is_flat_map : std::false_type
+		{
+		};
+
+		template <typename K, typename V, typename C> struct is_flat_map<FlatMap<K, V, C>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool is_flat_map_v = is_flat_map<T>::value;
+
+	} // namespace Traits
+
+} // namespace Grafkit
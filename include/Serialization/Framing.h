@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+//
+#include <Serialization/Binary.h>
+#include <Serialization/MemoryStream.h>
+#include <Serialization/Span.h>
+
+namespace Grafkit::Framing
+{
+	/**
+	 * Length-delimited messages for pipes and sockets.
+	 * A frame is a 32 bit little-endian payload length followed by the binary serialized value.
+	 * Encode and decode buffers come from a per-thread pool and keep their capacity,
+	 * so once warmed up, sending and receiving messages does not allocate.
+	 */
+
+	using LengthType = uint32_t;
+	static constexpr size_t HeaderSize = sizeof(LengthType);
+	static constexpr size_t DefaultMaxFrameSize = 64 << 20;
+
+	namespace Detail
+	{
+		inline void StoreLength(std::byte * target, const LengthType length)
+		{
+			for (size_t i = 0; i < HeaderSize; ++i) target[i] = static_cast<std::byte>((length >> (8 * i)) & 0xff);
+		}
+
+		inline LengthType LoadLength(const std::byte * source)
+		{
+			LengthType length = 0;
+			for (size_t i = 0; i < HeaderSize; ++i) length |= static_cast<LengthType>(source[i]) << (8 * i);
+			return length;
+		}
+
+		inline void CheckLength(const size_t length, const size_t maxFrameSize)
+		{
+			if (length > maxFrameSize) throw std::runtime_error("Frame exceeds the maximum frame size");
+		}
+
+		/**
+		 * Borrows a byte buffer from the calling thread's pool and gives it back, capacity intact, on destruction.
+		 * A pool rather than a single buffer, so a frame can be encoded while another one is in use on the same thread.
+		 */
+		class BufferLease
+		{
+		public:
+			BufferLease()
+			{
+				auto & pool = Pool();
+				if (!pool.empty())
+				{
+					mBuffer = std::move(pool.back());
+					pool.pop_back();
+				}
+				mBuffer.clear();
+			}
+
+			~BufferLease() noexcept
+			{
+				try
+				{
+					Pool().push_back(std::move(mBuffer));
+				}
+				catch (...)
+				{
+				}
+			}
+
+			BufferLease(const BufferLease &) = delete;
+			BufferLease & operator=(const BufferLease &) = delete;
+
+			std::vector<std::byte> & Buffer() { return mBuffer; }
+
+		private:
+			static std::vector<std::vector<std::byte>> & Pool()
+			{
+				thread_local std::vector<std::vector<std::byte>> pool;
+				return pool;
+			}
+
+			std::vector<std::byte> mBuffer;
+		};
+
+		// Gives the buffer of an encoding stream back to its lease when leaving the scope, also when unwinding
+		class LeaseReturn
+		{
+		public:
+			LeaseReturn(BufferLease & lease, MemoryStream & memory) : mLease(lease), mMemory(memory) {}
+			~LeaseReturn() noexcept { mLease.Buffer() = mMemory.Release(); }
+
+			LeaseReturn(const LeaseReturn &) = delete;
+			LeaseReturn & operator=(const LeaseReturn &) = delete;
+
+		private:
+			BufferLease & mLease;
+			MemoryStream & mMemory;
+		};
+
+		// Decodes a whole payload; bytes left over mean the frame does not hold a T
+		template <typename T> void DecodePayload(const Span<const std::byte> payload, T & value)
+		{
+			SpanInputStream stream(payload);
+			const Serializer::BasicBinaryAdapter<SpanInputStream> adapter(stream);
+			adapter >> value;
+			if (stream.Remaining() != 0) throw std::runtime_error("malformed data - frame length");
+		}
+	} // namespace Detail
+
+	/**
+	 * Serializes a value into a pooled buffer, then hands header and payload to the stream in a single write
+	 * @return size of the frame in bytes, header included
+	 */
+	template <typename T, typename StreamT> size_t WriteFrame(StreamT & stream, const T & value, const size_t maxFrameSize = DefaultMaxFrameSize)
+	{
+		static_assert(Traits::is_stream_v<StreamT>, "StreamT has to model the stream concept");
+
+		Detail::BufferLease lease;
+		{
+			MemoryStream memory(std::move(lease.Buffer()));
+			const Detail::LeaseReturn leaseReturn(lease, memory);
+			const std::byte header[HeaderSize] = {};
+			memory.Write(reinterpret_cast<const char *>(header), HeaderSize);
+
+			Serializer::BasicBinaryAdapter<MemoryStream> adapter(memory);
+			adapter << value;
+		}
+
+		auto & frame = lease.Buffer();
+		const auto length = frame.size() - HeaderSize;
+		Detail::CheckLength(length, maxFrameSize);
+		Detail::StoreLength(frame.data(), static_cast<LengthType>(length));
+
+		stream.Write(reinterpret_cast<const char *>(frame.data()), frame.size());
+		if (!stream.IsSuccess()) throw std::runtime_error("Failed to write frame");
+		return frame.size();
+	}
+
+	/**
+	 * Frames a batch of values on a thread pool; the stream gets the same bytes as from WriteFrame for each value, in order.
+	 * Consecutive frames are encoded into a shared buffer per block, and each block goes to the stream in a single write.
+	 * @return size of all frames in bytes
+	 */
+	template <typename T, typename StreamT>
+	size_t WriteFrames(StreamT & stream, const Span<const T> values, ThreadPool & pool = ThreadPool::Default(), const size_t maxFrameSize = DefaultMaxFrameSize)
+	{
+		static_assert(Traits::is_stream_v<StreamT>, "StreamT has to model the stream concept");
+
+		const auto blockSize = Grafkit::Detail::BatchBlockSize(values.size(), pool);
+		std::vector<MemoryStream> blocks((values.size() + blockSize - 1) / blockSize);
+		pool.ParallelFor(blocks.size(), [&](const size_t block) {
+			auto & memory = blocks[block];
+			const auto end = std::min(values.size(), (block + 1) * blockSize);
+			for (size_t i = block * blockSize; i < end; ++i)
+			{
+				const auto start = memory.Size();
+				const std::byte header[HeaderSize] = {};
+				memory.Write(reinterpret_cast<const char *>(header), HeaderSize);
+
+				Serializer::BasicBinaryAdapter<MemoryStream> adapter(memory);
+				adapter << values[i];
+
+				const auto length = memory.Size() - start - HeaderSize;
+				Detail::CheckLength(length, maxFrameSize);
+				Detail::StoreLength(memory.Data().data() + start, static_cast<LengthType>(length));
+			}
+		});
+
+		size_t total = 0;
+		for (const auto & block : blocks)
+		{
+			stream.Write(reinterpret_cast<const char *>(block.Data().data()), block.Size());
+			if (!stream.IsSuccess()) throw std::runtime_error("Failed to write frame");
+			total += block.Size();
+		}
+		return total;
+	}
+
+	/**
+	 * Decodes every frame of a buffer on a thread pool; the buffer has to end with a complete frame.
+	 * Frame boundaries are found first, which only takes the headers, then the payloads are decoded side by side.
+	 */
+	template <typename T>
+	std::vector<T> DecodeFrames(const Span<const std::byte> bytes, ThreadPool & pool = ThreadPool::Default(), const size_t maxFrameSize = DefaultMaxFrameSize)
+	{
+		std::vector<Span<const std::byte>> payloads;
+		for (size_t offset = 0; offset < bytes.size();)
+		{
+			if (bytes.size() - offset < HeaderSize) throw std::runtime_error("malformed data - truncated frame");
+			const auto length = Detail::LoadLength(bytes.data() + offset);
+			Detail::CheckLength(length, maxFrameSize);
+			if (bytes.size() - offset - HeaderSize < length) throw std::runtime_error("malformed data - truncated frame");
+			payloads.push_back(bytes.subspan(offset + HeaderSize, length));
+			offset += HeaderSize + length;
+		}
+		return DeserializeBatch<T>(payloads, pool);
+	}
+
+	/**
+	 * Pulls complete frames from a blocking stream
+	 */
+	template <typename StreamT> class FrameReader
+	{
+		static_assert(Traits::is_stream_v<StreamT>, "StreamT has to model the stream concept");
+
+	public:
+		explicit FrameReader(StreamT & stream, const size_t maxFrameSize = DefaultMaxFrameSize) : mStream(stream), mMaxFrameSize(maxFrameSize) {}
+
+		/**
+		 * Reads the next frame into value, which is reset first since the adapter appends to containers
+		 * @return false if the stream ended before a new frame; throws if it ends inside one
+		 */
+		template <typename T> bool Next(T & value)
+		{
+			// The first byte tells a clean end of the stream from one that stops within the header
+			std::byte header[HeaderSize];
+			mStream.Read(reinterpret_cast<char *>(header), 1);
+			if (!mStream.IsSuccess()) return false;
+			mStream.Read(reinterpret_cast<char *>(header + 1), HeaderSize - 1);
+			if (!mStream.IsSuccess()) throw std::runtime_error("malformed data - truncated frame");
+
+			const auto length = Detail::LoadLength(header);
+			Detail::CheckLength(length, mMaxFrameSize);
+
+			Detail::BufferLease lease;
+			auto & payload = lease.Buffer();
+			payload.resize(length);
+			mStream.Read(reinterpret_cast<char *>(payload.data()), length);
+			if (!mStream.IsSuccess()) throw std::runtime_error("malformed data - truncated frame");
+
+			value = T{};
+			Detail::DecodePayload(Span<const std::byte>(payload), value);
+			return true;
+		}
+
+	private:
+		StreamT & mStream;
+		size_t mMaxFrameSize;
+	};
+
+	/**
+	 * Incremental decoder for non-blocking sockets: feed it whatever arrived, take out the frames that are complete.
+	 * Partial frames stay in its buffer until the rest arrives.
+	 */
+	class FrameDecoder
+	{
+	public:
+		explicit FrameDecoder(const size_t maxFrameSize = DefaultMaxFrameSize) : mMaxFrameSize(maxFrameSize) {}
+
+		void Feed(const Span<const std::byte> bytes)
+		{
+			// Move the unread tail to the front before growing
+			if (mStart > 0 && mBuffer.size() + bytes.size() > mBuffer.capacity())
+			{
+				mBuffer.erase(mBuffer.begin(), mBuffer.begin() + static_cast<std::ptrdiff_t>(mStart));
+				mStart = 0;
+			}
+			mBuffer.insert(mBuffer.end(), bytes.begin(), bytes.end());
+		}
+
+		/**
+		 * Decodes the next complete frame into value, which is reset first
+		 * @return false if no complete frame is buffered yet
+		 */
+		template <typename T> bool Next(T & value)
+		{
+			const auto available = mBuffer.size() - mStart;
+			if (available < HeaderSize) return false;
+
+			const auto length = Detail::LoadLength(mBuffer.data() + mStart);
+			Detail::CheckLength(length, mMaxFrameSize);
+			if (available - HeaderSize < length) return false;
+
+			value = T{};
+			Detail::DecodePayload(Span<const std::byte>(mBuffer.data() + mStart + HeaderSize, length), value);
+			mStart += HeaderSize + length;
+			if (mStart == mBuffer.size())
+			{
+				mBuffer.clear();
+				mStart = 0;
+			}
+			return true;
+		}
+
+		// Bytes of incomplete frames
+		[[nodiscard]] size_t Pending() const { return mBuffer.size() - mStart; }
+
+	private:
+		std::vector<std::byte> mBuffer;
+		size_t mStart = 0;
+		size_t mMaxFrameSize;
+	};
+
+} // namespace Grafkit::Framing
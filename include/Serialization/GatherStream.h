@@ -0,0 +1,75 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+//
+#include <sys/uio.h>
+//
+#include <Serialization/Stream.h>
+
+namespace Grafkit
+{
+	struct GatherWriteOptions
+	{
+		size_t coalesceBufferSize = 64 * 1024; // small writes are copied together into this one
+		size_t borrowThreshold = 16 * 1024;    // borrowed buffers from this size on are referenced, not copied
+	};
+
+	/**
+	 * Output stream to a file descriptor through writev.
+	 * Small writes are coalesced into a buffer, large borrowed buffers (strings, byte vectors) only get an iovec entry pointing at them,
+	 * so they are never copied in user space. Everything pending goes out in a single writev call.
+	 */
+	class GatherWriteStream final : public IStream
+	{
+	public:
+		explicit GatherWriteStream(const std::string & path, const GatherWriteOptions & options = {});
+		// Does not take ownership of the descriptor
+		explicit GatherWriteStream(int fd, const GatherWriteOptions & options = {});
+		~GatherWriteStream() noexcept override;
+
+		GatherWriteStream(const GatherWriteStream &) = delete;
+		GatherWriteStream & operator=(const GatherWriteStream &) = delete;
+
+		void Read(char * const &, size_t) override { throw std::runtime_error("Can't read from a GatherWriteStream"); }
+		void Write(const char * buffer, size_t length) override;
+		[[nodiscard]] bool IsSuccess() const override { return mSuccess; }
+
+		void WriteBorrowed(const char * buffer, size_t length) override;
+		void ReleaseBorrowed() override;
+
+		[[nodiscard]] bool ReadAll(StreamData &) override { throw std::runtime_error("Can't read from a GatherWriteStream"); }
+
+		explicit operator std::istream &() const override { throw std::runtime_error("Can't read from a GatherWriteStream"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("GatherWriteStream is not an std::ostream"); }
+
+		// Writes out everything pending
+		void Flush();
+
+		[[nodiscard]] size_t CopiedBytes() const { return mCopiedBytes; }
+		[[nodiscard]] size_t BorrowedBytes() const { return mBorrowedBytes; }
+		[[nodiscard]] size_t WritevCalls() const { return mWritevCalls; }
+
+	private:
+		void Append(const char * buffer, size_t length);
+
+		GatherWriteOptions mOptions;
+		int mFd = -1;
+		bool mOwnsFd = false;
+		bool mSuccess = true;
+
+		std::vector<char> mBuffer; // never grows beyond its reserved size, the iovecs point into it
+		std::vector<iovec> mIovecs;
+		bool mHasBorrowed = false;
+
+		size_t mCopiedBytes = 0;
+		size_t mBorrowedBytes = 0;
+		size_t mWritevCalls = 0;
+	};
+
+} // namespace Grafkit
+
+#endif
@@ -5,9 +5,15 @@
 #include <nlohmann/json.hpp>
 #include <refl.h>
 //
+#include <Serialization/Base64.h>
+#include <Serialization/FlatMap.h>
+#include <Serialization/Encoding.h>
+#include <Serialization/JsonArena.h>
 #include <Serialization/SerializerBase.h>
 #include <Serialization/Signature.h>
 #include <Serialization/Stream.h>
+#include <Serialization/ThreadPool.h>
+#include <Serialization/Utf8.h>
 
 namespace Grafkit
 {
@@ -15,22 +21,35 @@ namespace Grafkit
 
 	namespace Serializer
 	{
-		class JsonAdapter : public SerializerBase
+		/**
+		 * JSON serializer over a DOM; JsonT is Json, or ArenaJson to have the nodes allocated from a JsonArena
+		 */
+		template <class JsonT> class BasicJsonAdapter : public SerializerBase
 		{
 		public:
-			explicit JsonAdapter(Json & json) : json(json) {}
-			explicit JsonAdapter(Json && json) : json(json) {}
+			explicit BasicJsonAdapter(JsonT & json) : json(json) {}
+			explicit BasicJsonAdapter(JsonT && json) : json(json) {}
 
-			static Json ParseJson(IStream & stream);
+			/**
+			 * The parser rejects invalid UTF-8 by itself; with EValidation::Replace invalid parts are replaced before parsing instead,
+			 * which takes a copy of the text only when there is something to replace.
+			 */
+			static JsonT ParseJson(IStream & stream, Utils::Utf8::EValidation validation = Utils::Utf8::EValidation::Strict);
 
-			static void DumpJson(IStream & stream, const Json & json);
+			static void DumpJson(IStream & stream, const JsonT & json);
 
-			template <class T> JsonAdapter & operator<<(const T & value)
+			/**
+			 * Same bytes as DumpJson. Top-level arrays of at least minElements elements are formatted on the pool,
+			 * in blocks of consecutive elements, and streamed out in order a wave of blocks at a time.
+			 */
+			static void DumpJson(IStream & stream, const JsonT & json, ThreadPool & pool, size_t minElements = 1 << 14);
+
+			template <class T> BasicJsonAdapter & operator<<(const T & value)
 			{
 				Write(value);
 				return *this;
 			}
-			template <class T> const JsonAdapter & operator>>(T & value) const
+			template <class T> const BasicJsonAdapter & operator>>(T & value) const
 			{
 				Read(value);
 				return *this;
@@ -51,7 +70,7 @@ namespace Grafkit
 
 			// ----------------------------------------------------------------------------
 
-			template <typename Type> void Write(const Type & value, Json & jsonNode)
+			template <typename Type> void Write(const Type & value, JsonT & jsonNode)
 			{
 				// --
 				if constexpr (std::is_arithmetic_v<Type> || Traits::is_string_type_v<Type>)
@@ -65,14 +84,25 @@ namespace Grafkit
 				// ---
 				else if constexpr (Traits::is_pointer_like_v<Type>)
 				{
-					JsonAdapter tmp(jsonNode);
+					BasicJsonAdapter tmp(jsonNode);
 					Dynamics::Instance().Store(tmp, value);
 				}
 
+				else if constexpr (Traits::is_bitset_v<Type>)
+				{
+					jsonNode = value.to_string();
+				}
+
+				// --- Byte containers are base64 text
+				else if constexpr (Traits::is_byte_vector_v<Type>)
+				{
+					jsonNode = Utils::Base64::EncodeBlob(value);
+				}
+
 				// --- STL-like container support
 				else if constexpr (Traits::is_iterable_v<Type>)
 				{
-					jsonNode = Json::array();
+					jsonNode = JsonT::array();
 					static_assert(Traits::has_size_v<Type>);
 					for (const auto & elem : value)
 					{
@@ -81,7 +111,7 @@ namespace Grafkit
 				}
 				else if constexpr (Traits::is_pair_v<Type>)
 				{
-					jsonNode = Json::array();
+					jsonNode = JsonT::array();
 					Write(value.first, jsonNode.emplace_back());
 					Write(value.second, jsonNode.emplace_back());
 				}
@@ -97,11 +127,21 @@ namespace Grafkit
 					constexpr auto members =
 						refl::util::filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_readable(member); });
 					refl::util::for_each(members, [&](auto member) {
+						if constexpr (Traits::is_sparse_v<Type>)
+						{
+							if (IsDefaultValue(member, value)) return;
+						}
+
 						if constexpr (Traits::is_serializable_field(member))
 						{
 							const auto & memberValue = member(value);
 							jsonNode[member.name.c_str()] = {};
-							Write(memberValue, jsonNode[member.name.c_str()]);
+							if constexpr (Utils::Encoding::has_encoding(member)) { WriteEncoded(member, memberValue, jsonNode[member.name.c_str()]); }
+							else if constexpr (Traits::is_blob(member)) { jsonNode[member.name.c_str()] = Utils::Base64::EncodeBlob(memberValue); }
+							else
+							{
+								Write(memberValue, jsonNode[member.name.c_str()]);
+							}
 						}
 						else if constexpr (Traits::is_serializable_getter(member))
 						{
@@ -118,9 +158,9 @@ namespace Grafkit
 				}
 			}
 
-			template <class Type, size_t N> void Write(const Type (&value)[N], Json & jsonNode)
+			template <class Type, size_t N> void Write(const Type (&value)[N], JsonT & jsonNode)
 			{
-				jsonNode = Json::array();
+				jsonNode = JsonT::array();
 				for (const auto & elem : value)
 				{
 					jsonNode.emplace_back();
@@ -128,9 +168,9 @@ namespace Grafkit
 				}
 			}
 
-			template <class Type, size_t N> void Write(const std::array<Type, N> & value, Json & jsonNode)
+			template <class Type, size_t N> void Write(const std::array<Type, N> & value, JsonT & jsonNode)
 			{
-				jsonNode = Json::array();
+				jsonNode = JsonT::array();
 				for (const auto & elem : value)
 				{
 					jsonNode.emplace_back();
@@ -141,30 +181,61 @@ namespace Grafkit
 			// ----------------------------------------------------------------------------
 
 			// ---
-			template <typename Type> void Read(Type & value, const Json & jsonNode) const
+			template <typename Type> void Read(Type & value, const JsonT & jsonNode) const
 			{
 				// ---
 				if constexpr (std::is_arithmetic_v<Type> || Traits::is_string_type_v<Type>)
 				{
-					value = jsonNode.get<Type>();
+					value = jsonNode.template get<Type>();
 				}
 				else if constexpr (std::is_enum_v<Type>)
 				{
-					value = static_cast<Type>(jsonNode.get<int>());
+					value = static_cast<Type>(jsonNode.template get<int>());
 				}
 
 				// ---
 				else if constexpr (Traits::is_pointer_like_v<Type>)
 				{
-					JsonAdapter tmp(const_cast<Json &>(jsonNode));
+					BasicJsonAdapter tmp(const_cast<JsonT &>(jsonNode));
 					Dynamics::Instance().Load(tmp, value);
 				}
 
+				else if constexpr (Traits::is_bitset_v<Type>)
+				{
+					value = Type(jsonNode.template get<std::string>());
+				}
+				else if constexpr (Traits::is_bool_vector_v<Type>)
+				{
+					value.resize(jsonNode.size());
+					for (size_t i = 0; i < value.size(); ++i) value[i] = jsonNode.at(i).template get<bool>();
+				}
+
+				// Sorted vector map is built in bulk
+				else if constexpr (Traits::is_flat_map_v<Type>)
+				{
+					const auto count = jsonNode.size();
+
+					typename Type::storage_type values;
+					values.reserve(count);
+					for (size_t i = 0; i < count; ++i)
+					{
+						typename Type::value_type readValue = {};
+						Read(readValue, jsonNode.at(i));
+						values.push_back(std::move(readValue));
+					}
+					value.Assign(std::move(values));
+				}
+
 				// STL-like container support
 				else if constexpr (Traits::is_iterable_v<Type>)
 				{
 					static_assert(Traits::has_size_v<Type>);
 
+					if constexpr (Traits::is_byte_vector_v<Type>)
+					{
+						if (jsonNode.is_string()) return ReadBlob(value, jsonNode);
+					}
+
 					const auto count = jsonNode.size();
 					using ValueType = typename Type::value_type;
 
@@ -175,14 +246,7 @@ namespace Grafkit
 						ValueType readValue = {};
 						Read(readValue, jsonNode.at(i));
 
-						if constexpr (Traits::has_push_back_v<Type, ValueType>)
-						{
-							value.push_back(std::move(readValue));
-						}
-						else if constexpr (Traits::has_insert_v<Type, ValueType>)
-						{
-							value.insert(std::move(readValue));
-						}
+						InsertElement(value, std::move(readValue));
 					}
 				}
 				else if constexpr (Traits::is_pair_v<Type>)
@@ -209,7 +273,7 @@ namespace Grafkit
 				else if constexpr (refl::trait::is_reflectable_v<Type>)
 				{
 					const auto checksum = Utils::Signature::CalcChecksum<Type>();
-					const Utils::Checksum readChecksum(jsonNode["_checksum"].get<Utils::Checksum::ChecksumType>());
+					const Utils::Checksum readChecksum(jsonNode["_checksum"].template get<Utils::Checksum::ChecksumType>());
 
 					if (checksum != readChecksum) throw std::runtime_error("Checksum does not match");
 
@@ -219,10 +283,24 @@ namespace Grafkit
 					refl::util::for_each(members, [&](auto member) {
 						typedef decltype(member) DescriptorType;
 
+						if constexpr (Traits::is_sparse_v<Type>)
+						{
+							if (!jsonNode.contains(refl::descriptor::get_display_name(member)))
+							{
+								SetDefaultValue(member, value);
+								return;
+							}
+						}
+
 						if constexpr (Traits::is_serializable_field(member))
 						{
 							auto & memberValue = member(value);
-							Read(memberValue, jsonNode[member.name.c_str()]);
+							if constexpr (Utils::Encoding::has_encoding(member)) { ReadEncoded(member, memberValue, jsonNode[member.name.c_str()]); }
+							else if constexpr (Traits::is_blob(member)) { ReadBlob(memberValue, jsonNode[member.name.c_str()]); }
+							else
+							{
+								Read(memberValue, jsonNode[member.name.c_str()]);
+							}
 						}
 						else if constexpr (Traits::is_serializable_setter(member))
 						{
@@ -239,7 +317,7 @@ namespace Grafkit
 				}
 			}
 
-			template <class T, size_t N> void Read(T (&value)[N], const Json & jsonNode) const
+			template <class T, size_t N> void Read(T (&value)[N], const JsonT & jsonNode) const
 			{
 				size_t i = 0;
 				for (auto & elem : value)
@@ -249,7 +327,7 @@ namespace Grafkit
 				}
 			}
 
-			template <class T, size_t N> void Read(std::array<T, N> & value, const Json & jsonNode) const
+			template <class T, size_t N> void Read(std::array<T, N> & value, const JsonT & jsonNode) const
 			{
 				size_t i = 0;
 				for (auto & elem : value)
@@ -259,9 +337,53 @@ namespace Grafkit
 				}
 			}
 
+			// ----------------------------------------------------------------------------
+			// Encoded fields are stored as their wire value, or as an array of wire values for vectors and structs
+
+			template <typename Member, typename Type> void WriteEncoded(const Member member, const Type & value, JsonT & jsonNode)
+			{
+				if constexpr (Utils::Encoding::is_scalar_encoding_v<Type>)
+				{
+					Utils::Encoding::Encode(member, value, [&](const auto wire) { jsonNode = wire; });
+				}
+				else
+				{
+					jsonNode = JsonT::array();
+					Utils::Encoding::Encode(member, value, [&](const auto wire) { jsonNode.push_back(wire); });
+				}
+			}
+
+			template <typename Member, typename Type> void ReadEncoded(const Member member, Type & value, const JsonT & jsonNode) const
+			{
+				if constexpr (Utils::Encoding::is_scalar_encoding_v<Type>)
+				{
+					Utils::Encoding::Decode(member, value, [&](auto & wire) { wire = jsonNode.template get<std::remove_reference_t<decltype(wire)>>(); });
+				}
+				else
+				{
+					size_t index = 0;
+					Utils::Encoding::Decode(member, value, [&](auto & wire) { wire = jsonNode.at(index++).template get<std::remove_reference_t<decltype(wire)>>(); });
+				}
+			}
+
+			// ----------------------------------------------------------------------------
+			// Blobs are base64 text; data written before that has them in the regular form
+
+			template <typename Type> void ReadBlob(Type & value, const JsonT & jsonNode) const
+			{
+				if (jsonNode.is_string())
+					Utils::Base64::DecodeBlob(jsonNode.template get_ref<const typename JsonT::string_t &>(), value);
+				else
+					Read(value, jsonNode);
+			}
+
 		private:
-			Json & json;
+			JsonT & json;
 		};
 
+		// ParseJson and DumpJson are compiled once, in Json.cpp
+		extern template class BasicJsonAdapter<Json>;
+		extern template class BasicJsonAdapter<ArenaJson>;
+
 	} // namespace Serializer
 } // namespace Grafkit
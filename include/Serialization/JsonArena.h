@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+//
+#include <Serialization/JsonFwd.h>
+
+namespace Grafkit
+{
+	/**
+	 * Monotonic arena for JSON DOMs: allocations are cut from blocks of growing size and never freed one by one,
+	 * all of the memory goes back at once when the arena is destroyed.
+	 * An arena is the current one of the thread that created it while it lives; ArenaAllocator takes its memory from there,
+	 * and from the heap when there is none. DOMs built in an arena have to be destroyed before the arena, on the same thread;
+	 * DOMs built without one have to be destroyed without one, as nothing is freed while an arena is current.
+	 */
+	class JsonArena
+	{
+	public:
+		explicit JsonArena(size_t initialBlockSize = 64 << 10);
+		~JsonArena() noexcept;
+
+		JsonArena(const JsonArena &) = delete;
+		JsonArena & operator=(const JsonArena &) = delete;
+
+		void * Allocate(size_t size, size_t alignment);
+		[[nodiscard]] bool Owns(const void * pointer) const;
+
+		[[nodiscard]] size_t BytesAllocated() const { return mAllocated; }
+		[[nodiscard]] size_t BytesReserved() const { return mReserved; }
+
+		// Innermost arena of the calling thread, or nullptr
+		static JsonArena * Current();
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> data;
+			size_t size = 0;
+		};
+
+		std::vector<Block> mBlocks;
+		size_t mUsed = 0; // of the last block
+		size_t mNextBlockSize;
+		size_t mAllocated = 0;
+		size_t mReserved = 0;
+		JsonArena * mPrevious;
+	};
+
+	/**
+	 * Stateless allocator on top of the current JsonArena, as basic_json creates its allocators on the fly.
+	 * Deallocating while an arena is current does nothing, the memory goes back with the blocks of the arena.
+	 */
+	template <typename T> class ArenaAllocator
+	{
+	public:
+		using value_type = T;
+
+		ArenaAllocator() noexcept = default;
+		template <typename U> ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+		T * allocate(const size_t count)
+		{
+			if (auto * arena = JsonArena::Current()) return static_cast<T *>(arena->Allocate(count * sizeof(T), alignof(T)));
+			return std::allocator<T>().allocate(count);
+		}
+
+		void deallocate(T * pointer, const size_t count) noexcept
+		{
+			if (JsonArena::Current()) return;
+			std::allocator<T>().deallocate(pointer, count);
+		}
+
+		template <typename U> bool operator==(const ArenaAllocator<U> &) const noexcept { return true; }
+		template <typename U> bool operator!=(const ArenaAllocator<U> &) const noexcept { return false; }
+	};
+
+} // namespace Grafkit
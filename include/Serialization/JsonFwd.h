@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+//
+#include <nlohmann/json_fwd.hpp>
+
+namespace Grafkit
+{
+	template <typename T> class ArenaAllocator;
+
+	// DOM whose nodes come from the current arena; long strings keep their text on the heap
+	using ArenaJson = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+} // namespace Grafkit
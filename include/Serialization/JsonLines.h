@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+//
+#include <Serialization/Json.h>
+#include <Serialization/MappedFile.h>
+#include <Serialization/Span.h>
+#include <Serialization/Stream.h>
+#include <Serialization/ThreadPool.h>
+
+namespace Grafkit::JsonLines
+{
+	/**
+	 * JSON Lines (NDJSON): every value is written as one compact JSON document followed by a newline.
+	 * Compact JSON never contains a raw newline, so the text can be cut at any newline and the parts parsed independently.
+	 */
+
+	// Parts smaller than this are not worth a task of their own
+	static constexpr size_t MinSegmentSize = 64 << 10;
+
+	template <typename T> std::string ToLine(const T & value)
+	{
+		Json json;
+		Serializer::JsonAdapter adapter(json);
+		adapter << value;
+		auto line = json.dump();
+		line.push_back('\n');
+		return line;
+	}
+
+	template <typename T, typename StreamT> void WriteLine(StreamT & stream, const T & value)
+	{
+		static_assert(Traits::is_stream_v<StreamT>, "StreamT has to model the stream concept");
+
+		const auto line = ToLine(value);
+		stream.Write(line.data(), line.size());
+		if (!stream.IsSuccess()) throw std::runtime_error("Failed to write line");
+	}
+
+	/**
+	 * Formats a batch of values on a thread pool; the stream gets the same bytes as from WriteLine for each value, in order
+	 */
+	template <typename T, typename StreamT> void WriteLines(StreamT & stream, const Span<const T> values, ThreadPool & pool = ThreadPool::Default())
+	{
+		static_assert(Traits::is_stream_v<StreamT>, "StreamT has to model the stream concept");
+
+		const auto blockSize = Grafkit::Detail::BatchBlockSize(values.size(), pool);
+		std::vector<std::string> blocks((values.size() + blockSize - 1) / blockSize);
+		pool.ParallelFor(blocks.size(), [&](const size_t block) {
+			const auto end = std::min(values.size(), (block + 1) * blockSize);
+			for (size_t i = block * blockSize; i < end; ++i) blocks[block] += ToLine(values[i]);
+		});
+
+		for (const auto & block : blocks)
+		{
+			stream.Write(block.data(), block.size());
+			if (!stream.IsSuccess()) throw std::runtime_error("Failed to write line");
+		}
+	}
+
+	/**
+	 * Parses JSON Lines text on a thread pool, in order. The text is cut into parts at newlines, a few parts per worker,
+	 * and each part is parsed line by line into a vector of its own. Blank lines are skipped, CRLF line ends are accepted.
+	 */
+	template <typename T> std::vector<T> ReadLines(const Span<const char> text, ThreadPool & pool = ThreadPool::Default())
+	{
+		const auto segmentCount = std::max<size_t>(std::min(pool.ThreadCount() * 4, text.size() / MinSegmentSize), 1);
+
+		std::vector<size_t> bounds = {0};
+		for (size_t i = 1; i < segmentCount; ++i)
+		{
+			const auto from = std::max(bounds.back(), text.size() / segmentCount * i);
+			const auto * newline = static_cast<const char *>(std::memchr(text.data() + from, '\n', text.size() - from));
+			const auto bound = newline ? static_cast<size_t>(newline - text.data()) + 1 : text.size();
+			if (bound > bounds.back() && bound < text.size()) bounds.push_back(bound);
+		}
+		bounds.push_back(text.size());
+
+		std::vector<std::vector<T>> parts(bounds.size() - 1);
+		pool.ParallelFor(parts.size(), [&](const size_t part) {
+			const auto * line = text.data() + bounds[part];
+			const auto * const end = text.data() + bounds[part + 1];
+			while (line < end)
+			{
+				const auto * newline = static_cast<const char *>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+				const auto * const lineEnd = newline ? newline : end;
+				if (std::any_of(line, lineEnd, [](const char c) { return c != ' ' && c != '\t' && c != '\r'; }))
+				{
+					auto json = Json::parse(line, lineEnd);
+					const Serializer::JsonAdapter adapter(json);
+					adapter >> parts[part].emplace_back();
+				}
+				if (lineEnd == end) break;
+				line = lineEnd + 1;
+			}
+		});
+
+		std::vector<T> values;
+		size_t count = 0;
+		for (const auto & part : parts) count += part.size();
+		values.reserve(count);
+		for (auto & part : parts) std::move(part.begin(), part.end(), std::back_inserter(values));
+		return values;
+	}
+
+	// Maps the file and parses it with ReadLines
+	template <typename T> std::vector<T> ReadFile(const std::string & path, ThreadPool & pool = ThreadPool::Default())
+	{
+		const MappedFile file(path);
+		return ReadLines<T>(file.Data(), pool);
+	}
+
+} // namespace Grafkit::JsonLines
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+//
+#include <refl.h>
+//
+#include <Serialization/Base64.h>
+#include <Serialization/Encoding.h>
+#include <Serialization/FlatMap.h>
+#include <Serialization/Json.h>
+#include <Serialization/SerializerBase.h>
+#include <Serialization/Utf8.h>
+
+namespace Grafkit
+{
+	enum class EJsonType
+	{
+		Object,
+		Array,
+		String,
+		Number,
+		Bool,
+		Null
+	};
+
+	class LazyJsonValue;
+
+	/**
+	 * JSON document which is indexed instead of parsed.
+	 * One pass over the text (64 bytes at a time with SIMD where available) finds the structural characters outside of strings,
+	 * the opening quotes, and the first characters of numbers and literals; a second one pairs up the brackets.
+	 * Values are parsed only when they are read, untouched subtrees are skipped in one step and stay raw text.
+	 * Beyond unbalanced brackets and unterminated strings, malformed input is only noticed in the values that are read.
+	 */
+	class LazyJsonDocument
+	{
+	public:
+		// The text has to outlive the document
+		explicit LazyJsonDocument(std::string_view text);
+		explicit LazyJsonDocument(std::string && text);
+
+		// Values refer to the document
+		LazyJsonDocument(const LazyJsonDocument &) = delete;
+		LazyJsonDocument & operator=(const LazyJsonDocument &) = delete;
+
+		[[nodiscard]] LazyJsonValue Root() const;
+		[[nodiscard]] std::string_view Text() const { return mText; }
+		[[nodiscard]] size_t StructuralCount() const { return mIndex.size(); }
+
+	private:
+		friend class LazyJsonValue;
+
+		void Build();
+
+		std::string mOwned;
+		std::string_view mText;
+		std::vector<uint32_t> mIndex; // text positions, in order
+		std::vector<uint32_t> mMatch; // for opening brackets, the index entry of the closing one
+	};
+
+	/**
+	 * Value in a LazyJsonDocument; a position in the index, cheap to copy
+	 */
+	class LazyJsonValue
+	{
+	public:
+		LazyJsonValue(const LazyJsonDocument & document, const uint32_t entry) : mDocument(&document), mEntry(entry) {}
+
+		[[nodiscard]] EJsonType Type() const;
+		// Text of the value, without surrounding whitespace
+		[[nodiscard]] std::string_view Raw() const;
+
+		// Member of an object, if there is one with this key
+		[[nodiscard]] std::optional<LazyJsonValue> Find(std::string_view key) const;
+		[[nodiscard]] LazyJsonValue operator[](std::string_view key) const;
+		[[nodiscard]] LazyJsonValue operator[](size_t index) const;
+
+		// Elements of an array or members of an object
+		[[nodiscard]] size_t Size() const;
+
+		// Calls back with every element of an array
+		template <typename Callback> void ForEachElement(Callback && callback) const
+		{
+			if (Type() != EJsonType::Array) throw std::runtime_error("malformed data - array expected");
+			for (auto entry = FirstChild(); entry != End(); entry = NextSibling(entry)) callback(LazyJsonValue(*mDocument, entry));
+		}
+
+		// Calls back with the raw key (no quotes, escapes as they are) and the value of every member of an object
+		template <typename Callback> void ForEachMember(Callback && callback) const
+		{
+			if (Type() != EJsonType::Object) throw std::runtime_error("malformed data - object expected");
+			for (auto entry = FirstChild(); entry != End(); entry = NextSibling(entry + 2)) callback(RawKey(entry), LazyJsonValue(*mDocument, entry + 2));
+		}
+
+		// Decoded string value
+		[[nodiscard]] std::string GetString() const;
+
+		// Numbers, bools and strings
+		template <typename T> [[nodiscard]] T Get() const
+		{
+			if constexpr (std::is_same_v<T, bool>)
+			{
+				const auto raw = Raw();
+				if (raw == "true") return true;
+				if (raw == "false") return false;
+				throw std::runtime_error("malformed data - bool expected");
+			}
+			else if constexpr (std::is_integral_v<T>)
+			{
+				const auto raw = Raw();
+				T result = 0;
+				const auto [end, error] = std::from_chars(raw.data(), raw.data() + raw.size(), result);
+				if (error == std::errc() && end == raw.data() + raw.size()) return result;
+				// Exponents and fractions of integral values
+				return Parse().get<T>();
+			}
+			else if constexpr (std::is_arithmetic_v<T>)
+			{
+				if (Type() != EJsonType::Number) throw std::runtime_error("malformed data - number expected");
+				return Parse().get<T>();
+			}
+			else
+			{
+				return T(GetString());
+			}
+		}
+
+		// DOM of the value, for everything the lazy reader does not handle itself
+		[[nodiscard]] Json Parse() const
+		{
+			const auto raw = Raw();
+			return Json::parse(raw.data(), raw.data() + raw.size());
+		}
+
+	private:
+		[[nodiscard]] char Front() const { return mDocument->mText[mDocument->mIndex[mEntry]]; }
+		// Entry after the value starting at entry
+		[[nodiscard]] uint32_t Skip(const uint32_t entry) const
+		{
+			const auto c = mDocument->mText[mDocument->mIndex[entry]];
+			return (c == '{' || c == '[') ? mDocument->mMatch[entry] + 1 : entry + 1;
+		}
+		// Entries of the children of a container, the closing bracket ends them
+		[[nodiscard]] uint32_t FirstChild() const;
+		[[nodiscard]] uint32_t End() const { return mDocument->mMatch[mEntry]; }
+		[[nodiscard]] uint32_t NextSibling(uint32_t entry) const;
+		[[nodiscard]] std::string_view RawKey(uint32_t entry) const;
+		[[nodiscard]] static bool KeyEquals(std::string_view rawKey, std::string_view key);
+
+		const LazyJsonDocument * mDocument;
+		uint32_t mEntry;
+	};
+
+	inline LazyJsonValue LazyJsonDocument::Root() const { return LazyJsonValue(*this, 0); }
+
+	namespace Serializer
+	{
+		/**
+		 * Reflection driven reader over a LazyJsonValue, for documents in the format of JsonAdapter.
+		 * Members are looked up by name and only the members of the type are parsed, so a type describing just a few fields
+		 * of a large document reads only those. The checksum is not checked for the same reason; missing members are left as they are.
+		 * Values the lazy reader does not handle itself (polymorphic pointers) are parsed into a DOM and read with JsonAdapter.
+		 */
+		class LazyJsonAdapter : public SerializerBase
+		{
+		public:
+			explicit LazyJsonAdapter(const LazyJsonValue & node) : node(node) {}
+
+			template <class T> const LazyJsonAdapter & operator>>(T & value) const
+			{
+				Read(value, node);
+				return *this;
+			}
+
+			// The document is not validated as a whole, std::string values are checked as they are read; off by default
+			void SetUtf8Validation(const Utils::Utf8::EValidation validation) { utf8Validation = validation; }
+
+		protected:
+			template <typename Type> void Read(Type & value, const LazyJsonValue & jsonNode) const
+			{
+				// ---
+				if constexpr (std::is_arithmetic_v<Type> || Traits::is_string_type_v<Type>)
+				{
+					value = jsonNode.Get<Type>();
+					if constexpr (std::is_same_v<Type, std::string>) Utils::Utf8::Validate(value, utf8Validation);
+				}
+				else if constexpr (std::is_enum_v<Type>)
+				{
+					value = static_cast<Type>(jsonNode.Get<int>());
+				}
+				else if constexpr (Traits::is_bitset_v<Type>)
+				{
+					value = Type(jsonNode.GetString());
+				}
+				else if constexpr (Traits::is_bool_vector_v<Type>)
+				{
+					value.clear();
+					jsonNode.ForEachElement([&](const LazyJsonValue & elem) { value.push_back(elem.Get<bool>()); });
+				}
+
+				// Sorted vector map is built in bulk
+				else if constexpr (Traits::is_flat_map_v<Type>)
+				{
+					typename Type::storage_type values;
+					values.reserve(jsonNode.Size());
+					jsonNode.ForEachElement([&](const LazyJsonValue & elem) {
+						typename Type::value_type readValue = {};
+						Read(readValue, elem);
+						values.push_back(std::move(readValue));
+					});
+					value.Assign(std::move(values));
+				}
+
+				// STL-like container support
+				else if constexpr (Traits::is_iterable_v<Type> && !Traits::is_pointer_like_v<Type>)
+				{
+					if constexpr (Traits::is_byte_vector_v<Type>)
+					{
+						if (jsonNode.Type() == EJsonType::String) return ReadBlob(value, jsonNode);
+					}
+
+					using ValueType = typename Type::value_type;
+					jsonNode.ForEachElement([&](const LazyJsonValue & elem) {
+						ValueType readValue = {};
+						Read(readValue, elem);
+
+						InsertElement(value, std::move(readValue));
+					});
+				}
+				else if constexpr (Traits::is_pair_v<Type>)
+				{
+					using FirstType = std::remove_const_t<decltype(value.first)>;
+					using SecondType = std::remove_const_t<decltype(value.second)>;
+
+					FirstType first;
+					SecondType second;
+
+					Read(first, jsonNode[size_t(0)]);
+					Read(second, jsonNode[size_t(1)]);
+
+					(*const_cast<FirstType *>(&(value.first))) = std::move(first);
+					(*const_cast<SecondType *>(&(value.second))) = std::move(second);
+				}
+
+				// -- Only the members of the type are looked up, everything else is skipped
+				else if constexpr (refl::trait::is_reflectable_v<Type> && !Traits::is_pointer_like_v<Type>)
+				{
+					if (jsonNode.Type() != EJsonType::Object) throw std::runtime_error("malformed data - object expected");
+
+					constexpr auto members =
+						refl::util::filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_writable(member); });
+
+					refl::util::for_each(members, [&](auto member) {
+						typedef decltype(member) DescriptorType;
+
+						const auto memberNode = jsonNode.Find(refl::descriptor::get_display_name(member));
+						if (!memberNode)
+						{
+							if constexpr (Traits::is_sparse_v<Type>) SetDefaultValue(member, value);
+							return;
+						}
+
+						if constexpr (Traits::is_serializable_field(member))
+						{
+							auto & memberValue = member(value);
+							if constexpr (Utils::Encoding::has_encoding(member)) { ReadEncoded(member, memberValue, *memberNode); }
+							else if constexpr (Traits::is_blob(member)) { ReadBlob(memberValue, *memberNode); }
+							else
+							{
+								Read(memberValue, *memberNode);
+							}
+						}
+						else if constexpr (Traits::is_serializable_setter(member))
+						{
+							using SetterType = Traits::SetterTypeFromDescriptor<DescriptorType>;
+							SetterType memberValue{};
+							Read(memberValue, *memberNode);
+							member(value, std::move(memberValue));
+						}
+					});
+				}
+				else
+				{
+					auto json = jsonNode.Parse();
+					const JsonAdapter adapter(json);
+					adapter >> value;
+				}
+			}
+
+			template <class T, size_t N> void Read(T (&value)[N], const LazyJsonValue & jsonNode) const
+			{
+				ReadElements(jsonNode, N, [&](const size_t i, const LazyJsonValue & elem) { Read(value[i], elem); });
+			}
+
+			template <class T, size_t N> void Read(std::array<T, N> & value, const LazyJsonValue & jsonNode) const
+			{
+				ReadElements(jsonNode, N, [&](const size_t i, const LazyJsonValue & elem) { Read(value[i], elem); });
+			}
+
+			// The first count elements in a single pass; indexing one by one would walk the array from the start every time
+			template <typename Callback> void ReadElements(const LazyJsonValue & jsonNode, const size_t count, Callback && callback) const
+			{
+				size_t index = 0;
+				jsonNode.ForEachElement([&](const LazyJsonValue & elem) {
+					if (index < count) callback(index, elem);
+					++index;
+				});
+				if (index < count) throw std::runtime_error("Index out of range");
+			}
+
+			template <typename Member, typename Type> void ReadEncoded(const Member member, Type & value, const LazyJsonValue & jsonNode) const
+			{
+				if constexpr (Utils::Encoding::is_scalar_encoding_v<Type>)
+				{
+					Utils::Encoding::Decode(member, value, [&](auto & wire) { wire = jsonNode.Get<std::remove_reference_t<decltype(wire)>>(); });
+				}
+				else
+				{
+					std::vector<LazyJsonValue> elements;
+					jsonNode.ForEachElement([&](const LazyJsonValue & elem) { elements.push_back(elem); });
+					size_t index = 0;
+					Utils::Encoding::Decode(member, value, [&](auto & wire) {
+						if (index >= elements.size()) throw std::runtime_error("Index out of range");
+						wire = elements[index++].template Get<std::remove_reference_t<decltype(wire)>>();
+					});
+				}
+			}
+
+			// Base64 is decoded from the text of the document, unless the writer escaped its slashes
+			template <typename Type> void ReadBlob(Type & value, const LazyJsonValue & jsonNode) const
+			{
+				if (jsonNode.Type() != EJsonType::String) return Read(value, jsonNode);
+				const auto raw = jsonNode.Raw();
+				const auto text = raw.substr(1, raw.size() - 2);
+				if (text.find('\\') == std::string_view::npos)
+					Utils::Base64::DecodeBlob(text, value);
+				else
+					Utils::Base64::DecodeBlob(jsonNode.GetString(), value);
+			}
+
+		private:
+			LazyJsonValue node;
+			Utils::Utf8::EValidation utf8Validation = Utils::Utf8::EValidation::Off;
+		};
+
+	} // namespace Serializer
+} // namespace Grafkit
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+//
+#include <Serialization/Span.h>
+
+namespace Grafkit
+{
+	/**
+	 * Read-only view of a whole file. Mapped into memory where the platform allows, otherwise read into a buffer;
+	 * either way the content stays valid as long as the object lives.
+	 */
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::string & path);
+		~MappedFile() noexcept;
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		[[nodiscard]] Span<const char> Data() const { return {mData, mSize}; }
+		[[nodiscard]] size_t Size() const { return mSize; }
+
+	private:
+		const char * mData = nullptr;
+		size_t mSize = 0;
+		bool mMapped = false;
+		std::vector<char> mBuffer; // content of files that are not mapped
+	};
+
+} // namespace Grafkit
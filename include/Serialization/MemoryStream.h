@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+//
+#include <Serialization/Span.h>
+
+namespace Grafkit
+{
+	/**
+	 * In-memory models of the stream concept (see Traits::is_stream). None of them is an IStream,
+	 * so BasicBinaryAdapter over them inlines every read and write; wrap them in a StreamRef where an IStream is needed.
+	 * ToBytes and FromBytes in Binary.h serialize through them.
+	 */
+
+	/**
+	 * Growable byte buffer; writes append, reads consume from the front
+	 */
+	class MemoryStream
+	{
+	public:
+		MemoryStream() = default;
+		explicit MemoryStream(std::vector<std::byte> data) : mData(std::move(data)) {}
+
+		void Write(const char * buffer, const size_t length)
+		{
+			const auto offset = mData.size();
+			mData.resize(offset + length);
+			std::memcpy(mData.data() + offset, buffer, length);
+		}
+
+		void Read(char * buffer, const size_t length)
+		{
+			if (length > mData.size() - mReadPosition)
+			{
+				mSuccess = false;
+				return;
+			}
+			std::memcpy(buffer, mData.data() + mReadPosition, length);
+			mReadPosition += length;
+		}
+
+		[[nodiscard]] bool IsSuccess() const { return mSuccess; }
+
+		void Reserve(const size_t capacity) { mData.reserve(capacity); }
+		void Clear()
+		{
+			mData.clear();
+			mReadPosition = 0;
+			mSuccess = true;
+		}
+
+		[[nodiscard]] Span<const std::byte> Data() const { return {mData.data(), mData.size()}; }
+		[[nodiscard]] Span<std::byte> Data() { return {mData.data(), mData.size()}; }
+		[[nodiscard]] size_t Size() const { return mData.size(); }
+
+		// Hands over the buffer, the stream is empty afterwards
+		std::vector<std::byte> Release()
+		{
+			mReadPosition = 0;
+			return std::move(mData);
+		}
+
+	private:
+		std::vector<std::byte> mData;
+		size_t mReadPosition = 0;
+		bool mSuccess = true;
+	};
+
+	/**
+	 * Writes into a fixed buffer; running out of space throws, so nothing is written past a failed write
+	 */
+	class SpanOutputStream
+	{
+	public:
+		explicit SpanOutputStream(const Span<std::byte> buffer) : mBuffer(buffer) {}
+
+		void Write(const char * buffer, const size_t length)
+		{
+			if (length > mBuffer.size() - mPosition) throw std::runtime_error("Buffer is too small");
+			std::memcpy(mBuffer.data() + mPosition, buffer, length);
+			mPosition += length;
+		}
+
+		void Read(char *, size_t) { throw std::runtime_error("Can't read from a SpanOutputStream"); }
+		[[nodiscard]] bool IsSuccess() const { return true; }
+
+		// Bytes written so far
+		[[nodiscard]] size_t Position() const { return mPosition; }
+		[[nodiscard]] Span<std::byte> Written() const { return mBuffer.subspan(0, mPosition); }
+
+	private:
+		Span<std::byte> mBuffer;
+		size_t mPosition = 0;
+	};
+
+	/**
+	 * Reads from a fixed buffer
+	 */
+	class SpanInputStream
+	{
+	public:
+		explicit SpanInputStream(const Span<const std::byte> buffer) : mBuffer(buffer) {}
+
+		void Read(char * buffer, const size_t length)
+		{
+			if (length > mBuffer.size() - mPosition)
+			{
+				mSuccess = false;
+				return;
+			}
+			std::memcpy(buffer, mBuffer.data() + mPosition, length);
+			mPosition += length;
+		}
+
+		// Hands out the next length bytes in place instead of copying them
+		[[nodiscard]] Span<const std::byte> ReadView(const size_t length)
+		{
+			if (length > mBuffer.size() - mPosition)
+			{
+				mSuccess = false;
+				return {};
+			}
+			const auto view = mBuffer.subspan(mPosition, length);
+			mPosition += length;
+			return view;
+		}
+
+		void Write(const char *, size_t) { throw std::runtime_error("Can't write to a SpanInputStream"); }
+		[[nodiscard]] bool IsSuccess() const { return mSuccess; }
+
+		[[nodiscard]] size_t Position() const { return mPosition; }
+		[[nodiscard]] size_t Remaining() const { return mBuffer.size() - mPosition; }
+
+	private:
+		Span<const std::byte> mBuffer;
+		size_t mPosition = 0;
+		bool mSuccess = true;
+	};
+
+	/**
+	 * Discards everything, only counts the bytes; tells the serialized size of a value up front
+	 */
+	class CountingStream
+	{
+	public:
+		void Write(const char *, const size_t length) { mCount += length; }
+		void Read(char *, size_t) { throw std::runtime_error("Can't read from a CountingStream"); }
+		[[nodiscard]] bool IsSuccess() const { return true; }
+
+		[[nodiscard]] size_t Count() const { return mCount; }
+
+	private:
+		size_t mCount = 0;
+	};
+
+} // namespace Grafkit
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+//
+#include <Serialization/Stream.h>
+
+namespace Grafkit
+{
+	struct RingStreamOptions
+	{
+		size_t capacity = 1 << 20; // rounded up to a power of two; has to hold the largest frame
+		bool blocking = true;      // wait for space / data instead of failing
+	};
+
+	/**
+	 * Stream between exactly one producer and one consumer thread over a lock-free ring buffer.
+	 * The producer writes any number of objects, then publishes them at once with Commit; the consumer only ever sees committed bytes,
+	 * so as long as the producer commits between objects, the consumer never sees a half-written one.
+	 *
+	 * Blocking mode: a producer waits for space, a consumer waits for data.
+	 * Non-blocking mode: a frame that does not fit is dropped on Commit (which returns false), a consumer reading past the committed data fails;
+	 * check HasFrame before decoding.
+	 */
+	class RingStream final : public IStream
+	{
+	public:
+		explicit RingStream(const RingStreamOptions & options = {});
+		~RingStream() noexcept override = default;
+
+		RingStream(const RingStream &) = delete;
+		RingStream & operator=(const RingStream &) = delete;
+
+		// --- Producer side
+
+		void Write(const char * buffer, size_t length) override;
+
+		/**
+		 * Publishes everything written since the last commit
+		 * @return false if the frame was dropped: it did not fit in non-blocking mode, or a write threw because it exceeds the capacity
+		 */
+		bool Commit();
+
+		// No more frames; a consumer waiting for data fails once the committed ones are read
+		void Close();
+
+		// --- Consumer side
+
+		void Read(char * const & buffer, size_t length) override;
+
+		// Consumer side success: false once a Read ran past the committed data
+		[[nodiscard]] bool IsSuccess() const override { return !mReadFailed.load(std::memory_order_relaxed); }
+
+		// A committed frame is waiting to be read
+		[[nodiscard]] bool HasFrame();
+
+		// Waits for a committed frame; false if the producer closed the stream and everything is read
+		bool WaitForFrame();
+
+		// Reads until the producer closes the stream
+		[[nodiscard]] bool ReadAll(StreamData & outBuffer) override;
+
+		explicit operator std::istream &() const override { throw std::runtime_error("RingStream is not an std::istream"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("RingStream is not an std::ostream"); }
+
+		[[nodiscard]] size_t Capacity() const { return mCapacity; }
+
+		// Number of times the producer had to wait for space, or the consumer for data
+		[[nodiscard]] size_t ProducerStalls() const { return mProducerStalls.load(std::memory_order_relaxed); }
+		[[nodiscard]] size_t ConsumerStalls() const { return mConsumerStalls.load(std::memory_order_relaxed); }
+
+	private:
+		static constexpr size_t CacheLine = 64;
+
+		// Copies in and out of the ring, wrapping around at the end
+		void CopyIn(uint64_t position, const char * buffer, size_t length);
+		void CopyOut(uint64_t position, char * buffer, size_t length) const;
+
+		bool WaitForSpace(size_t length);
+		bool WaitForData(size_t length);
+		void PublishTail();
+
+		size_t mCapacity;
+		size_t mMask;
+		bool mBlocking;
+		std::unique_ptr<char[]> mBuffer;
+
+		// Shared, each on its own cache line
+		alignas(CacheLine) std::atomic<uint64_t> mHead{0}; // committed by the producer
+		alignas(CacheLine) std::atomic<uint64_t> mTail{0}; // released by the consumer
+		alignas(CacheLine) std::atomic<bool> mClosed{false};
+
+		// Producer only
+		alignas(CacheLine) uint64_t mWritePosition = 0;
+		uint64_t mFrameStart = 0;
+		uint64_t mCachedTail = 0;
+		bool mFrameDropped = false;
+		std::atomic<size_t> mProducerStalls{0}; // counted here, read from any thread
+
+		// Consumer only
+		alignas(CacheLine) uint64_t mReadPosition = 0;
+		uint64_t mCachedHead = 0;
+		uint64_t mPublishedTail = 0;
+		std::atomic<bool> mReadFailed{false};
+		std::atomic<size_t> mConsumerStalls{0}; // counted here, read from any thread
+	};
+
+} // namespace Grafkit
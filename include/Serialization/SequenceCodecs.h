@@ -0,0 +1,557 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Sequence codecs for containers of numbers
+ * Every codec turns a run of values into a little endian bit stream; the encoder to be used is picked by sampling the data.
+ */
+
+namespace Grafkit::Utils::SequenceCodecs
+{
+	enum class ECodec : uint8_t
+	{
+		Raw = 0,        // values as they are
+		DeltaBitPacked, // zigzag deltas, bit packed in blocks (integers)
+		XorFloat,       // xor with the previous value, meaningful bits only (floating point)
+		Dictionary,     // distinct values once, then bit packed indices
+		RunLength,      // (value, run length) pairs
+	};
+
+	enum class EPolicy : uint8_t
+	{
+		Off = 0,    // no codec tag, plain element-by-element format
+		FavorSpeed, // trade some size for cheaper decoding
+		FavorSize,  // smallest estimated output
+	};
+
+	// Element types the codecs can handle
+	template <typename T> static constexpr bool is_codec_element_v = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+	// --- Bit streams
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<uint8_t> & bytes) : mBytes(bytes) {}
+
+		// Appends the lowest `bits` bits of value, LSB first
+		void Put(uint64_t value, unsigned bits)
+		{
+			while (bits > 0)
+			{
+				const unsigned take = std::min(bits, 32u);
+				const uint64_t mask = (uint64_t(1) << take) - 1;
+				mAccumulator |= (value & mask) << mBitCount;
+				mBitCount += take;
+				while (mBitCount >= 8)
+				{
+					mBytes.push_back(static_cast<uint8_t>(mAccumulator));
+					mAccumulator >>= 8;
+					mBitCount -= 8;
+				}
+				value = take < 64 ? value >> take : 0;
+				bits -= take;
+			}
+		}
+
+		void PutVarint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				Put((value & 0x7f) | 0x80, 8);
+				value >>= 7;
+			}
+			Put(value, 8);
+		}
+
+		void Finish()
+		{
+			if (mBitCount > 0) mBytes.push_back(static_cast<uint8_t>(mAccumulator));
+			mAccumulator = 0;
+			mBitCount = 0;
+		}
+
+	private:
+		std::vector<uint8_t> & mBytes;
+		uint64_t mAccumulator = 0;
+		unsigned mBitCount = 0;
+	};
+
+	class BitReader
+	{
+	public:
+		BitReader(const uint8_t * data, const size_t size) : mData(data), mSize(size) {}
+
+		uint64_t Get(unsigned bits)
+		{
+			uint64_t result = 0;
+			unsigned shift = 0;
+			while (bits > 0)
+			{
+				const unsigned take = std::min(bits, 32u);
+				while (mBitCount < take)
+				{
+					if (mPosition >= mSize) throw std::runtime_error("malformed data - sequence codec overrun");
+					mAccumulator |= uint64_t(mData[mPosition++]) << mBitCount;
+					mBitCount += 8;
+				}
+				result |= (mAccumulator & ((uint64_t(1) << take) - 1)) << shift;
+				mAccumulator >>= take;
+				mBitCount -= take;
+				shift += take;
+				bits -= take;
+			}
+			return result;
+		}
+
+		uint64_t GetVarint()
+		{
+			uint64_t result = 0;
+			for (unsigned shift = 0; shift < 64; shift += 7)
+			{
+				const auto byte = Get(8);
+				result |= (byte & 0x7f) << shift;
+				if (!(byte & 0x80)) return result;
+			}
+			throw std::runtime_error("malformed data - varint too long");
+		}
+
+	private:
+		const uint8_t * mData;
+		size_t mSize;
+		size_t mPosition = 0;
+		uint64_t mAccumulator = 0;
+		unsigned mBitCount = 0;
+	};
+
+	namespace Impl
+	{
+		template <typename T> using UnsignedOf = std::conditional_t<sizeof(T) == 1, uint8_t,
+			std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+		template <typename T> static constexpr unsigned bitsOf = sizeof(T) * 8;
+
+		template <typename T> UnsignedOf<T> ToBits(const T value)
+		{
+			UnsignedOf<T> bits = 0;
+			std::memcpy(&bits, &value, sizeof(T));
+			return bits;
+		}
+
+		template <typename T> T FromBits(const UnsignedOf<T> bits)
+		{
+			T value{};
+			std::memcpy(&value, &bits, sizeof(T));
+			return value;
+		}
+
+		inline unsigned BitWidth(uint64_t value)
+		{
+			unsigned width = 0;
+			while (value)
+			{
+				++width;
+				value >>= 1;
+			}
+			return width;
+		}
+
+		inline unsigned CountLeadingZeros(const uint64_t value, const unsigned bits) { return bits - BitWidth(value); }
+
+		inline unsigned CountTrailingZeros(uint64_t value)
+		{
+			if (!value) return 64;
+			unsigned count = 0;
+			while (!(value & 1))
+			{
+				++count;
+				value >>= 1;
+			}
+			return count;
+		}
+
+		inline size_t VarintBytes(uint64_t value)
+		{
+			size_t bytes = 1;
+			while (value >= 0x80)
+			{
+				value >>= 7;
+				++bytes;
+			}
+			return bytes;
+		}
+
+		template <typename U> U ZigZag(const U delta)
+		{
+			using S = std::make_signed_t<U>;
+			return static_cast<U>((delta << 1) ^ static_cast<U>(static_cast<S>(delta) >> (bitsOf<U> - 1)));
+		}
+
+		template <typename U> U UnZigZag(const U value) { return static_cast<U>((value >> 1) ^ static_cast<U>(0 - (value & 1))); }
+
+		static constexpr size_t deltaBlockSize = 128;
+		static constexpr size_t dictionaryLimit = 4096;
+
+		// --- Size estimates, in bits
+
+		template <typename T> size_t EstimateDelta(const T * values, const size_t count)
+		{
+			using U = UnsignedOf<T>;
+			size_t bits = count ? bitsOf<T> : 0;
+			for (size_t block = 1; block < count; block += deltaBlockSize)
+			{
+				const size_t end = std::min(count, block + deltaBlockSize);
+				U widest = 0;
+				for (size_t i = block; i < end; ++i) widest |= ZigZag<U>(static_cast<U>(ToBits(values[i]) - ToBits(values[i - 1])));
+				bits += 7 + BitWidth(widest) * (end - block);
+			}
+			return bits;
+		}
+
+		template <typename T> size_t EstimateXor(const T * values, const size_t count)
+		{
+			using U = UnsignedOf<T>;
+			size_t bits = 0;
+			U previous = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const U current = ToBits(values[i]);
+				const U x = current ^ previous;
+				bits += x ? 13 + BitWidth(x) - CountTrailingZeros(x) : 1;
+				previous = current;
+			}
+			return bits;
+		}
+
+		// Returns max size_t if there are too many distinct values
+		template <typename T> size_t EstimateDictionary(const T * values, const size_t count)
+		{
+			using U = UnsignedOf<T>;
+			std::unordered_map<U, uint32_t> dictionary;
+			for (size_t i = 0; i < count; ++i)
+			{
+				dictionary.emplace(ToBits(values[i]), 0);
+				if (dictionary.size() > dictionaryLimit) return std::numeric_limits<size_t>::max();
+			}
+			// A single value is left to run length, so a dictionary entry always costs its indices at least a bit each
+			const auto entries = dictionary.size();
+			if (entries < 2) return std::numeric_limits<size_t>::max();
+			return VarintBytes(entries) * 8 + entries * bitsOf<T> + count * BitWidth(entries ? entries - 1 : 0);
+		}
+
+		template <typename T> size_t EstimateRunLength(const T * values, const size_t count)
+		{
+			size_t bits = 0;
+			for (size_t i = 0; i < count;)
+			{
+				size_t end = i + 1;
+				while (end < count && ToBits(values[end]) == ToBits(values[i])) ++end;
+				bits += bitsOf<T> + VarintBytes(end - i) * 8;
+				i = end;
+			}
+			return bits;
+		}
+
+		template <typename T> size_t Estimate(const ECodec codec, const T * values, const size_t count)
+		{
+			switch (codec)
+			{
+			case ECodec::Raw: return count * bitsOf<T>;
+			case ECodec::DeltaBitPacked: return std::is_integral_v<T> ? EstimateDelta(values, count) : std::numeric_limits<size_t>::max();
+			case ECodec::XorFloat: return std::is_floating_point_v<T> ? EstimateXor(values, count) : std::numeric_limits<size_t>::max();
+			case ECodec::Dictionary: return EstimateDictionary(values, count);
+			case ECodec::RunLength: return EstimateRunLength(values, count);
+			}
+			return std::numeric_limits<size_t>::max();
+		}
+
+		// Relative decode cost per element, raw copy being 1
+		inline double DecodeCost(const ECodec codec)
+		{
+			switch (codec)
+			{
+			case ECodec::Raw: return 1.;
+			case ECodec::RunLength: return 1.25;
+			case ECodec::Dictionary: return 2.;
+			case ECodec::DeltaBitPacked: return 2.5;
+			case ECodec::XorFloat: return 4.;
+			}
+			return 1.;
+		}
+
+	} // namespace Impl
+
+	// --- Codec selection
+
+	static constexpr size_t sampleWindowCount = 4;
+	static constexpr size_t sampleWindowSize = 1024;
+
+	/**
+	 * Picks a codec by estimating the encoded size on a few evenly spread windows of the data.
+	 * FavorSpeed charges every codec with its decode cost, in bytes per element, on top of the estimated size.
+	 */
+	template <typename T> ECodec Choose(const T * values, const size_t count, const EPolicy policy)
+	{
+		if (policy == EPolicy::Off || count == 0) return ECodec::Raw;
+
+		// Windows are joined into one sample, so the dictionary sees the distinct values of all of them
+		const size_t windowCount = count > sampleWindowCount * sampleWindowSize ? sampleWindowCount : 1;
+		const size_t windowSize = windowCount > 1 ? sampleWindowSize : count;
+		std::vector<T> sample;
+		sample.reserve(windowCount * windowSize);
+		for (size_t window = 0; window < windowCount; ++window)
+		{
+			const size_t offset = windowCount > 1 ? window * (count - windowSize) / (windowCount - 1) : 0;
+			sample.insert(sample.end(), values + offset, values + offset + windowSize);
+		}
+
+		ECodec best = ECodec::Raw;
+		double bestScore = std::numeric_limits<double>::max();
+		for (const auto codec : {ECodec::Raw, ECodec::DeltaBitPacked, ECodec::XorFloat, ECodec::Dictionary, ECodec::RunLength})
+		{
+			const auto bits = Impl::Estimate(codec, sample.data(), sample.size());
+			if (bits == std::numeric_limits<size_t>::max()) continue;
+
+			const double bytesPerElement = static_cast<double>(bits) / 8. / static_cast<double>(sample.size());
+			const double costWeight = policy == EPolicy::FavorSpeed ? 1. : 0.;
+			const double score = bytesPerElement + costWeight * Impl::DecodeCost(codec);
+			if (score < bestScore)
+			{
+				bestScore = score;
+				best = codec;
+			}
+		}
+		return best;
+	}
+
+	// --- Encode
+
+	/**
+	 * Encodes values into out; returns false if the codec does not apply (eg. too many distinct values for a dictionary)
+	 */
+	template <typename T> bool Encode(const ECodec codec, const T * values, const size_t count, std::vector<uint8_t> & out)
+	{
+		static_assert(is_codec_element_v<T>);
+		using U = Impl::UnsignedOf<T>;
+		constexpr unsigned bits = Impl::bitsOf<T>;
+
+		BitWriter writer(out);
+		switch (codec)
+		{
+		case ECodec::DeltaBitPacked:
+		{
+			if constexpr (!std::is_integral_v<T>) return false;
+			if (count == 0) break;
+			writer.Put(Impl::ToBits(values[0]), bits);
+			std::vector<U> deltas;
+			deltas.reserve(Impl::deltaBlockSize);
+			for (size_t block = 1; block < count; block += Impl::deltaBlockSize)
+			{
+				const size_t end = std::min(count, block + Impl::deltaBlockSize);
+				deltas.clear();
+				U widest = 0;
+				for (size_t i = block; i < end; ++i)
+				{
+					deltas.push_back(Impl::ZigZag<U>(static_cast<U>(Impl::ToBits(values[i]) - Impl::ToBits(values[i - 1]))));
+					widest |= deltas.back();
+				}
+				const unsigned width = Impl::BitWidth(widest);
+				writer.Put(width, 7);
+				for (const auto delta : deltas) writer.Put(delta, width);
+			}
+			break;
+		}
+		case ECodec::XorFloat:
+		{
+			if constexpr (!std::is_floating_point_v<T>) return false;
+			U previous = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const U current = Impl::ToBits(values[i]);
+				const U x = current ^ previous;
+				if (!x) { writer.Put(0, 1); }
+				else
+				{
+					const unsigned leading = Impl::CountLeadingZeros(x, bits);
+					const unsigned trailing = Impl::CountTrailingZeros(x);
+					const unsigned meaningful = bits - leading - trailing;
+					writer.Put(1, 1);
+					writer.Put(leading, 6);
+					writer.Put(meaningful - 1, 6);
+					writer.Put(static_cast<uint64_t>(x) >> trailing, meaningful);
+				}
+				previous = current;
+			}
+			break;
+		}
+		case ECodec::Dictionary:
+		{
+			std::unordered_map<U, uint32_t> indices;
+			std::vector<U> entries;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const auto inserted = indices.emplace(Impl::ToBits(values[i]), static_cast<uint32_t>(entries.size()));
+				if (inserted.second) entries.push_back(Impl::ToBits(values[i]));
+				if (entries.size() > Impl::dictionaryLimit) return false;
+			}
+			if (entries.size() < 2) return false;
+			const unsigned width = Impl::BitWidth(entries.empty() ? 0 : entries.size() - 1);
+			writer.PutVarint(entries.size());
+			for (const auto entry : entries) writer.Put(entry, bits);
+			for (size_t i = 0; i < count; ++i) writer.Put(indices[Impl::ToBits(values[i])], width);
+			break;
+		}
+		case ECodec::RunLength:
+		{
+			for (size_t i = 0; i < count;)
+			{
+				size_t end = i + 1;
+				while (end < count && Impl::ToBits(values[end]) == Impl::ToBits(values[i])) ++end;
+				writer.Put(Impl::ToBits(values[i]), bits);
+				writer.PutVarint(end - i);
+				i = end;
+			}
+			break;
+		}
+		case ECodec::Raw:
+		{
+			for (size_t i = 0; i < count; ++i) writer.Put(Impl::ToBits(values[i]), bits);
+			break;
+		}
+		}
+		writer.Finish();
+		return true;
+	}
+
+	// --- Decode
+
+	/**
+	 * Checks that a payload can hold count elements before anything is allocated for them; throws if it can not.
+	 * Every codec spends at least a bit per element, except for whole delta blocks and runs, which are counted.
+	 */
+	template <typename T> void CheckCount(const ECodec codec, const uint8_t * data, const size_t size, const size_t count)
+	{
+		static_assert(is_codec_element_v<T>);
+		constexpr unsigned bits = Impl::bitsOf<T>;
+		const size_t payloadBits = size * 8;
+
+		size_t limit = 0;
+		switch (codec)
+		{
+		case ECodec::DeltaBitPacked: limit = payloadBits < bits ? 0 : 1 + (payloadBits - bits) / 7 * Impl::deltaBlockSize; break;
+		case ECodec::XorFloat: limit = payloadBits; break;
+		case ECodec::Dictionary:
+		{
+			BitReader reader(data, size);
+			const auto entryCount = reader.GetVarint();
+			limit = entryCount < 2 ? static_cast<size_t>(entryCount) : payloadBits;
+			break;
+		}
+		case ECodec::RunLength:
+		{
+			BitReader reader(data, size);
+			for (size_t i = 0; i < count;)
+			{
+				reader.Get(bits);
+				const auto run = reader.GetVarint();
+				if (run == 0 || run > count - i) throw std::runtime_error("malformed data - run length");
+				i += static_cast<size_t>(run);
+			}
+			limit = count;
+			break;
+		}
+		case ECodec::Raw: limit = payloadBits / bits; break;
+		default: throw std::runtime_error("malformed data - unknown sequence codec");
+		}
+		if (count > limit) throw std::runtime_error("malformed data - sequence count");
+	}
+
+	template <typename T> void Decode(const ECodec codec, const uint8_t * data, const size_t size, T * values, const size_t count)
+	{
+		static_assert(is_codec_element_v<T>);
+		using U = Impl::UnsignedOf<T>;
+		constexpr unsigned bits = Impl::bitsOf<T>;
+
+		BitReader reader(data, size);
+		switch (codec)
+		{
+		case ECodec::DeltaBitPacked:
+		{
+			if (count == 0) break;
+			U previous = static_cast<U>(reader.Get(bits));
+			values[0] = Impl::FromBits<T>(previous);
+			for (size_t block = 1; block < count; block += Impl::deltaBlockSize)
+			{
+				const size_t end = std::min(count, block + Impl::deltaBlockSize);
+				const auto width = static_cast<unsigned>(reader.Get(7));
+				if (width > bits) throw std::runtime_error("malformed data - delta width");
+				for (size_t i = block; i < end; ++i)
+				{
+					previous = static_cast<U>(previous + Impl::UnZigZag<U>(static_cast<U>(reader.Get(width))));
+					values[i] = Impl::FromBits<T>(previous);
+				}
+			}
+			break;
+		}
+		case ECodec::XorFloat:
+		{
+			U previous = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (reader.Get(1))
+				{
+					const auto leading = static_cast<unsigned>(reader.Get(6));
+					const auto meaningful = static_cast<unsigned>(reader.Get(6)) + 1;
+					if (leading + meaningful > bits) throw std::runtime_error("malformed data - xor float");
+					const unsigned trailing = bits - leading - meaningful;
+					previous = static_cast<U>(previous ^ static_cast<U>(reader.Get(meaningful) << trailing));
+				}
+				values[i] = Impl::FromBits<T>(previous);
+			}
+			break;
+		}
+		case ECodec::Dictionary:
+		{
+			const auto entryCount = reader.GetVarint();
+			if (entryCount > Impl::dictionaryLimit) throw std::runtime_error("malformed data - dictionary size");
+			std::vector<T> entries(static_cast<size_t>(entryCount));
+			for (auto & entry : entries) entry = Impl::FromBits<T>(static_cast<U>(reader.Get(bits)));
+			const unsigned width = Impl::BitWidth(entries.empty() ? 0 : entries.size() - 1);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const auto index = reader.Get(width);
+				if (index >= entries.size()) throw std::runtime_error("malformed data - dictionary index");
+				values[i] = entries[static_cast<size_t>(index)];
+			}
+			break;
+		}
+		case ECodec::RunLength:
+		{
+			for (size_t i = 0; i < count;)
+			{
+				const T value = Impl::FromBits<T>(static_cast<U>(reader.Get(bits)));
+				const auto run = reader.GetVarint();
+				if (run == 0 || run > count - i) throw std::runtime_error("malformed data - run length");
+				std::fill_n(values + i, static_cast<size_t>(run), value);
+				i += static_cast<size_t>(run);
+			}
+			break;
+		}
+		case ECodec::Raw:
+		{
+			for (size_t i = 0; i < count; ++i) values[i] = Impl::FromBits<T>(static_cast<U>(reader.Get(bits)));
+			break;
+		}
+		default: throw std::runtime_error("malformed data - unknown sequence codec");
+		}
+	}
+
+} // namespace Grafkit::Utils::SequenceCodecs
@@ -6,6 +6,8 @@
 namespace Grafkit
 {
 	using BinarySerializer = Serializer::BinaryAdapter;
+	template <class StreamT> using BasicBinarySerializer = Serializer::BasicBinaryAdapter<StreamT>;
 	using JsonSerializer = Serializer::JsonAdapter;
+	using ArenaJsonSerializer = Serializer::ArenaJsonAdapter;
 
 } // namespace Grafkit
@@ -1,21 +1,94 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+//
+#include <refl.h>
+//
+#include <Serialization/JsonFwd.h>
+#include <Serialization/Traits.h>
+
 namespace Grafkit
 {
+	class IStream;
+
 	namespace Serializer
 	{
 
-		class BinaryAdapter;
-		class JsonAdapter;
+		template <class StreamT> class BasicBinaryAdapter;
+		using BinaryAdapter = BasicBinaryAdapter<IStream>;
+		template <class JsonT> class BasicJsonAdapter;
+		using JsonAdapter = BasicJsonAdapter<nlohmann::json>;
+		using ArenaJsonAdapter = BasicJsonAdapter<ArenaJson>;
 
 		class SerializerBase
 		{
 		public:
 			template <class T> SerializerBase & operator<<(const T & value) { return *this; }
 			template <class T> const SerializerBase & operator>>(T & value) const { return *this; }
+
+		protected:
+			// Value-initialized instance, the reference for default member values
+			template <typename Type> static const Type & DefaultInstance()
+			{
+				static const Type instance{};
+				return instance;
+			}
+
+			// Readable member (field or getter) holds the same value as in the default instance
+			template <typename Type, typename Member> static bool IsDefaultValue(const Member member, const Type & value)
+			{
+				using MemberType = std::decay_t<decltype(member(value))>;
+				if constexpr (Traits::is_equality_comparable_v<MemberType>) { return member(value) == member(DefaultInstance<Type>()); }
+				else
+				{
+					return false;
+				}
+			}
+
+			// Sets writable member (field or setter) to the value of the default instance
+			template <typename Type, typename Member> static void SetDefaultValue(const Member member, Type & value)
+			{
+				if constexpr (refl::descriptor::is_field(member)) { member(value) = member(DefaultInstance<Type>()); }
+				else
+				{
+					constexpr auto getter = refl::descriptor::get_reader(member);
+					member(value, getter(DefaultInstance<Type>()));
+				}
+			}
+
+			// Appends a read element; ordered containers get an end-hinted insert, since data written from them comes in sorted
+			template <typename Type, typename ValueType> static void InsertElement(Type & container, ValueType && elem)
+			{
+				if constexpr (Traits::is_ordered_associative_v<Type>)
+				{
+					// Out of order elements fall back to a regular insert
+					if (container.empty() || !container.value_comp()(elem, *container.rbegin()))
+						container.emplace_hint(container.end(), std::forward<ValueType>(elem));
+					else
+						container.insert(std::forward<ValueType>(elem));
+				}
+				else if constexpr (Traits::has_push_back_v<Type, std::decay_t<ValueType>>)
+				{
+					container.push_back(std::forward<ValueType>(elem));
+				}
+				else if constexpr (Traits::has_insert_v<Type, std::decay_t<ValueType>>)
+				{
+					container.insert(std::forward<ValueType>(elem));
+				}
+			}
+
+			// Presence bitmap for sparse types
+			template <size_t N> using PresenceBits = std::array<uint8_t, (N + 7) / 8>;
+
+			template <size_t N> static void SetPresent(PresenceBits<N> & bits, const size_t index) { bits[index / 8] |= static_cast<uint8_t>(1u << (index % 8)); }
+			template <size_t N> static bool IsPresent(const PresenceBits<N> & bits, const size_t index) { return (bits[index / 8] >> (index % 8)) & 1u; }
 		};
 
 	} // namespace Serializer
 } // namespace Grafkit
 
-#define GK_SERIALIZER_ADAPTER_LIST Grafkit::Serializer::BinaryAdapter, Grafkit::Serializer::JsonAdapter
+#define GK_SERIALIZER_ADAPTER_LIST Grafkit::Serializer::BinaryAdapter, Grafkit::Serializer::JsonAdapter, Grafkit::Serializer::ArenaJsonAdapter
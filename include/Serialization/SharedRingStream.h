@@ -0,0 +1,128 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+//
+#include <Serialization/Stream.h>
+
+namespace Grafkit
+{
+	enum class ESharedRingRole
+	{
+		Producer,
+		Consumer,
+	};
+
+	struct SharedRingOptions
+	{
+		size_t capacity = 16 << 20;  // rounded up to a power of two; only used by the side creating the segment
+		unsigned attachTimeoutMs = 5000; // how long to wait for the creating side to set up the segment
+	};
+
+	/**
+	 * Ring buffer stream in a POSIX shared memory segment, between one producer and one consumer process.
+	 * Either side may come first and create the segment, the other attaches to it by name.
+	 *
+	 * Like RingStream, the producer publishes frames with Commit; every frame carries its length, so the consumer
+	 * only hands back space at frame boundaries. Waiting sides sleep on futexes in the segment.
+	 *
+	 * Crash safety: the shared state only changes by atomic stores of whole frame boundaries.
+	 * A producer dying mid-frame leaves nothing behind, a consumer dying mid-frame has that frame delivered again to the next consumer.
+	 * A consumer waiting on a dead producer fails like on a closed stream; a restarted producer or consumer attaches and carries on,
+	 * a new producer also opens a closed stream again.
+	 * A side that dies while creating the segment is taken over by the next one attaching. Its pid goes into the segment right after
+	 * sizing and mapping it; if it died before that, there is nothing to tell it apart from a slow creator: attaching times out
+	 * until Remove() clears the name.
+	 */
+	class SharedRingStream final : public IStream
+	{
+	public:
+		SharedRingStream(const std::string & name, ESharedRingRole role, const SharedRingOptions & options = {});
+		~SharedRingStream() noexcept override;
+
+		SharedRingStream(const SharedRingStream &) = delete;
+		SharedRingStream & operator=(const SharedRingStream &) = delete;
+
+		// Removes the segment name; attached processes keep their mapping
+		static void Remove(const std::string & name);
+
+		// --- Producer side
+
+		void Write(const char * buffer, size_t length) override;
+
+		/**
+		 * Publishes the frame written since the last commit and wakes the consumer
+		 * @return false if the frame was dropped because a write threw on exceeding the capacity
+		 */
+		bool Commit();
+
+		// No more frames; the consumer fails once the committed ones are read
+		void Close();
+
+		// --- Consumer side
+
+		// Reads within and across frames, waiting for the producer as needed
+		void Read(char * const & buffer, size_t length) override;
+		[[nodiscard]] bool IsSuccess() const override { return !mReadFailed; }
+
+		// A committed frame is waiting to be read
+		[[nodiscard]] bool HasFrame();
+
+		/**
+		 * Skips what is left of the current frame, hands back its space, and waits for the next one
+		 * @return false if the producer closed the stream or died, and everything is read
+		 */
+		bool WaitForFrame();
+
+		[[nodiscard]] bool ReadAll(StreamData & outBuffer) override;
+
+		explicit operator std::istream &() const override { throw std::runtime_error("SharedRingStream is not an std::istream"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("SharedRingStream is not an std::ostream"); }
+
+		[[nodiscard]] size_t Capacity() const { return mCapacity; }
+
+	private:
+		struct Header;
+
+		void Attach(const std::string & name, const SharedRingOptions & options);
+		// Sizes and maps a segment this side has to set up, then publishes it
+		void Create(const std::string & name, const SharedRingOptions & options);
+		// Waits for the creating side; false if it died and this side took over creating the segment
+		bool Open(const std::string & name, const SharedRingOptions & options);
+		void ClaimRole();
+
+		void CopyIn(uint64_t position, const char * buffer, size_t length);
+		void CopyOut(uint64_t position, char * buffer, size_t length) const;
+
+		void WaitForSpace(size_t length);
+		// Waits until head passed position; false if the producer is gone
+		bool WaitForHead(uint64_t position);
+		void FinishFrame();
+
+		ESharedRingRole mRole;
+		int mFd = -1;
+		void * mMapping = nullptr;
+		size_t mMappingSize = 0;
+		Header * mHeader = nullptr;
+		char * mRing = nullptr;
+		size_t mCapacity = 0;
+		size_t mMask = 0;
+
+		// Producer
+		uint64_t mWritePosition = 0;
+		uint64_t mFrameStart = 0;
+		bool mInFrame = false;
+		bool mFrameDropped = false;
+
+		// Consumer
+		uint64_t mReadPosition = 0;
+		uint64_t mFrameEnd = 0;
+		bool mReadFailed = false;
+	};
+
+} // namespace Grafkit
+
+#endif
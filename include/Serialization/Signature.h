@@ -1,5 +1,6 @@
 #pragma once
 
+#include <bitset>
 #include <list>
 #include <map>
 #include <queue>
@@ -9,6 +10,8 @@
 //
 
 #include <Serialization/Crc32.h>
+#include <Serialization/Encoding.h>
+#include <Serialization/FlatMap.h>
 #include <Serialization/Traits.h>
 #include <refl.h>
 
@@ -114,6 +117,25 @@ namespace Grafkit
 		// GK_CREATE_TYPE_NAME_RESOLVE_STL_2(std::unordered_map, Grafkit::Utils::Signature::ETypeIdentifier::Map); // TODO
 		GK_CREATE_TYPE_NAME_RESOLVE_STL_2(std::multimap, Grafkit::Utils::Signature::ETypeIdentifier::Map);
 		// GK_CREATE_TYPE_NAME_RESOLVE_STL_2(std::unordered_multimap, Grafkit::Utils::Signature::ETypeIdentifier::Map); // TODO
+		GK_CREATE_TYPE_NAME_RESOLVE_STL_2(Grafkit::FlatMap, Grafkit::Utils::Signature::ETypeIdentifier::Map);
+
+		namespace Impl
+		{
+			template <size_t N> static constexpr auto MakeNumberString()
+			{
+				if constexpr (N < 10) { return refl::make_const_string(static_cast<char>('0' + N)); }
+				else
+				{
+					return MakeNumberString<N / 10>() + refl::make_const_string(static_cast<char>('0' + N % 10));
+				}
+			}
+		} // namespace Impl
+
+		template <size_t N> struct FindTypeName<std::bitset<N>>
+		{
+			static constexpr auto value = refl::make_const_string("std::bitset<") + Impl::MakeNumberString<N>() + refl::make_const_string('>');
+			static constexpr ETypeIdentifier typeIdentifier = ETypeIdentifier::Container;
+		};
 
 #undef GK_CREATE_TYPE_NAME_RESOLVE_BASE_TYPES
 #undef GK_CREATE_TYPE_NAME_RESOLVE_STL
@@ -121,6 +143,16 @@ namespace Grafkit
 
 		namespace Impl
 		{
+			// Bit containers are written as packed words, not one byte per element
+			template <typename ValueType> static constexpr auto CalcPackingString()
+			{
+				if constexpr (Traits::is_bool_vector_v<ValueType> || Traits::is_bitset_v<ValueType>) { return refl::make_const_string(":packed"); }
+				else
+				{
+					return refl::make_const_string();
+				}
+			}
+
 			template <typename Type> static constexpr auto CalcFieldsString()
 			{
 				constexpr auto members = filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_field(member); });
@@ -130,7 +162,8 @@ namespace Grafkit
 						using Descriptor = decltype(member);
 						constexpr auto typeName = FindTypeName<typename Descriptor::value_type>::value;
 						constexpr auto name = member.name;
-						return accumulated + typeName + refl::make_const_string(' ') + name + refl::make_const_string("; ");
+						return accumulated + typeName + refl::make_const_string(' ') + name + Encoding::CalcString(member) +
+							CalcPackingString<typename Descriptor::value_type>() + refl::make_const_string("; ");
 					},
 					refl::make_const_string());
 			}
@@ -144,23 +177,69 @@ namespace Grafkit
 						using Descriptor = decltype(member);
 						constexpr auto typeName = FindTypeName<typename Descriptor::template return_type<Type>>::value;
 						constexpr auto name = refl::descriptor::get_display_name_const(member);
-						return accumulated + typeName + refl::make_const_string(' ') + name + refl::make_const_string("; ");
+						using ValueType = std::decay_t<typename Descriptor::template return_type<Type>>;
+						return accumulated + typeName + refl::make_const_string(' ') + name + CalcPackingString<ValueType>() + refl::make_const_string("; ");
 					},
 					refl::make_const_string());
 			}
 
+			// Adjacent bool members share bytes, which changes the layout of the type.
+			// Absent members of a sparse type don't separate the ones around them, so any two bools may end up side by side there.
+			template <typename Type> static constexpr bool HasPackedBools()
+			{
+				struct BoolRun
+				{
+					size_t length;
+					bool packed;
+				};
+
+				constexpr auto members = filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_readable(member); });
+				constexpr BoolRun run = refl::util::accumulate(
+					members,
+					[](const BoolRun current, const auto member) {
+						using Descriptor = decltype(member);
+						bool isBool = false;
+						if constexpr (refl::descriptor::is_field(member)) { isBool = std::is_same_v<typename Descriptor::value_type, bool>; }
+						else
+						{
+							isBool = std::is_same_v<std::decay_t<typename Descriptor::template return_type<Type>>, bool>;
+						}
+						if (Encoding::has_encoding(member)) isBool = false;
+
+						if (!isBool) return BoolRun{Traits::is_sparse_v<Type> ? current.length : 0, current.packed};
+						return BoolRun{current.length + 1, current.packed || current.length > 0};
+					},
+					BoolRun{0, false});
+				return run.packed;
+			}
+
+			template <typename Type> static constexpr auto CalcSuffixString()
+			{
+				constexpr auto sparse = [] {
+					if constexpr (Traits::is_sparse_v<Type>) { return refl::make_const_string("[sparse] "); }
+					else
+					{
+						return refl::make_const_string();
+					}
+				}();
+				if constexpr (HasPackedBools<Type>()) { return sparse + refl::make_const_string("[packed bools] "); }
+				else
+				{
+					return sparse;
+				}
+			}
+
 		} // namespace Impl
 
 		// TODO: Remove trailing space
 		template <typename Type> static constexpr auto CalcString()
 		{
 			// The only wat to do this the semi-right way to process the fields nad the getters/setters separately
-			return Impl::CalcFieldsString<Type>() + Impl::CalcGettersString<Type>();
+			return Impl::CalcFieldsString<Type>() + Impl::CalcGettersString<Type>() + Impl::CalcSuffixString<Type>();
 		}
 
 		namespace Impl
 		{
-
 			template <typename Type> static constexpr Checksum CalcFieldChecksum()
 			{
 				constexpr auto members = filter(refl::type_descriptor<Type>::members, [](auto member) { return Traits::is_serializable_field(member); });
@@ -170,7 +249,9 @@ namespace Grafkit
 						using Descriptor = decltype(member);
 						constexpr auto typeName = FindTypeName<typename Descriptor::value_type>::value;
 						constexpr auto name = member.name;
-						return checksum ^ Checksum(typeName.data) ^ Checksum(' ') ^ Checksum(name.data) ^ Checksum("; ");
+						constexpr auto packing = CalcPackingString<typename Descriptor::value_type>();
+						return checksum ^ Checksum(typeName.data) ^ Checksum(' ') ^ Checksum(name.data) ^ Encoding::CalcChecksum(member) ^
+							Checksum(packing.data, packing.size) ^ Checksum("; ");
 					},
 					Checksum());
 			}
@@ -184,7 +265,8 @@ namespace Grafkit
 						using Descriptor = decltype(member);
 						constexpr auto typeName = FindTypeName<typename Descriptor::template return_type<Type>>::value;
 						constexpr auto name = refl::descriptor::get_display_name_const(member);
-						return checksum ^Checksum(typeName.data) ^ Checksum(' ') ^ Checksum(name.data) ^ Checksum("; ");
+						constexpr auto packing = CalcPackingString<std::decay_t<typename Descriptor::template return_type<Type>>>();
+						return checksum ^ Checksum(typeName.data) ^ Checksum(' ') ^ Checksum(name.data) ^ Checksum(packing.data, packing.size) ^ Checksum("; ");
 					},
 					Checksum());
 			}
@@ -196,7 +278,9 @@ namespace Grafkit
 		template <typename Type> static constexpr Checksum CalcChecksum()
 		{
 			// The only wat to do this the semi-right way to process the fields nad the getters/setters separately
-			return Impl::CalcFieldChecksum<Type>() ^ Impl::CalcGetterChecksum<Type>();
+			// Sparse types and packed bools have a different layout, so they must not match their plain counterpart
+			constexpr auto suffix = Impl::CalcSuffixString<Type>();
+			return Impl::CalcFieldChecksum<Type>() ^ Impl::CalcGetterChecksum<Type>() ^ Checksum(suffix.data, suffix.size);
 		}
 
 	} // namespace Utils::Signature
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Grafkit
+{
+	/**
+	 * Non-owning view over contiguous elements, a minimal stand-in for C++20 std::span
+	 * @tparam T element type, const for read-only views
+	 */
+	template <typename T> class Span
+	{
+	public:
+		using element_type = T;
+		using value_type = std::remove_cv_t<T>;
+		using size_type = size_t;
+		using iterator = T *;
+
+		constexpr Span() noexcept = default;
+		constexpr Span(T * data, const size_t size) noexcept : mData(data), mSize(size) {}
+
+		template <size_t N> constexpr Span(T (&array)[N]) noexcept : mData(array), mSize(N) {}
+
+		// Any container with data() and size() of compatible elements (std::vector, std::array, std::string, ...)
+		template <typename Container,
+			typename = std::enable_if_t<!std::is_same_v<std::decay_t<Container>, Span> &&
+				std::is_convertible_v<decltype(std::declval<Container &>().data()), T *>>>
+		constexpr Span(Container & container) noexcept : mData(container.data()), mSize(container.size())
+		{
+		}
+
+		// Span<T> converts to Span<const T>
+		template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+		constexpr Span(const Span<U> & other) noexcept : mData(other.data()), mSize(other.size())
+		{
+		}
+
+		[[nodiscard]] constexpr T * data() const noexcept { return mData; }
+		[[nodiscard]] constexpr size_t size() const noexcept { return mSize; }
+		[[nodiscard]] constexpr size_t size_bytes() const noexcept { return mSize * sizeof(T); }
+		[[nodiscard]] constexpr bool empty() const noexcept { return mSize == 0; }
+
+		constexpr T * begin() const noexcept { return mData; }
+		constexpr T * end() const noexcept { return mData + mSize; }
+
+		constexpr T & operator[](const size_t index) const
+		{
+			assert(index < mSize);
+			return mData[index];
+		}
+
+		[[nodiscard]] constexpr Span subspan(const size_t offset, const size_t count) const
+		{
+			assert(offset + count <= mSize);
+			return Span(mData + offset, count);
+		}
+
+		[[nodiscard]] constexpr Span subspan(const size_t offset) const
+		{
+			assert(offset <= mSize);
+			return Span(mData + offset, mSize - offset);
+		}
+
+	private:
+		T * mData = nullptr;
+		size_t mSize = 0;
+	};
+
+	// Byte views over any trivially copyable elements
+	template <typename T> Span<const std::byte> AsBytes(const Span<T> span) noexcept
+	{
+		static_assert(std::is_trivially_copyable_v<std::remove_cv_t<T>>);
+		return {reinterpret_cast<const std::byte *>(span.data()), span.size_bytes()};
+	}
+
+	template <typename T> Span<std::byte> AsWritableBytes(const Span<T> span) noexcept
+	{
+		static_assert(std::is_trivially_copyable_v<T> && !std::is_const_v<T>);
+		return {reinterpret_cast<std::byte *>(span.data()), span.size_bytes()};
+	}
+
+} // namespace Grafkit
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <iosfwd>
+#include <cstdint>
+#include <istream>
+#include <iterator>
 #include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace Grafkit
 {
@@ -24,6 +32,15 @@ namespace Grafkit
 		virtual void Write(const char * buffer, size_t length) = 0;
 		[[nodiscard]] virtual bool IsSuccess() const = 0;
 
+		/**
+		 * Write of a buffer that stays valid until the next ReleaseBorrowed().
+		 * Streams that can hand over memory to the OS directly (eg. writev) keep a reference instead of copying it.
+		 */
+		virtual void WriteBorrowed(const char * buffer, size_t length) { Write(buffer, length); }
+
+		// Borrowed buffers are about to go away; anything still referenced has to be written out
+		virtual void ReleaseBorrowed() {}
+
 		[[nodiscard]] virtual bool ReadAll(StreamData & outBuffer) = 0;
 
 		// Dirty trick to be backward compatible toward STD
@@ -34,6 +51,82 @@ namespace Grafkit
 		operator bool() const { return IsSuccess(); }
 	};
 
+	namespace Traits
+	{
+		/**
+		 * Stream concept: Read(char *, size_t), Write(const char *, size_t) and IsSuccess().
+		 * IStream is one model of it; adapters templated on a concrete model get their stream calls inlined.
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct is_stream : std::false_type
+		{
+		};
+
+		template <typename T>
+		struct is_stream<T,
+			std::void_t<decltype(std::declval<T &>().Read(std::declval<char *>(), size_t{})),
+				decltype(std::declval<T &>().Write(std::declval<const char *>(), size_t{})), decltype(bool(std::declval<const T &>().IsSuccess()))>>
+			: std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool is_stream_v = is_stream<T>::value;
+
+		/**
+		 * Stream takes borrowed writes (WriteBorrowed and ReleaseBorrowed), optional part of the concept
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct has_write_borrowed : std::false_type
+		{
+		};
+
+		template <typename T>
+		struct has_write_borrowed<T,
+			std::void_t<decltype(std::declval<T &>().WriteBorrowed(std::declval<const char *>(), size_t{})), decltype(std::declval<T &>().ReleaseBorrowed())>>
+			: std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool has_write_borrowed_v = has_write_borrowed<T>::value;
+
+	} // namespace Traits
+
+	/**
+	 * IStream over any model of the stream concept, for where a type-erased stream is needed
+	 * @tparam StreamType
+	 */
+	template <class StreamType> class StreamRef final : public IStream
+	{
+	public:
+		explicit StreamRef(StreamType & stream) : mStream(stream) {}
+
+		void Read(char * const & buffer, size_t length) override { mStream.Read(buffer, length); }
+		void Write(const char * const buffer, size_t length) override { mStream.Write(buffer, length); }
+		[[nodiscard]] bool IsSuccess() const override { return mStream.IsSuccess(); }
+
+		void WriteBorrowed(const char * buffer, size_t length) override
+		{
+			if constexpr (Traits::has_write_borrowed_v<StreamType>) { mStream.WriteBorrowed(buffer, length); }
+			else
+			{
+				mStream.Write(buffer, length);
+			}
+		}
+
+		void ReleaseBorrowed() override
+		{
+			if constexpr (Traits::has_write_borrowed_v<StreamType>) mStream.ReleaseBorrowed();
+		}
+
+		[[nodiscard]] bool ReadAll(StreamData &) override { throw std::runtime_error("ReadAll is not supported through a StreamRef"); }
+
+		explicit operator std::istream &() const override { throw std::runtime_error("StreamRef is not an std::istream"); }
+		explicit operator std::ostream &() const override { throw std::runtime_error("StreamRef is not an std::ostream"); }
+
+	private:
+		StreamType & mStream;
+	};
+
 	/**
 	 *
 	 * @tparam StreamType
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Grafkit
+{
+	/**
+	 * Work-stealing thread pool.
+	 * Every worker has a queue of its own and takes work from its back; idle workers steal from the front of the others' queues.
+	 * The thread waiting for a batch helps out with queued work instead of blocking, so batches may be nested;
+	 * it only sleeps once there is nothing left to steal.
+	 */
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+		~ThreadPool() noexcept;
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool & operator=(const ThreadPool &) = delete;
+
+		// Shared pool with a worker for each hardware thread
+		static ThreadPool & Default();
+
+		[[nodiscard]] size_t ThreadCount() const { return mThreads.size(); }
+
+		/**
+		 * Runs body(index) for every index in [0, count) and waits for all of them.
+		 * Rethrows the first exception thrown by body, after the remaining indices ran.
+		 */
+		void ParallelFor(size_t count, const std::function<void(size_t)> & body);
+
+	private:
+		using Task = std::function<void()>;
+
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		void Push(size_t worker, Task task);
+		// Runs one task, own ones first, then stolen ones; false if there was none
+		bool TryRunOne(size_t self);
+		void Run(size_t index);
+
+		std::vector<std::unique_ptr<Worker>> mWorkers;
+		std::vector<std::thread> mThreads;
+
+		std::mutex mSleepMutex;
+		std::condition_variable mWake;
+		std::atomic<size_t> mQueued{0};
+		bool mStop = false;
+	};
+
+	namespace Detail
+	{
+		// Batches are handed out in blocks, a few per worker, so scheduling costs little next to the items themselves
+		inline size_t BatchBlockSize(const size_t count, const ThreadPool & pool)
+		{
+			const auto blocks = pool.ThreadCount() * 4;
+			return std::max<size_t>((count + blocks - 1) / blocks, 1);
+		}
+	} // namespace Detail
+
+} // namespace Grafkit
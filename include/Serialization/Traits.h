@@ -1,7 +1,12 @@
 #pragma once
 
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <type_traits>
+#include <vector>
 //
 #include <refl.h>
 
@@ -21,6 +26,24 @@ namespace Grafkit
 		{
 		};
 
+		/**
+		 * Marker for types to be serialized sparsely
+		 * Members holding their default value - taken from a value-initialized instance - are skipped.
+		 * Binary output stores a presence bitmap in front of the members, Json output omits the keys.
+		 */
+		struct Sparse : refl::attr::usage::type
+		{
+		};
+
+		/**
+		 * Marker for fields to be written as one opaque block of bytes
+		 * Applies to trivially copyable values and to resizable contiguous containers of them; Json output stores base64 text,
+		 * binary output is unaffected. Byte vectors are written this way without the marker.
+		 */
+		struct Blob : refl::attr::usage::field
+		{
+		};
+
 	} // namespace Attributes
 
 	// TODO Test all of these
@@ -181,6 +204,128 @@ namespace Grafkit
 
 		template <typename T>[[maybe_unused]] static constexpr bool is_pair_v{is_pair<T>::value};
 
+		/**
+		 * Is std::vector<bool>
+		 * @tparam T
+		 */
+		template <typename T> struct is_bool_vector : std::false_type
+		{
+		};
+
+		template <typename Allocator> struct is_bool_vector<std::vector<bool, Allocator>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool is_bool_vector_v = is_bool_vector<T>::value;
+
+		/**
+		 * Is std::vector of raw bytes (uint8_t, std::byte); vectors of char and int8_t stay arrays of numbers in JSON, as they always were
+		 * @tparam T
+		 */
+		template <typename T> struct is_byte_vector : std::false_type
+		{
+		};
+
+		template <typename T, typename Allocator>
+		struct is_byte_vector<std::vector<T, Allocator>>
+			: std::bool_constant<std::is_same_v<T, uint8_t> || std::is_same_v<T, std::byte>>
+		{
+		};
+
+		template <typename T> static constexpr bool is_byte_vector_v = is_byte_vector<T>::value;
+
+		/**
+		 * Is std::bitset
+		 * @tparam T
+		 */
+		template <typename T> struct is_bitset : std::false_type
+		{
+		};
+
+		template <size_t N> struct is_bitset<std::bitset<N>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool is_bitset_v = is_bitset<T>::value;
+
+		/**
+		 * Is ordered associative container (set, map and their multi- variants)
+		 * These can take an insertion hint, which makes appending sorted data amortized O(1)
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct is_ordered_associative : std::false_type
+		{
+		};
+
+		template <typename T>
+		struct is_ordered_associative<T,
+			std::void_t<decltype(std::declval<T>().value_comp()),
+				decltype(std::declval<T &>().emplace_hint(std::declval<T &>().end(), std::declval<typename T::value_type>()))>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool is_ordered_associative_v = is_ordered_associative<T>::value;
+
+		/**
+		 * Is equality comparable
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct is_equality_comparable : std::false_type
+		{
+		};
+
+		template <typename T>
+		struct is_equality_comparable<T, std::void_t<decltype(std::declval<const T &>() == std::declval<const T &>())>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool is_equality_comparable_v = is_equality_comparable<T>::value;
+
+		/**
+		 * Has data() over contiguous storage of value_type, like std::vector
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct has_contiguous_data : std::false_type
+		{
+		};
+
+		template <typename T>
+		struct has_contiguous_data<T, std::enable_if_t<std::is_same_v<decltype(std::declval<const T &>().data()), const typename T::value_type *>>>
+			: std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool has_contiguous_data_v = has_contiguous_data<T>::value;
+
+		/**
+		 * Has resize()
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct has_resize : std::false_type
+		{
+		};
+
+		template <typename T> struct has_resize<T, std::void_t<decltype(std::declval<T &>().resize(size_t{}))>> : std::true_type
+		{
+		};
+
+		template <typename T> static constexpr bool has_resize_v = has_resize<T>::value;
+
+		/**
+		 * Can be stored as a blob: trivially copyable, or a resizable contiguous container of trivially copyable values
+		 * @tparam T
+		 */
+		template <typename T, typename = void> struct is_blob_type : std::bool_constant<std::is_trivially_copyable_v<T>>
+		{
+		};
+
+		template <typename T>
+		struct is_blob_type<T, std::enable_if_t<has_contiguous_data_v<T> && has_resize_v<T>>> : std::bool_constant<std::is_trivially_copyable_v<typename T::value_type>>
+		{
+		};
+
+		template <typename T> static constexpr bool is_blob_type_v = is_blob_type<T>::value;
+
 		/**
 		 * Is string
 		 * @tparam T
@@ -304,6 +449,12 @@ namespace Grafkit
 			return is_serializable(t) && refl::descriptor::is_writable(t); //&& (is_serializable_setter(t) || is_serializable_field(t));
 		}
 
+		template <typename T> static constexpr bool is_sparse(const T & t) { return refl::descriptor::has_attribute<Attributes::Sparse>(t); }
+
+		template <typename T> static constexpr bool is_sparse_v = is_sparse(refl::reflect<T>());
+
+		template <typename T> static constexpr bool is_blob(const T & t) { return refl::descriptor::has_attribute<Attributes::Blob>(t); }
+
 		/**
 		 *
 		 */
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Grafkit::Utils::Utf8
+{
+	/**
+	 * What readers do with strings that are not valid UTF-8
+	 */
+	enum class EValidation
+	{
+		Off,     // taken as they are
+		Strict,  // std::runtime_error
+		Replace, // every maximal invalid subsequence becomes U+FFFD
+	};
+
+	/**
+	 * Validation after Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte":
+	 * 32 bytes at a time with AVX2 or 16 with SSSE3 when the CPU has them, checked once on first use, with a shortcut over ASCII;
+	 * other CPUs take a scalar loop that skips ASCII a word at a time.
+	 * Overlong forms, surrogates and code points above U+10FFFF are invalid.
+	 */
+	bool IsValid(const char * text, size_t size);
+	inline bool IsValid(const std::string_view text) { return IsValid(text.data(), text.size()); }
+
+	// Instruction set of the validator; Best is the one picked for the CPU
+	enum class EKernel
+	{
+		Best,
+		Scalar,
+		Ssse3,
+		Avx2,
+	};
+
+	// Whether the CPU can run the kernel
+	bool IsSupported(EKernel kernel);
+
+	// Validates with the given kernel; kernels the CPU does not support throw std::runtime_error
+	bool IsValid(std::string_view text, EKernel kernel);
+
+	// Copy of the text with U+FFFD in place of the invalid parts
+	std::string ReplaceInvalid(std::string_view text);
+
+	// Validates in place; valid text is neither copied nor touched
+	void Validate(std::string & text, EValidation validation);
+
+} // namespace Grafkit::Utils::Utf8
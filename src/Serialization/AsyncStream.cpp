@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <Serialization/AsyncStream.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+	using FilePtr = std::unique_ptr<std::FILE, int (*)(std::FILE *)>;
+
+	bool SyncFile(std::FILE * file)
+	{
+		if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+		return _commit(_fileno(file)) == 0;
+#else
+		return fsync(fileno(file)) == 0;
+#endif
+	}
+} // namespace
+
+Grafkit::AsyncOutputStream::AsyncOutputStream(const std::string & path, const AsyncOutputOptions & options) : mOptions(options)
+{
+	mOptions.bufferSize = std::max<size_t>(mOptions.bufferSize, 1);
+	mOptions.queueDepth = std::max<size_t>(mOptions.queueDepth, 1);
+
+	// Closed here until the background thread takes it over
+	FilePtr file(std::fopen(path.c_str(), "wb"), &std::fclose);
+	if (!file) { throw std::runtime_error("Cannot open file " + path); }
+
+	// One buffer on the caller side, queueDepth on the background side
+	mFreeBuffers.resize(mOptions.queueDepth);
+	for (auto & buffer : mFreeBuffers) buffer.reserve(mOptions.bufferSize);
+	mCurrent.reserve(mOptions.bufferSize);
+
+	mCompletion = mPromise.get_future().share();
+	mFile = file.get();
+	mThread = std::thread(&AsyncOutputStream::Run, this);
+	file.release();
+}
+
+Grafkit::AsyncOutputStream::~AsyncOutputStream() noexcept
+{
+	Close();
+	if (mThread.joinable()) mThread.join();
+}
+
+void Grafkit::AsyncOutputStream::Write(const char * buffer, size_t length)
+{
+	if (mClosed) { throw std::runtime_error("AsyncOutputStream is closed"); }
+	if (mFailed) { throw std::runtime_error("AsyncOutputStream failed to write"); }
+
+	while (length > 0)
+	{
+		const auto take = std::min(length, mOptions.bufferSize - mCurrent.size());
+		mCurrent.insert(mCurrent.end(), buffer, buffer + take);
+		buffer += take;
+		length -= take;
+		if (mCurrent.size() == mOptions.bufferSize) Submit(true);
+	}
+}
+
+void Grafkit::AsyncOutputStream::Flush()
+{
+	if (!mClosed && !mCurrent.empty()) Submit(true);
+}
+
+std::shared_future<void> Grafkit::AsyncOutputStream::Close()
+{
+	if (mClosed) return mCompletion;
+	if (!mCurrent.empty()) Submit(false);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mQueueChanged.notify_one();
+	mClosed = true;
+	return mCompletion;
+}
+
+void Grafkit::AsyncOutputStream::Submit(const bool takeFreeBuffer)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mQueue.push_back(std::move(mCurrent));
+	mQueueChanged.notify_one();
+
+	if (!takeFreeBuffer) return;
+
+	if (mFreeBuffers.empty())
+	{
+		++mStallCount;
+		mBufferFreed.wait(lock, [this] { return !mFreeBuffers.empty(); });
+	}
+	mCurrent = std::move(mFreeBuffers.back());
+	mFreeBuffers.pop_back();
+}
+
+void Grafkit::AsyncOutputStream::Run()
+{
+	std::string error;
+	for (;;)
+	{
+		std::vector<char> buffer;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mQueueChanged.wait(lock, [this] { return !mQueue.empty() || mStop; });
+			if (mQueue.empty()) break;
+			buffer = std::move(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		// After a failure the buffers are still cycled through, so the writer never waits forever
+		if (!mFailed)
+		{
+			if (std::fwrite(buffer.data(), 1, buffer.size(), mFile) != buffer.size())
+				error = std::string("Write failed: ") + std::strerror(errno);
+			else if (mOptions.fsyncPolicy == EFsyncPolicy::EveryBuffer && !SyncFile(mFile))
+				error = std::string("Sync failed: ") + std::strerror(errno);
+			if (!error.empty()) mFailed = true;
+		}
+
+		buffer.clear();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFreeBuffers.push_back(std::move(buffer));
+		}
+		mBufferFreed.notify_one();
+	}
+
+	if (!mFailed && mOptions.fsyncPolicy != EFsyncPolicy::None && !SyncFile(mFile))
+	{
+		error = std::string("Sync failed: ") + std::strerror(errno);
+		mFailed = true;
+	}
+	if (std::fclose(mFile) != 0 && !mFailed)
+	{
+		error = std::string("Close failed: ") + std::strerror(errno);
+		mFailed = true;
+	}
+	mFile = nullptr;
+
+	if (mFailed)
+		mPromise.set_exception(std::make_exception_ptr(std::runtime_error(error)));
+	else
+		mPromise.set_value();
+}
+
+// --- Prefetching input
+
+Grafkit::PrefetchInputStream::PrefetchInputStream(const std::string & path, const PrefetchInputOptions & options) : mOptions(options)
+{
+	mOptions.blockSize = std::max<size_t>(mOptions.blockSize, 1);
+	mOptions.blocksInFlight = std::max<size_t>(mOptions.blocksInFlight, 1);
+
+	FilePtr file(std::fopen(path.c_str(), "rb"), &std::fclose);
+	if (!file) { throw std::runtime_error("Cannot open file " + path); }
+
+	// blocksInFlight on the background side, one being consumed
+	mFreeBuffers.resize(mOptions.blocksInFlight + 1);
+	for (auto & buffer : mFreeBuffers) buffer.reserve(mOptions.blockSize);
+
+	mFile = file.get();
+	mThread = std::thread(&PrefetchInputStream::Run, this);
+	file.release();
+}
+
+Grafkit::PrefetchInputStream::~PrefetchInputStream() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mBufferFreed.notify_one();
+	if (mThread.joinable()) mThread.join();
+	if (mFile) std::fclose(mFile);
+}
+
+void Grafkit::PrefetchInputStream::Read(char * const & buffer, size_t length)
+{
+	size_t offset = 0;
+	while (length > 0)
+	{
+		if (mPosition == mCurrent.size() && !NextBlock())
+		{
+			mSuccess = false;
+			return;
+		}
+		const auto take = std::min(length, mCurrent.size() - mPosition);
+		std::memcpy(buffer + offset, mCurrent.data() + mPosition, take);
+		mPosition += take;
+		offset += take;
+		length -= take;
+	}
+}
+
+bool Grafkit::PrefetchInputStream::ReadAll(StreamData & outBuffer)
+{
+	if (!mSuccess) { return false; }
+	do
+	{
+		outBuffer.insert(outBuffer.end(), mCurrent.begin() + static_cast<std::ptrdiff_t>(mPosition), mCurrent.end());
+		mPosition = mCurrent.size();
+	} while (NextBlock());
+	return true;
+}
+
+bool Grafkit::PrefetchInputStream::NextBlock()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	// The consumed block goes back to the background thread
+	if (mCurrent.capacity() > 0)
+	{
+		mCurrent.clear();
+		mFreeBuffers.push_back(std::move(mCurrent));
+		mBufferFreed.notify_one();
+	}
+	mCurrent = {};
+	mPosition = 0;
+
+	if (mReady.empty() && !mEndOfFile)
+	{
+		++mStallCount;
+		mBlockReady.wait(lock, [this] { return !mReady.empty() || mEndOfFile; });
+	}
+	if (mReady.empty())
+	{
+		if (mError) std::rethrow_exception(mError);
+		return false;
+	}
+
+	mCurrent = std::move(mReady.front());
+	mReady.pop_front();
+	return true;
+}
+
+void Grafkit::PrefetchInputStream::Run()
+{
+	// Errors of the background thread reach the reader once the blocks before them are consumed
+	try
+	{
+		for (;;)
+		{
+			std::vector<char> buffer;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mBufferFreed.wait(lock, [this] { return !mFreeBuffers.empty() || mStop; });
+				if (mStop) return;
+				buffer = std::move(mFreeBuffers.back());
+				mFreeBuffers.pop_back();
+			}
+
+			buffer.resize(mOptions.blockSize);
+			const auto readLength = std::fread(buffer.data(), 1, buffer.size(), mFile);
+			buffer.resize(readLength);
+			const bool failed = std::ferror(mFile) != 0;
+			const bool finished = failed || readLength < mOptions.blockSize;
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (readLength > 0) mReady.push_back(std::move(buffer));
+				if (failed) mError = std::make_exception_ptr(std::runtime_error(std::string("Read failed: ") + std::strerror(errno)));
+				mEndOfFile = finished;
+			}
+			mBlockReady.notify_one();
+			if (finished) return;
+		}
+	}
+	catch (...)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mError = std::current_exception();
+			mEndOfFile = true;
+		}
+		mBlockReady.notify_one();
+	}
+}
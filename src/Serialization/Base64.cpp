@@ -0,0 +1,305 @@
+#include <array>
+#include <stdexcept>
+#include <Serialization/Base64.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GK_BASE64_X86 1
+#include <immintrin.h>
+#define GK_TARGET(features) __attribute__((target(features)))
+#endif
+
+namespace
+{
+	constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	constexpr std::array<int8_t, 256> MakeDecodeTable()
+	{
+		std::array<int8_t, 256> table{};
+		for (auto & value : table) value = -1;
+		for (int i = 0; i < 64; ++i) table[static_cast<uint8_t>(alphabet[i])] = static_cast<int8_t>(i);
+		return table;
+	}
+
+	constexpr auto decodeTable = MakeDecodeTable();
+
+	// Kernels take whole blocks from the front and return how much they took; the scalar code finishes
+	using EncodeKernel = size_t (*)(const uint8_t * in, size_t size, char * out);
+	using DecodeKernel = size_t (*)(const char * in, size_t size, uint8_t * out, size_t room);
+
+	size_t EncodeNone(const uint8_t *, size_t, char *) { return 0; }
+	size_t DecodeNone(const char *, size_t, uint8_t *, size_t) { return 0; }
+
+#ifdef GK_BASE64_X86
+	// Encoding and decoding after Muła and Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions"
+
+	// 3 byte groups of 12 bytes, spread to 4 bytes with the 6 bit indices in the low bits of each
+	GK_TARGET("ssse3") inline __m128i Unpack(const __m128i in)
+	{
+		const auto shuffled = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+		const auto t0 = _mm_mulhi_epu16(_mm_and_si128(shuffled, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+		const auto t1 = _mm_mullo_epi16(_mm_and_si128(shuffled, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+		return _mm_or_si128(t0, t1);
+	}
+
+	// 6 bit indices to characters, as an offset picked by range
+	GK_TARGET("ssse3") inline __m128i Lookup(const __m128i indices)
+	{
+		auto range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+		range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+		const auto offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'+' - 62, '/' - 63, 'A', 0, 0);
+		return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+	}
+
+	// Characters to 6 bit values, false if any of them is outside of the alphabet
+	GK_TARGET("ssse3") inline bool Translate(const __m128i in, __m128i & values)
+	{
+		const auto lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+		const auto lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		const auto lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+		const auto hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+		const auto loNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+		const auto invalid = _mm_and_si128(_mm_shuffle_epi8(lutLo, loNibbles), _mm_shuffle_epi8(lutHi, hiNibbles));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xffff) return false;
+
+		const auto roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f)), hiNibbles));
+		values = _mm_add_epi8(in, roll);
+		return true;
+	}
+
+	// 16 6 bit values to 12 bytes at the front
+	GK_TARGET("ssse3") inline __m128i Pack(const __m128i values)
+	{
+		const auto pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+		const auto quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+		return _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	}
+
+	// Loads 16 bytes for 12
+	GK_TARGET("ssse3") size_t EncodeSsse3(const uint8_t * in, const size_t size, char * out)
+	{
+		size_t done = 0;
+		for (; done + 16 <= size; done += 12, out += 16)
+		{
+			const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + done));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out), Lookup(Unpack(block)));
+		}
+		return done;
+	}
+
+	// Stores 16 bytes for 12
+	GK_TARGET("ssse3") size_t DecodeSsse3(const char * in, const size_t size, uint8_t * out, size_t room)
+	{
+		size_t done = 0;
+		for (; done + 16 <= size && room >= 16; done += 16, out += 12, room -= 12)
+		{
+			__m128i values;
+			if (!Translate(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + done)), values)) break;
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out), Pack(values));
+		}
+		return done;
+	}
+
+	GK_TARGET("avx2") inline __m256i Unpack(const __m256i in)
+	{
+		const auto shuffled = _mm256_shuffle_epi8(in, _mm256_broadcastsi128_si256(_mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1)));
+		const auto t0 = _mm256_mulhi_epu16(_mm256_and_si256(shuffled, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+		const auto t1 = _mm256_mullo_epi16(_mm256_and_si256(shuffled, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+		return _mm256_or_si256(t0, t1);
+	}
+
+	GK_TARGET("avx2") inline __m256i Lookup(const __m256i indices)
+	{
+		auto range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+		range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+		const auto offsets = _mm256_broadcastsi128_si256(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+		return _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+	}
+
+	GK_TARGET("avx2") inline bool Translate(const __m256i in, __m256i & values)
+	{
+		const auto lutLo =
+			_mm256_broadcastsi128_si256(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a));
+		const auto lutHi =
+			_mm256_broadcastsi128_si256(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+		const auto lutRoll = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+
+		const auto hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+		const auto loNibbles = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+		const auto invalid = _mm256_and_si256(_mm256_shuffle_epi8(lutLo, loNibbles), _mm256_shuffle_epi8(lutHi, hiNibbles));
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(invalid, _mm256_setzero_si256())) != -1) return false;
+
+		const auto roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, _mm256_set1_epi8(0x2f)), hiNibbles));
+		values = _mm256_add_epi8(in, roll);
+		return true;
+	}
+
+	// 12 bytes at the front of each lane, moved together
+	GK_TARGET("avx2") inline __m256i Pack(const __m256i values)
+	{
+		const auto pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+		const auto quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+		const auto lanes =
+			_mm256_shuffle_epi8(quads, _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+		return _mm256_permutevar8x32_epi32(lanes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+	}
+
+	// Loads 28 bytes for 24, as two overlapping halves
+	GK_TARGET("avx2") size_t EncodeAvx2(const uint8_t * in, const size_t size, char * out)
+	{
+		size_t done = 0;
+		for (; done + 28 <= size; done += 24, out += 32)
+		{
+			const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + done));
+			const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + done + 12));
+			const auto block = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), Lookup(Unpack(block)));
+		}
+		return done + EncodeSsse3(in + done, size - done, out);
+	}
+
+	// Stores 32 bytes for 24
+	GK_TARGET("avx2") size_t DecodeAvx2(const char * in, const size_t size, uint8_t * out, size_t room)
+	{
+		size_t done = 0;
+		for (; done + 32 <= size && room >= 32; done += 32, out += 24, room -= 24)
+		{
+			__m256i values;
+			if (!Translate(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + done)), values)) break;
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), Pack(values));
+		}
+		return done + DecodeSsse3(in + done, size - done, out, room);
+	}
+#endif
+
+	struct Kernels
+	{
+		EncodeKernel encode = EncodeNone;
+		DecodeKernel decode = DecodeNone;
+	};
+
+	bool CpuSupports(const Grafkit::Utils::Base64::EKernel kernel)
+	{
+		using Grafkit::Utils::Base64::EKernel;
+		if (kernel == EKernel::Best || kernel == EKernel::Scalar) return true;
+#ifdef GK_BASE64_X86
+		__builtin_cpu_init();
+		if (kernel == EKernel::Avx2) return __builtin_cpu_supports("avx2");
+		return __builtin_cpu_supports("ssse3");
+#else
+		return false;
+#endif
+	}
+
+	const Kernels & SelectKernels()
+	{
+		using Grafkit::Utils::Base64::EKernel;
+		static const Kernels kernels = [] {
+			Kernels selected;
+#ifdef GK_BASE64_X86
+			if (CpuSupports(EKernel::Avx2))
+				selected = {EncodeAvx2, DecodeAvx2};
+			else if (CpuSupports(EKernel::Ssse3))
+				selected = {EncodeSsse3, DecodeSsse3};
+#endif
+			return selected;
+		}();
+		return kernels;
+	}
+
+	Kernels KernelsFor(const Grafkit::Utils::Base64::EKernel kernel)
+	{
+		using Grafkit::Utils::Base64::EKernel;
+		if (kernel == EKernel::Best) return SelectKernels();
+		if (!CpuSupports(kernel)) throw std::runtime_error("Base64 kernel is not supported by the CPU");
+#ifdef GK_BASE64_X86
+		if (kernel == EKernel::Avx2) return {EncodeAvx2, DecodeAvx2};
+		if (kernel == EKernel::Ssse3) return {EncodeSsse3, DecodeSsse3};
+#endif
+		return {};
+	}
+
+	uint32_t DecodeQuantum(const char * in)
+	{
+		const auto a = decodeTable[static_cast<uint8_t>(in[0])];
+		const auto b = decodeTable[static_cast<uint8_t>(in[1])];
+		const auto c = decodeTable[static_cast<uint8_t>(in[2])];
+		const auto d = decodeTable[static_cast<uint8_t>(in[3])];
+		if ((a | b | c | d) < 0) throw std::runtime_error("malformed data - base64 character");
+		return static_cast<uint32_t>(a) << 18 | static_cast<uint32_t>(b) << 12 | static_cast<uint32_t>(c) << 6 | static_cast<uint32_t>(d);
+	}
+} // namespace
+
+bool Grafkit::Utils::Base64::IsSupported(const EKernel kernel) { return CpuSupports(kernel); }
+
+void Grafkit::Utils::Base64::Encode(const void * data, const size_t size, char * out, const EKernel kernel)
+{
+	const auto * in = static_cast<const uint8_t *>(data);
+	const auto done = KernelsFor(kernel).encode(in, size, out);
+	in += done;
+	out += done / 3 * 4;
+
+	auto remaining = size - done;
+	for (; remaining >= 3; remaining -= 3, in += 3, out += 4)
+	{
+		const uint32_t group = static_cast<uint32_t>(in[0]) << 16 | static_cast<uint32_t>(in[1]) << 8 | in[2];
+		out[0] = alphabet[group >> 18];
+		out[1] = alphabet[(group >> 12) & 0x3f];
+		out[2] = alphabet[(group >> 6) & 0x3f];
+		out[3] = alphabet[group & 0x3f];
+	}
+	if (remaining)
+	{
+		const uint32_t group = static_cast<uint32_t>(in[0]) << 16 | (remaining == 2 ? static_cast<uint32_t>(in[1]) << 8 : 0);
+		out[0] = alphabet[group >> 18];
+		out[1] = alphabet[(group >> 12) & 0x3f];
+		out[2] = remaining == 2 ? alphabet[(group >> 6) & 0x3f] : '=';
+		out[3] = '=';
+	}
+}
+
+std::string Grafkit::Utils::Base64::Encode(const void * data, const size_t size)
+{
+	std::string text(EncodedSize(size), '\0');
+	Encode(data, size, text.data());
+	return text;
+}
+
+size_t Grafkit::Utils::Base64::DecodedSize(const std::string_view text)
+{
+	if (text.size() % 4) throw std::runtime_error("malformed data - base64 length");
+	if (text.empty()) return 0;
+	const size_t padding = text[text.size() - 1] == '=' ? (text[text.size() - 2] == '=' ? 2 : 1) : 0;
+	return text.size() / 4 * 3 - padding;
+}
+
+void Grafkit::Utils::Base64::Decode(const std::string_view text, void * data, const EKernel kernel)
+{
+	const auto size = DecodedSize(text);
+	if (text.empty()) return;
+
+	// The last quantum may be padded, the ones before it are decoded in bulk
+	const auto * in = text.data();
+	const auto bulkSize = text.size() - 4;
+	auto * out = static_cast<uint8_t *>(data);
+
+	auto done = KernelsFor(kernel).decode(in, bulkSize, out, size);
+	out += done / 4 * 3;
+	for (; done < bulkSize; done += 4, out += 3)
+	{
+		const auto group = DecodeQuantum(in + done);
+		out[0] = static_cast<uint8_t>(group >> 16);
+		out[1] = static_cast<uint8_t>(group >> 8);
+		out[2] = static_cast<uint8_t>(group);
+	}
+
+	char last[4] = {in[done], in[done + 1], in[done + 2], in[done + 3]};
+	const auto tail = size - bulkSize / 4 * 3;
+	for (auto i = tail + 1; i < 4; ++i) last[i] = 'A';
+	const auto group = DecodeQuantum(last);
+	out[0] = static_cast<uint8_t>(group >> 16);
+	if (tail > 1) out[1] = static_cast<uint8_t>(group >> 8);
+	if (tail > 2) out[2] = static_cast<uint8_t>(group);
+}
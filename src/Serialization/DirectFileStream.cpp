@@ -0,0 +1,508 @@
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <Serialization/DirectFileStream.h>
+//
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+	constexpr size_t alignment = 4096;
+
+	size_t AlignUp(const size_t value) { return (value + alignment - 1) / alignment * alignment; }
+
+	std::string ErrorText(const std::string & what, const int error) { return what + ": " + std::strerror(error); }
+
+	class AlignedBuffer
+	{
+	public:
+		explicit AlignedBuffer(const size_t capacity)
+		{
+			void * data = nullptr;
+			if (posix_memalign(&data, alignment, capacity) != 0) throw std::bad_alloc();
+			mData = static_cast<char *>(data);
+		}
+		~AlignedBuffer() { std::free(mData); }
+
+		AlignedBuffer(AlignedBuffer && other) noexcept : mData(other.mData) { other.mData = nullptr; }
+		AlignedBuffer(const AlignedBuffer &) = delete;
+		AlignedBuffer & operator=(const AlignedBuffer &) = delete;
+
+		[[nodiscard]] char * Data() const { return mData; }
+
+	private:
+		char * mData = nullptr;
+	};
+
+	// Blocking transfer of the whole range; returns the bytes transferred (less at the end of the file) or -errno
+	ssize_t TransferSync(const int fd, const bool write, char * data, const size_t length, off_t offset)
+	{
+		size_t done = 0;
+		while (done < length)
+		{
+			const auto result = write ? pwrite(fd, data + done, length - done, offset) : pread(fd, data + done, length - done, offset);
+			if (result < 0)
+			{
+				if (errno == EINTR) continue;
+				return -errno;
+			}
+			if (result == 0) break;
+			done += static_cast<size_t>(result);
+			offset += result;
+		}
+		return static_cast<ssize_t>(done);
+	}
+
+	/**
+	 * One request in flight per buffer slot
+	 */
+	class IoBackend
+	{
+	public:
+		virtual ~IoBackend() = default;
+		virtual void Submit(size_t slot, bool write, char * data, size_t length, off_t offset) = 0;
+		// Waits for the request of the slot; returns the bytes transferred or -errno
+		virtual ssize_t Wait(size_t slot) = 0;
+	};
+
+	class PosixBackend final : public IoBackend
+	{
+	public:
+		PosixBackend(const int fd, const size_t slots) : mFd(fd), mResults(slots) {}
+
+		void Submit(const size_t slot, const bool write, char * data, const size_t length, const off_t offset) override
+		{
+			mResults[slot] = TransferSync(mFd, write, data, length, offset);
+		}
+		ssize_t Wait(const size_t slot) override { return mResults[slot]; }
+
+	private:
+		int mFd;
+		std::vector<ssize_t> mResults;
+	};
+
+	/**
+	 * io_uring through raw syscalls, so there is no dependency on liburing
+	 */
+	class IoUringBackend final : public IoBackend
+	{
+	public:
+		// Returns nullptr if io_uring can not be set up (old kernel, seccomp, ...)
+		static std::unique_ptr<IoUringBackend> Create(const int fd, const std::vector<AlignedBuffer> & buffers, const size_t bufferSize)
+		{
+			std::unique_ptr<IoUringBackend> backend(new IoUringBackend(fd, buffers.size()));
+			if (!backend->Init(buffers, bufferSize)) return nullptr;
+			return backend;
+		}
+
+		~IoUringBackend() override
+		{
+			// Requests still in flight have to be finished before their buffers go away
+			for (size_t slot = 0; slot < mPending.size(); ++slot)
+				if (mPending[slot]) Wait(slot);
+			if (mSqes) munmap(mSqes, mSqesSize);
+			if (mCqRing && mCqRing != mSqRing) munmap(mCqRing, mCqRingSize);
+			if (mSqRing) munmap(mSqRing, mSqRingSize);
+			if (mRingFd >= 0) close(mRingFd);
+		}
+
+		void Submit(const size_t slot, const bool write, char * data, const size_t length, const off_t offset) override
+		{
+			const unsigned tail = *mSqTail;
+			const unsigned index = tail & *mSqMask;
+			io_uring_sqe & sqe = mSqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+
+			sqe.fd = mFd;
+			sqe.off = static_cast<uint64_t>(offset);
+			sqe.user_data = slot;
+			if (mFixedBuffers)
+			{
+				sqe.opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+				sqe.addr = reinterpret_cast<uint64_t>(data);
+				sqe.len = static_cast<uint32_t>(length);
+				sqe.buf_index = static_cast<uint16_t>(slot);
+			}
+			else
+			{
+				mIovecs[slot] = {data, length};
+				sqe.opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+				sqe.addr = reinterpret_cast<uint64_t>(&mIovecs[slot]);
+				sqe.len = 1;
+			}
+			mSqArray[index] = index;
+			__atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+
+			mRequests[slot] = {write, data, length, offset};
+			mPending[slot] = true;
+
+			int result = 0;
+			do result = Enter(1, 0, 0);
+			while (result < 0 && errno == EINTR);
+			if (result < 0)
+			{
+				mResults[slot] = -errno;
+				mPending[slot] = false;
+			}
+		}
+
+		ssize_t Wait(const size_t slot) override
+		{
+			while (mPending[slot])
+			{
+				const unsigned head = *mCqHead;
+				if (head == __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE))
+				{
+					if (Enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+					{
+						const int error = errno;
+						for (size_t i = 0; i < mPending.size(); ++i)
+							if (mPending[i]) mResults[i] = -error, mPending[i] = false;
+					}
+					continue;
+				}
+				const io_uring_cqe & cqe = mCqes[head & *mCqMask];
+				const auto completed = static_cast<size_t>(cqe.user_data);
+				mResults[completed] = cqe.res;
+				mPending[completed] = false;
+				__atomic_store_n(mCqHead, head + 1, __ATOMIC_RELEASE);
+			}
+
+			// Short transfers are rare on regular files; the rest is done synchronously
+			const auto & request = mRequests[slot];
+			const auto result = mResults[slot];
+			if (result > 0 && static_cast<size_t>(result) < request.length)
+			{
+				const auto done = static_cast<size_t>(result);
+				const auto rest = TransferSync(mFd, request.write, request.data + done, request.length - done, request.offset + result);
+				return rest < 0 ? rest : result + rest;
+			}
+			return result;
+		}
+
+	private:
+		struct Request
+		{
+			bool write = false;
+			char * data = nullptr;
+			size_t length = 0;
+			off_t offset = 0;
+		};
+
+		IoUringBackend(const int fd, const size_t slots) : mFd(fd), mIovecs(slots), mRequests(slots), mResults(slots), mPending(slots) {}
+
+		bool Init(const std::vector<AlignedBuffer> & buffers, const size_t bufferSize)
+		{
+			io_uring_params params = {};
+			mRingFd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(buffers.size()), &params));
+			if (mRingFd < 0) return false;
+
+			mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+			if (singleMmap) mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+
+			mSqRing = Map(mSqRingSize, IORING_OFF_SQ_RING);
+			if (!mSqRing) return false;
+			mCqRing = singleMmap ? mSqRing : Map(mCqRingSize, IORING_OFF_CQ_RING);
+			if (!mCqRing) return false;
+			mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			mSqes = static_cast<io_uring_sqe *>(Map(mSqesSize, IORING_OFF_SQES));
+			if (!mSqes) return false;
+
+			auto * sq = static_cast<char *>(mSqRing);
+			mSqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+			mSqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+			mSqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+			auto * cq = static_cast<char *>(mCqRing);
+			mCqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+			mCqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+			mCqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+			mCqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+			// Registered buffers save the kernel mapping them for every request; it may fail on a low RLIMIT_MEMLOCK, which is fine
+			std::vector<iovec> iovecs;
+			for (const auto & buffer : buffers) iovecs.push_back({buffer.Data(), bufferSize});
+			mFixedBuffers = syscall(__NR_io_uring_register, mRingFd, IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(iovecs.size())) == 0;
+			return true;
+		}
+
+		void * Map(const size_t size, const off_t offset) const
+		{
+			void * ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRingFd, offset);
+			return ptr == MAP_FAILED ? nullptr : ptr;
+		}
+
+		int Enter(const unsigned toSubmit, const unsigned minComplete, const unsigned flags) const
+		{
+			return static_cast<int>(syscall(__NR_io_uring_enter, mRingFd, toSubmit, minComplete, flags, nullptr, 0));
+		}
+
+		int mFd;
+		int mRingFd = -1;
+		bool mFixedBuffers = false;
+
+		void * mSqRing = nullptr;
+		void * mCqRing = nullptr;
+		size_t mSqRingSize = 0;
+		size_t mCqRingSize = 0;
+		io_uring_sqe * mSqes = nullptr;
+		size_t mSqesSize = 0;
+
+		unsigned * mSqTail = nullptr;
+		unsigned * mSqMask = nullptr;
+		unsigned * mSqArray = nullptr;
+		unsigned * mCqHead = nullptr;
+		unsigned * mCqTail = nullptr;
+		unsigned * mCqMask = nullptr;
+		io_uring_cqe * mCqes = nullptr;
+
+		std::vector<iovec> mIovecs;
+		std::vector<Request> mRequests;
+		std::vector<ssize_t> mResults;
+		std::vector<bool> mPending;
+	};
+
+} // namespace
+
+// Blocks go round robin through the slots: block n always lives in slot n % queueDepth
+struct Grafkit::DirectFileStream::Impl
+{
+	int fd = -1;
+	size_t blockSize = 0;
+	std::vector<AlignedBuffer> buffers;
+	std::unique_ptr<IoBackend> backend;
+	std::vector<size_t> lengths; // expected length of the request in each slot
+	std::vector<bool> pending;
+	size_t slot = 0;     // slot of the current block
+	size_t position = 0; // read / write position within the current block
+
+	// Read
+	uint64_t fileSize = 0;
+	uint64_t submitOffset = 0;
+	size_t available = 0;
+	bool hasBlock = false;
+
+	// Write
+	uint64_t writeOffset = 0;
+
+	Impl() = default;
+	// Also cleans up after a constructor that failed half way; the backend waits for anything still in flight before the file goes away
+	~Impl()
+	{
+		backend.reset();
+		if (fd >= 0) close(fd);
+	}
+
+	Impl(const Impl &) = delete;
+	Impl & operator=(const Impl &) = delete;
+
+	void Submit(const size_t index, const bool write, const size_t length, const size_t expected, const uint64_t offset)
+	{
+		lengths[index] = expected;
+		pending[index] = true;
+		backend->Submit(index, write, buffers[index].Data(), length, static_cast<off_t>(offset));
+	}
+
+	void Finish(const size_t index)
+	{
+		pending[index] = false;
+		const auto result = backend->Wait(index);
+		if (result < 0) throw std::runtime_error(ErrorText("I/O failed", static_cast<int>(-result)));
+		if (static_cast<size_t>(result) < lengths[index]) throw std::runtime_error("I/O failed: short transfer");
+	}
+
+	void SubmitRead(const size_t index)
+	{
+		const auto expected = static_cast<size_t>(std::min<uint64_t>(blockSize, fileSize - submitOffset));
+		Submit(index, false, blockSize, expected, submitOffset);
+		submitOffset += blockSize;
+	}
+};
+
+Grafkit::DirectFileStream::DirectFileStream(const std::string & path, const EFileMode mode, const DirectFileOptions & options)
+	: mImpl(std::make_unique<Impl>()), mMode(mode)
+{
+	const int baseFlags = mode == EFileMode::Read ? O_RDONLY : O_WRONLY | O_CREAT | O_TRUNC;
+	if (options.directIo)
+	{
+		mImpl->fd = open(path.c_str(), baseFlags | O_DIRECT | O_CLOEXEC, 0644);
+		mDirectIo = mImpl->fd >= 0;
+	}
+	// O_DIRECT is refused with EINVAL by file systems that do not support it (eg. tmpfs)
+	if (mImpl->fd < 0) mImpl->fd = open(path.c_str(), baseFlags | O_CLOEXEC, 0644);
+	if (mImpl->fd < 0) throw std::runtime_error(ErrorText("Cannot open file " + path, errno));
+
+	const size_t slots = std::max<size_t>(options.queueDepth, 1);
+	mImpl->blockSize = AlignUp(std::max<size_t>(options.blockSize, 1));
+	for (size_t i = 0; i < slots; ++i) mImpl->buffers.emplace_back(mImpl->blockSize);
+	mImpl->lengths.resize(slots);
+	mImpl->pending.resize(slots);
+
+	if (options.useIoUring) mImpl->backend = IoUringBackend::Create(mImpl->fd, mImpl->buffers, mImpl->blockSize);
+	mIoUring = mImpl->backend != nullptr;
+	if (!mImpl->backend) mImpl->backend = std::make_unique<PosixBackend>(mImpl->fd, slots);
+
+	if (mode == EFileMode::Read)
+	{
+		struct stat status = {};
+		if (fstat(mImpl->fd, &status) != 0) throw std::runtime_error(ErrorText("Cannot stat file " + path, errno));
+		mImpl->fileSize = static_cast<uint64_t>(status.st_size);
+		for (size_t i = 0; i < slots && mImpl->submitOffset < mImpl->fileSize; ++i) mImpl->SubmitRead(i);
+	}
+}
+
+Grafkit::DirectFileStream::~DirectFileStream() noexcept
+{
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+}
+
+void Grafkit::DirectFileStream::Read(char * const & buffer, size_t length)
+{
+	if (mMode != EFileMode::Read) { throw std::runtime_error("Can't read from a DirectFileStream opened for writing"); }
+	auto & impl = *mImpl;
+	size_t offset = 0;
+	while (length > 0)
+	{
+		if (impl.position == impl.available && !NextReadBlock())
+		{
+			mSuccess = false;
+			return;
+		}
+		const auto take = std::min(length, impl.available - impl.position);
+		std::memcpy(buffer + offset, impl.buffers[impl.slot].Data() + impl.position, take);
+		impl.position += take;
+		offset += take;
+		length -= take;
+	}
+}
+
+bool Grafkit::DirectFileStream::ReadAll(StreamData & outBuffer)
+{
+	if (mMode != EFileMode::Read || !mSuccess) { return false; }
+	auto & impl = *mImpl;
+	do
+	{
+		const auto * data = impl.buffers[impl.slot].Data();
+		outBuffer.insert(outBuffer.end(), data + impl.position, data + impl.available);
+		impl.position = impl.available;
+	} while (NextReadBlock());
+	return true;
+}
+
+bool Grafkit::DirectFileStream::NextReadBlock()
+{
+	auto & impl = *mImpl;
+	if (impl.hasBlock)
+	{
+		// The slot of the consumed block reads ahead the next one
+		if (impl.submitOffset < impl.fileSize) impl.SubmitRead(impl.slot);
+		impl.slot = (impl.slot + 1) % impl.buffers.size();
+	}
+	impl.position = 0;
+	impl.available = 0;
+	impl.hasBlock = false;
+
+	if (!impl.pending[impl.slot]) return false;
+	impl.Finish(impl.slot);
+	impl.available = impl.lengths[impl.slot];
+	impl.hasBlock = true;
+	return true;
+}
+
+void Grafkit::DirectFileStream::Write(const char * buffer, size_t length)
+{
+	if (mMode != EFileMode::Write || mClosed) { throw std::runtime_error("Can't write to this DirectFileStream"); }
+	auto & impl = *mImpl;
+	while (length > 0)
+	{
+		const auto take = std::min(length, impl.blockSize - impl.position);
+		std::memcpy(impl.buffers[impl.slot].Data() + impl.position, buffer, take);
+		impl.position += take;
+		buffer += take;
+		length -= take;
+		if (impl.position == impl.blockSize) SubmitWriteBlock(impl.blockSize);
+	}
+}
+
+void Grafkit::DirectFileStream::SubmitWriteBlock(const size_t length)
+{
+	auto & impl = *mImpl;
+	try
+	{
+		impl.Submit(impl.slot, true, length, length, impl.writeOffset);
+		impl.writeOffset += length;
+		impl.slot = (impl.slot + 1) % impl.buffers.size();
+		impl.position = 0;
+		if (impl.pending[impl.slot]) impl.Finish(impl.slot);
+	}
+	catch (...)
+	{
+		mSuccess = false;
+		throw;
+	}
+}
+
+void Grafkit::DirectFileStream::Close()
+{
+	if (mClosed) return;
+	mClosed = true;
+	auto & impl = *mImpl;
+
+	std::string error;
+	try
+	{
+		if (mMode == EFileMode::Write && mSuccess)
+		{
+			const uint64_t fileSize = impl.writeOffset + impl.position;
+			if (impl.position > 0)
+			{
+				// O_DIRECT only takes whole blocks; the padding is cut off afterwards
+				size_t length = impl.position;
+				if (mDirectIo)
+				{
+					length = AlignUp(impl.position);
+					std::memset(impl.buffers[impl.slot].Data() + impl.position, 0, length - impl.position);
+				}
+				SubmitWriteBlock(length);
+			}
+			for (size_t i = 0; i < impl.buffers.size(); ++i)
+				if (impl.pending[i]) impl.Finish(i);
+			if (mDirectIo && ftruncate(impl.fd, static_cast<off_t>(fileSize)) != 0) error = ErrorText("Truncate failed", errno);
+		}
+	}
+	catch (const std::exception & e)
+	{
+		error = e.what();
+	}
+
+	// Backend waits for anything still in flight before the buffers and the file go away
+	impl.backend.reset();
+	if (close(impl.fd) != 0 && error.empty() && mMode == EFileMode::Write) error = ErrorText("Close failed", errno);
+	impl.fd = -1;
+
+	if (!error.empty())
+	{
+		mSuccess = false;
+		throw std::runtime_error(error);
+	}
+}
+
+#endif
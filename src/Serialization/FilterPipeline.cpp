@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <Serialization/Crc32Table.h>
+#include <Serialization/FilterPipeline.h>
+
+/**
+ * Bounded queue of blocks between two threads; aborting it releases everyone waiting on it
+ */
+class Grafkit::FilterPipeline::BlockQueue
+{
+public:
+	explicit BlockQueue(const size_t capacity) : mCapacity(std::max<size_t>(capacity, 1)) {}
+
+	bool Push(FilterBlock && block)
+	{
+		std::unique_lock lock(mMutex);
+		mChanged.wait(lock, [this] { return mAborted || mBlocks.size() < mCapacity; });
+		if (mAborted) return false;
+		mBlocks.push_back(std::move(block));
+		mChanged.notify_all();
+		return true;
+	}
+
+	// False once the queue is finished and drained, or aborted
+	bool Pop(FilterBlock & block)
+	{
+		std::unique_lock lock(mMutex);
+		mChanged.wait(lock, [this] { return mAborted || mFinished || !mBlocks.empty(); });
+		if (mAborted || mBlocks.empty()) return false;
+		block = std::move(mBlocks.front());
+		mBlocks.pop_front();
+		mChanged.notify_all();
+		return true;
+	}
+
+	// No more blocks coming
+	void Finish()
+	{
+		std::lock_guard lock(mMutex);
+		mFinished = true;
+		mChanged.notify_all();
+	}
+
+	void Abort()
+	{
+		std::lock_guard lock(mMutex);
+		mAborted = true;
+		mChanged.notify_all();
+	}
+
+private:
+	std::mutex mMutex;
+	std::condition_variable mChanged;
+	std::deque<FilterBlock> mBlocks;
+	size_t mCapacity;
+	bool mFinished = false;
+	bool mAborted = false;
+};
+
+Grafkit::FilterPipeline::FilterPipeline(IStream & sink, const FilterPipelineOptions & options) : mSink(sink), mOptions(options)
+{
+	mOptions.blockSize = std::max<size_t>(mOptions.blockSize, 1);
+	mOptions.queueDepth = std::max<size_t>(mOptions.queueDepth, 1);
+	mCurrent.data.reserve(mOptions.blockSize);
+}
+
+Grafkit::FilterPipeline::~FilterPipeline() noexcept
+{
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+	for (auto & queue : mQueues) queue->Abort();
+	if (mFreeBlocks) mFreeBlocks->Abort();
+	for (auto & thread : mThreads)
+		if (thread.joinable()) thread.join();
+}
+
+void Grafkit::FilterPipeline::AddStage(std::unique_ptr<IFilterStage> stage)
+{
+	if (mStarted) { throw std::runtime_error("Stages have to be added before writing to the FilterPipeline"); }
+	mStages.push_back(std::move(stage));
+}
+
+void Grafkit::FilterPipeline::Start()
+{
+	mStarted = true;
+	if (!mOptions.parallel) return;
+
+	const auto stageCount = mStages.size();
+	for (size_t i = 0; i <= stageCount; ++i) mQueues.push_back(std::make_unique<BlockQueue>(mOptions.queueDepth));
+
+	// Enough blocks to fill every queue; with the one being written, all of them fit back into the free queue
+	const auto blockCount = (stageCount + 1) * mOptions.queueDepth;
+	mFreeBlocks = std::make_unique<BlockQueue>(blockCount + 1);
+	for (size_t i = 0; i < blockCount; ++i)
+	{
+		FilterBlock block;
+		block.data.reserve(mOptions.blockSize);
+		mFreeBlocks->Push(std::move(block));
+	}
+
+	for (size_t i = 0; i < stageCount; ++i) mThreads.emplace_back(&FilterPipeline::RunStage, this, i);
+	mThreads.emplace_back(&FilterPipeline::RunSink, this);
+}
+
+void Grafkit::FilterPipeline::Write(const char * buffer, size_t length)
+{
+	if (mClosed) { throw std::runtime_error("FilterPipeline is closed"); }
+	if (mFailed) RethrowError();
+	if (!mStarted) Start();
+
+	while (length > 0)
+	{
+		const auto take = std::min(length, mOptions.blockSize - mCurrent.data.size());
+		mCurrent.data.insert(mCurrent.data.end(), buffer, buffer + take);
+		buffer += take;
+		length -= take;
+		if (mCurrent.data.size() == mOptions.blockSize) Dispatch();
+	}
+}
+
+void Grafkit::FilterPipeline::Dispatch()
+{
+	if (!mOptions.parallel)
+	{
+		try
+		{
+			for (auto & stage : mStages) stage->Process(mCurrent);
+			mSink.Write(mCurrent.data.data(), mCurrent.data.size());
+			if (!mSink.IsSuccess()) { throw std::runtime_error("FilterPipeline failed to write to its sink"); }
+		}
+		catch (...)
+		{
+			Fail(std::current_exception());
+			throw;
+		}
+		mCurrent.data.clear();
+		return;
+	}
+
+	// Hand the block over and carry on with a free one; waits here if all of them are in flight
+	if (!mQueues.front()->Push(std::move(mCurrent)) || !mFreeBlocks->Pop(mCurrent)) RethrowError();
+	mCurrent.data.clear();
+	mCurrent.last = false;
+}
+
+void Grafkit::FilterPipeline::RunStage(const size_t index)
+{
+	try
+	{
+		FilterBlock block;
+		while (mQueues[index]->Pop(block))
+		{
+			mStages[index]->Process(block);
+			if (!mQueues[index + 1]->Push(std::move(block))) return;
+		}
+		mQueues[index + 1]->Finish();
+	}
+	catch (...)
+	{
+		Fail(std::current_exception());
+	}
+}
+
+void Grafkit::FilterPipeline::RunSink()
+{
+	try
+	{
+		FilterBlock block;
+		while (mQueues.back()->Pop(block))
+		{
+			mSink.Write(block.data.data(), block.data.size());
+			if (!mSink.IsSuccess()) { throw std::runtime_error("FilterPipeline failed to write to its sink"); }
+			block.data.clear();
+			block.last = false;
+			if (!mFreeBlocks->Push(std::move(block))) return;
+		}
+	}
+	catch (...)
+	{
+		Fail(std::current_exception());
+	}
+}
+
+void Grafkit::FilterPipeline::Fail(std::exception_ptr error)
+{
+	{
+		std::lock_guard lock(mErrorMutex);
+		if (!mError) mError = std::move(error);
+	}
+	mFailed = true;
+	for (auto & queue : mQueues) queue->Abort();
+	if (mFreeBlocks) mFreeBlocks->Abort();
+}
+
+void Grafkit::FilterPipeline::RethrowError()
+{
+	std::lock_guard lock(mErrorMutex);
+	if (mError) std::rethrow_exception(mError);
+	throw std::runtime_error("FilterPipeline failed");
+}
+
+void Grafkit::FilterPipeline::Close()
+{
+	if (mClosed) return;
+	mClosed = true;
+
+	// The block that failed is still the current one in serial mode, it must not go through the stages again
+	if (mFailed)
+	{
+		for (auto & thread : mThreads) thread.join();
+		mThreads.clear();
+		RethrowError();
+	}
+	if (!mStarted) Start();
+
+	if (!mOptions.parallel)
+	{
+		mCurrent.last = true;
+		Dispatch();
+		return;
+	}
+
+	mCurrent.last = true;
+	if (mQueues.front()->Push(std::move(mCurrent))) mQueues.front()->Finish();
+	for (auto & thread : mThreads) thread.join();
+	mThreads.clear();
+	if (mFailed) RethrowError();
+}
+
+// --- Stages
+
+uint32_t Grafkit::Crc32Stage::Update(uint32_t crc, const char * data, const size_t length)
+{
+	for (size_t i = 0; i < length; ++i) crc = (crc >> 8) ^ Utils::crc_table_b[(crc ^ static_cast<unsigned char>(data[i])) & 0xff];
+	return crc;
+}
+
+void Grafkit::Crc32Stage::Process(FilterBlock & block)
+{
+	mState = Update(mState, block.data.data(), block.data.size());
+	if (block.last && mAppend)
+	{
+		const auto value = Value();
+		for (int i = 0; i < 4; ++i) block.data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+}
+
+void Grafkit::RateLimitStage::Process(FilterBlock & block)
+{
+	if (mBytes == 0) mStart = std::chrono::steady_clock::now();
+	mBytes += block.data.size();
+	if (mBytesPerSecond <= 0) return;
+
+	// Due time of the bytes passed so far at the given rate
+	const auto due = mStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(mBytes) / mBytesPerSecond));
+	std::this_thread::sleep_until(due);
+}
@@ -0,0 +1,141 @@
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <Serialization/GatherStream.h>
+//
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+#ifdef IOV_MAX
+	constexpr size_t maxIovecs = IOV_MAX;
+#else
+	constexpr size_t maxIovecs = 1024;
+#endif
+} // namespace
+
+Grafkit::GatherWriteStream::GatherWriteStream(const std::string & path, const GatherWriteOptions & options) : mOptions(options)
+{
+	mFd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (mFd < 0) { throw std::runtime_error("Cannot open file " + path + ": " + std::strerror(errno)); }
+	mOwnsFd = true;
+	mBuffer.reserve(std::max<size_t>(mOptions.coalesceBufferSize, 1));
+}
+
+Grafkit::GatherWriteStream::GatherWriteStream(const int fd, const GatherWriteOptions & options) : mOptions(options), mFd(fd)
+{
+	if (mFd < 0) { throw std::runtime_error("Invalid file descriptor"); }
+	mBuffer.reserve(std::max<size_t>(mOptions.coalesceBufferSize, 1));
+}
+
+Grafkit::GatherWriteStream::~GatherWriteStream() noexcept
+{
+	try
+	{
+		Flush();
+	}
+	catch (...)
+	{
+	}
+	if (mOwnsFd) close(mFd);
+}
+
+void Grafkit::GatherWriteStream::Write(const char * buffer, const size_t length)
+{
+	if (!mSuccess) { throw std::runtime_error("GatherWriteStream failed to write"); }
+	if (length == 0) return;
+
+	if (mBuffer.size() + length > mBuffer.capacity()) Flush();
+
+	// Too large to coalesce: goes out right away, straight from the caller's buffer
+	if (length > mBuffer.capacity())
+	{
+		mIovecs.push_back({const_cast<char *>(buffer), length});
+		Flush();
+		return;
+	}
+	Append(buffer, length);
+}
+
+void Grafkit::GatherWriteStream::WriteBorrowed(const char * buffer, const size_t length)
+{
+	if (length < mOptions.borrowThreshold)
+	{
+		Write(buffer, length);
+		return;
+	}
+	if (!mSuccess) { throw std::runtime_error("GatherWriteStream failed to write"); }
+
+	mIovecs.push_back({const_cast<char *>(buffer), length});
+	mBorrowedBytes += length;
+	mHasBorrowed = true;
+	if (mIovecs.size() >= maxIovecs) Flush();
+}
+
+void Grafkit::GatherWriteStream::ReleaseBorrowed()
+{
+	if (mHasBorrowed) Flush();
+}
+
+void Grafkit::GatherWriteStream::Append(const char * buffer, const size_t length)
+{
+	char * const start = mBuffer.data() + mBuffer.size();
+	mBuffer.insert(mBuffer.end(), buffer, buffer + length);
+	mCopiedBytes += length;
+
+	// Consecutive small writes share one iovec
+	if (!mIovecs.empty() && static_cast<char *>(mIovecs.back().iov_base) + mIovecs.back().iov_len == start)
+		mIovecs.back().iov_len += length;
+	else
+		mIovecs.push_back({start, length});
+
+	if (mIovecs.size() >= maxIovecs) Flush();
+}
+
+void Grafkit::GatherWriteStream::Flush()
+{
+	size_t index = 0;
+	while (index < mIovecs.size())
+	{
+		const auto count = std::min(mIovecs.size() - index, maxIovecs);
+		const auto written = writev(mFd, mIovecs.data() + index, static_cast<int>(count));
+		++mWritevCalls;
+		if (written < 0)
+		{
+			if (errno == EINTR) continue;
+			const int error = errno;
+			mSuccess = false;
+			mIovecs.clear();
+			mBuffer.clear();
+			mHasBorrowed = false;
+			throw std::runtime_error(std::string("writev failed: ") + std::strerror(error));
+		}
+
+		// Partial writes: skip what went out, trim the entry that went out partially
+		auto left = static_cast<size_t>(written);
+		while (left > 0 && index < mIovecs.size())
+		{
+			auto & entry = mIovecs[index];
+			if (left >= entry.iov_len)
+			{
+				left -= entry.iov_len;
+				++index;
+			}
+			else
+			{
+				entry.iov_base = static_cast<char *>(entry.iov_base) + left;
+				entry.iov_len -= left;
+				left = 0;
+			}
+		}
+	}
+	mIovecs.clear();
+	mBuffer.clear();
+	mHasBorrowed = false;
+}
+
+#endif
@@ -1,17 +1,60 @@
+#include <algorithm>
 #include <iostream>
+#include <string_view>
 #include <Serialization/Json.h>
 
-Grafkit::Json Grafkit::Serializer::JsonAdapter::ParseJson(IStream & stream)
+template <class JsonT> JsonT Grafkit::Serializer::BasicJsonAdapter<JsonT>::ParseJson(IStream & stream, const Utils::Utf8::EValidation validation)
 {
 	if (!stream) { throw std::runtime_error("Invalid stream"); }
 	StreamData outBuffer{};
 	if (!stream.ReadAll(outBuffer)) { throw std::runtime_error("Cannot read stream"); }
-	return Json::parse(outBuffer); // TODO: stream can be passed directly as well
+	if (validation == Utils::Utf8::EValidation::Replace)
+	{
+		const std::string_view text(reinterpret_cast<const char *>(outBuffer.data()), outBuffer.size());
+		if (!Utils::Utf8::IsValid(text)) return JsonT::parse(Utils::Utf8::ReplaceInvalid(text));
+	}
+	return JsonT::parse(outBuffer); // TODO: stream can be passed directly as well
 }
 
-void Grafkit::Serializer::JsonAdapter::DumpJson(IStream & stream, const Json & json)
+template <class JsonT> void Grafkit::Serializer::BasicJsonAdapter<JsonT>::DumpJson(IStream & stream, const JsonT & json)
 {
 	if (!stream) { throw std::runtime_error("Invalid stream"); }
 	const auto jsonData = json.dump();
 	stream.Write(jsonData.c_str(), jsonData.size());
+	if (!stream) { throw std::runtime_error("Cannot write stream"); }
 }
+
+template <class JsonT>
+void Grafkit::Serializer::BasicJsonAdapter<JsonT>::DumpJson(IStream & stream, const JsonT & json, ThreadPool & pool, const size_t minElements)
+{
+	if (!stream) { throw std::runtime_error("Invalid stream"); }
+	if (!json.is_array() || json.size() < std::max<size_t>(minElements, 1))
+	{
+		DumpJson(stream, json);
+		return;
+	}
+
+	// A compact array is its compact elements, comma separated in brackets
+	// Every block is dumped before the first byte is written, so a throwing element leaves the stream untouched like the sequential dump does
+	constexpr size_t blockElements = 4096;
+	const auto count = json.size();
+	std::vector<std::string> blocks((count + blockElements - 1) / blockElements);
+	pool.ParallelFor(blocks.size(), [&](const size_t i) {
+		auto & buffer = blocks[i];
+		const auto begin = i * blockElements;
+		const auto end = std::min(count, begin + blockElements);
+		for (auto element = begin; element < end; ++element)
+		{
+			if (element > 0) buffer.push_back(',');
+			buffer += json[element].dump();
+		}
+	});
+
+	stream.Write("[", 1);
+	for (const auto & block : blocks) stream.Write(block.data(), block.size());
+	stream.Write("]", 1);
+	if (!stream) { throw std::runtime_error("Cannot write stream"); }
+}
+
+template class Grafkit::Serializer::BasicJsonAdapter<Grafkit::Json>;
+template class Grafkit::Serializer::BasicJsonAdapter<Grafkit::ArenaJson>;
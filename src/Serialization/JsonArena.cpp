@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <new>
+#include <Serialization/JsonArena.h>
+
+namespace
+{
+	thread_local Grafkit::JsonArena * currentArena = nullptr;
+
+	// Blocks double in size up to this, so a large DOM takes a few dozen of them
+	constexpr size_t maxBlockSize = 64 << 20;
+} // namespace
+
+Grafkit::JsonArena::JsonArena(const size_t initialBlockSize) : mNextBlockSize(std::max<size_t>(initialBlockSize, 256)), mPrevious(currentArena)
+{
+	currentArena = this;
+}
+
+Grafkit::JsonArena::~JsonArena() noexcept
+{
+	// Arenas end in reverse order of their creation on a thread
+	currentArena = mPrevious;
+}
+
+void * Grafkit::JsonArena::Allocate(const size_t size, const size_t alignment)
+{
+	if (!mBlocks.empty())
+	{
+		auto & block = mBlocks.back();
+		const auto offset = (mUsed + alignment - 1) & ~(alignment - 1);
+		if (offset + size <= block.size)
+		{
+			mUsed = offset + size;
+			mAllocated += size;
+			return block.data.get() + offset;
+		}
+	}
+
+	// New block, large enough for oversized requests; operator new[] aligns for any fundamental type
+	if (alignment > alignof(std::max_align_t)) { throw std::bad_alloc(); }
+	const auto blockSize = std::max(mNextBlockSize, size);
+	mBlocks.push_back({std::make_unique<std::byte[]>(blockSize), blockSize});
+	mNextBlockSize = std::min(mNextBlockSize * 2, maxBlockSize);
+	mReserved += blockSize;
+	mUsed = size;
+	mAllocated += size;
+	return mBlocks.back().data.get();
+}
+
+bool Grafkit::JsonArena::Owns(const void * pointer) const
+{
+	const auto * p = static_cast<const std::byte *>(pointer);
+	// Recent blocks first, they are the large ones
+	return std::any_of(mBlocks.rbegin(), mBlocks.rend(), [p](const Block & block) { return p >= block.data.get() && p < block.data.get() + block.size; });
+}
+
+Grafkit::JsonArena * Grafkit::JsonArena::Current() { return currentArena; }
@@ -0,0 +1,313 @@
+#include <cstring>
+#include <limits>
+#include <Serialization/LazyJson.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// One bit per byte of a 64 byte block
+	struct BlockMasks
+	{
+		uint64_t quote = 0;
+		uint64_t backslash = 0;
+		uint64_t structural = 0; // { } [ ] : ,
+		uint64_t whitespace = 0;
+	};
+
+#if defined(__AVX2__)
+	uint64_t Equal(const __m256i lo, const __m256i hi, const char c)
+	{
+		const auto needle = _mm256_set1_epi8(c);
+		const auto low = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle)));
+		const auto high = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle)));
+		return low | (static_cast<uint64_t>(high) << 32);
+	}
+
+	BlockMasks Classify(const char * block)
+	{
+		const auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+		const auto hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+		BlockMasks masks;
+		masks.quote = Equal(lo, hi, '"');
+		masks.backslash = Equal(lo, hi, '\\');
+		masks.structural = Equal(lo, hi, '{') | Equal(lo, hi, '}') | Equal(lo, hi, '[') | Equal(lo, hi, ']') | Equal(lo, hi, ':') | Equal(lo, hi, ',');
+		masks.whitespace = Equal(lo, hi, ' ') | Equal(lo, hi, '\t') | Equal(lo, hi, '\n') | Equal(lo, hi, '\r');
+		return masks;
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	uint64_t Equal(const __m128i (&parts)[4], const char c)
+	{
+		const auto needle = _mm_set1_epi8(c);
+		uint64_t result = 0;
+		for (int i = 0; i < 4; ++i) result |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(parts[i], needle)))) << (16 * i);
+		return result;
+	}
+
+	BlockMasks Classify(const char * block)
+	{
+		__m128i parts[4];
+		for (int i = 0; i < 4; ++i) parts[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+		BlockMasks masks;
+		masks.quote = Equal(parts, '"');
+		masks.backslash = Equal(parts, '\\');
+		masks.structural = Equal(parts, '{') | Equal(parts, '}') | Equal(parts, '[') | Equal(parts, ']') | Equal(parts, ':') | Equal(parts, ',');
+		masks.whitespace = Equal(parts, ' ') | Equal(parts, '\t') | Equal(parts, '\n') | Equal(parts, '\r');
+		return masks;
+	}
+#else
+	BlockMasks Classify(const char * block)
+	{
+		BlockMasks masks;
+		for (int i = 0; i < 64; ++i)
+		{
+			const uint64_t bit = uint64_t(1) << i;
+			switch (block[i])
+			{
+			case '"': masks.quote |= bit; break;
+			case '\\': masks.backslash |= bit; break;
+			case '{':
+			case '}':
+			case '[':
+			case ']':
+			case ':':
+			case ',': masks.structural |= bit; break;
+			case ' ':
+			case '\t':
+			case '\n':
+			case '\r': masks.whitespace |= bit; break;
+			default: break;
+			}
+		}
+		return masks;
+	}
+#endif
+
+	/**
+	 * Characters escaped by a backslash: the ones after an odd-length run of backslashes.
+	 * prevEscaped carries whether the first character of the next block is escaped.
+	 */
+	uint64_t FindEscaped(uint64_t backslash, uint64_t & prevEscaped)
+	{
+		if (backslash == 0)
+		{
+			const auto escaped = prevEscaped;
+			prevEscaped = 0;
+			return escaped;
+		}
+
+		constexpr uint64_t evenBits = 0x5555555555555555ull;
+		backslash &= ~prevEscaped;
+		const auto followsEscape = backslash << 1 | prevEscaped;
+		// Runs starting on odd positions: adding the run to its start carries out at its end
+		const auto oddStarts = backslash & ~evenBits & ~followsEscape;
+		const auto sum = oddStarts + backslash;
+		prevEscaped = sum < oddStarts ? 1 : 0;
+		const auto invert = sum << 1;
+		return (evenBits ^ invert) & followsEscape;
+	}
+
+	// Bit i is the xor of the bits 0..i
+	uint64_t PrefixXor(uint64_t bits)
+	{
+		bits ^= bits << 1;
+		bits ^= bits << 2;
+		bits ^= bits << 4;
+		bits ^= bits << 8;
+		bits ^= bits << 16;
+		bits ^= bits << 32;
+		return bits;
+	}
+
+	int CountTrailingZeros(const uint64_t bits)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctzll(bits);
+#else
+		int count = 0;
+		while (!((bits >> count) & 1)) ++count;
+		return count;
+#endif
+	}
+
+	bool IsWhitespace(const char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+} // namespace
+
+Grafkit::LazyJsonDocument::LazyJsonDocument(const std::string_view text) : mText(text) { Build(); }
+
+Grafkit::LazyJsonDocument::LazyJsonDocument(std::string && text) : mOwned(std::move(text)), mText(mOwned) { Build(); }
+
+void Grafkit::LazyJsonDocument::Build()
+{
+	if (mText.size() >= std::numeric_limits<uint32_t>::max()) { throw std::runtime_error("JSON document is too large to index"); }
+
+	// Stage 1: every 64 byte block is classified at once; the tail is padded with spaces
+	uint64_t prevEscaped = 0;
+	uint64_t prevInString = 0;
+	uint64_t prevSeparator = 1; // the document start counts as whitespace
+	const auto size = mText.size();
+	for (size_t offset = 0; offset < size; offset += 64)
+	{
+		char padded[64];
+		const char * block = mText.data() + offset;
+		if (size - offset < 64)
+		{
+			std::memset(padded, ' ', sizeof(padded));
+			std::memcpy(padded, block, size - offset);
+			block = padded;
+		}
+
+		const auto masks = Classify(block);
+		const auto escaped = FindEscaped(masks.backslash, prevEscaped);
+		const auto quotes = masks.quote & ~escaped;
+		// Opening quotes and the string content are inside, closing quotes are not
+		const auto inString = PrefixXor(quotes) ^ prevInString;
+		prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+		const auto structural = masks.structural & ~inString;
+		// Numbers and literals start after whitespace or a structural character
+		const auto separator = (masks.structural | masks.whitespace) & ~inString;
+		const auto scalar = ~(masks.structural | masks.whitespace | masks.quote) & ~inString;
+		const auto scalarStarts = scalar & (separator << 1 | prevSeparator);
+		prevSeparator = separator >> 63;
+
+		auto bits = structural | (quotes & inString) | scalarStarts;
+		if (size - offset < 64) bits &= (uint64_t(1) << (size - offset)) - 1;
+		while (bits)
+		{
+			mIndex.push_back(static_cast<uint32_t>(offset + static_cast<size_t>(CountTrailingZeros(bits))));
+			bits &= bits - 1;
+		}
+	}
+	if (prevInString) { throw std::runtime_error("malformed data - unterminated string"); }
+	if (mIndex.empty()) { throw std::runtime_error("malformed data - empty document"); }
+
+	// Stage 2: brackets are paired up
+	mMatch.assign(mIndex.size(), 0);
+	std::vector<uint32_t> open;
+	for (uint32_t entry = 0; entry < mIndex.size(); ++entry)
+	{
+		const auto c = mText[mIndex[entry]];
+		if (c == '{' || c == '[') { open.push_back(entry); }
+		else if (c == '}' || c == ']')
+		{
+			if (open.empty() || mText[mIndex[open.back()]] != (c == '}' ? '{' : '[')) { throw std::runtime_error("malformed data - unbalanced brackets"); }
+			mMatch[open.back()] = entry;
+			open.pop_back();
+		}
+	}
+	if (!open.empty()) { throw std::runtime_error("malformed data - unbalanced brackets"); }
+}
+
+// --- Values
+
+Grafkit::EJsonType Grafkit::LazyJsonValue::Type() const
+{
+	switch (Front())
+	{
+	case '{': return EJsonType::Object;
+	case '[': return EJsonType::Array;
+	case '"': return EJsonType::String;
+	case 't':
+	case 'f': return EJsonType::Bool;
+	case 'n': return EJsonType::Null;
+	default: return EJsonType::Number;
+	}
+}
+
+std::string_view Grafkit::LazyJsonValue::Raw() const
+{
+	const auto & index = mDocument->mIndex;
+	const auto text = mDocument->mText;
+	const auto begin = index[mEntry];
+	const auto c = text[begin];
+	if (c == '{' || c == '[') return text.substr(begin, index[mDocument->mMatch[mEntry]] + 1 - begin);
+
+	// Scalars end where the next entry starts, less the whitespace in between
+	size_t end = mEntry + 1 < index.size() ? index[mEntry + 1] : text.size();
+	while (end > begin + 1 && IsWhitespace(text[end - 1])) --end;
+	return text.substr(begin, end - begin);
+}
+
+uint32_t Grafkit::LazyJsonValue::FirstChild() const
+{
+	const auto c = Front();
+	if (c != '{' && c != '[') { throw std::runtime_error("malformed data - container expected"); }
+	return mEntry + 1;
+}
+
+uint32_t Grafkit::LazyJsonValue::NextSibling(const uint32_t entry) const
+{
+	// The value is followed by a comma, or by the closing bracket of the container
+	const auto next = Skip(entry);
+	if (next == End()) return next;
+	if (next > End() || mDocument->mText[mDocument->mIndex[next]] != ',') { throw std::runtime_error("malformed data - separator expected"); }
+	return next + 1;
+}
+
+std::string_view Grafkit::LazyJsonValue::RawKey(const uint32_t entry) const
+{
+	const auto & index = mDocument->mIndex;
+	const auto text = mDocument->mText;
+	if (entry + 2 >= End() || text[index[entry]] != '"' || text[index[entry + 1]] != ':') { throw std::runtime_error("malformed data - key expected"); }
+
+	auto end = index[entry + 1];
+	while (end > index[entry] + 1 && IsWhitespace(text[end - 1])) --end;
+	if (end < index[entry] + 2 || text[end - 1] != '"') { throw std::runtime_error("malformed data - key expected"); }
+	return text.substr(index[entry] + 1, end - index[entry] - 2);
+}
+
+bool Grafkit::LazyJsonValue::KeyEquals(const std::string_view rawKey, const std::string_view key)
+{
+	if (rawKey.find('\\') == std::string_view::npos) return rawKey == key;
+	const auto quoted = "\"" + std::string(rawKey) + "\"";
+	return Json::parse(quoted).get<std::string>() == key;
+}
+
+std::optional<Grafkit::LazyJsonValue> Grafkit::LazyJsonValue::Find(const std::string_view key) const
+{
+	if (Type() != EJsonType::Object) { throw std::runtime_error("malformed data - object expected"); }
+	for (auto entry = FirstChild(); entry != End(); entry = NextSibling(entry + 2))
+		if (KeyEquals(RawKey(entry), key)) return LazyJsonValue(*mDocument, entry + 2);
+	return std::nullopt;
+}
+
+Grafkit::LazyJsonValue Grafkit::LazyJsonValue::operator[](const std::string_view key) const
+{
+	const auto value = Find(key);
+	if (!value) { throw std::runtime_error("Missing member: " + std::string(key)); }
+	return *value;
+}
+
+Grafkit::LazyJsonValue Grafkit::LazyJsonValue::operator[](const size_t index) const
+{
+	if (Type() != EJsonType::Array) { throw std::runtime_error("malformed data - array expected"); }
+	size_t i = 0;
+	for (auto entry = FirstChild(); entry != End(); entry = NextSibling(entry), ++i)
+		if (i == index) return LazyJsonValue(*mDocument, entry);
+	throw std::runtime_error("Index out of range");
+}
+
+size_t Grafkit::LazyJsonValue::Size() const
+{
+	size_t count = 0;
+	if (Type() == EJsonType::Object) { ForEachMember([&](std::string_view, const LazyJsonValue &) { ++count; }); }
+	else
+	{
+		ForEachElement([&](const LazyJsonValue &) { ++count; });
+	}
+	return count;
+}
+
+std::string Grafkit::LazyJsonValue::GetString() const
+{
+	const auto raw = Raw();
+	if (raw.size() < 2 || raw.front() != '"' || raw.back() != '"') { throw std::runtime_error("malformed data - string expected"); }
+	const auto content = raw.substr(1, raw.size() - 2);
+	if (content.find('\\') == std::string_view::npos) return std::string(content);
+	return Parse().get<std::string>();
+}
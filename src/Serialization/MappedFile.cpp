@@ -0,0 +1,62 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <Serialization/MappedFile.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Grafkit::MappedFile::MappedFile(const std::string & path)
+{
+#ifndef _WIN32
+	const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) { throw std::runtime_error("Cannot open file " + path + ": " + std::strerror(errno)); }
+
+	struct stat info = {};
+	if (fstat(fd, &info) != 0)
+	{
+		const auto error = errno;
+		close(fd);
+		throw std::runtime_error("Cannot open file " + path + ": " + std::strerror(error));
+	}
+
+	mSize = static_cast<size_t>(info.st_size);
+	if (mSize > 0)
+	{
+		void * const data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			const auto error = errno;
+			close(fd);
+			throw std::runtime_error("Cannot map file " + path + ": " + std::strerror(error));
+		}
+		// Readers go through it front to back, each in its own part of the file
+		madvise(data, mSize, MADV_SEQUENTIAL);
+		mData = static_cast<const char *>(data);
+		mMapped = true;
+	}
+	// The mapping outlives the descriptor
+	close(fd);
+#else
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) { throw std::runtime_error("Cannot open file " + path); }
+	mBuffer.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(mBuffer.data(), static_cast<std::streamsize>(mBuffer.size()));
+	if (!file) { throw std::runtime_error("Cannot read file " + path); }
+	mData = mBuffer.data();
+	mSize = mBuffer.size();
+#endif
+}
+
+Grafkit::MappedFile::~MappedFile() noexcept
+{
+#ifndef _WIN32
+	if (mMapped) munmap(const_cast<char *>(mData), mSize);
+#endif
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <Serialization/RingStream.h>
+
+namespace
+{
+	size_t RoundUpToPowerOfTwo(const size_t value)
+	{
+		size_t result = 1;
+		while (result < value) result <<= 1;
+		return result;
+	}
+
+	// Spins briefly, then yields, then sleeps, so a stalled side does not burn a core for long
+	void Backoff(unsigned & round)
+	{
+		if (round >= 128) std::this_thread::sleep_for(std::chrono::microseconds(50));
+		else if (round >= 64) std::this_thread::yield();
+		++round;
+	}
+} // namespace
+
+Grafkit::RingStream::RingStream(const RingStreamOptions & options)
+	: mCapacity(RoundUpToPowerOfTwo(std::max<size_t>(options.capacity, 64)))
+	, mMask(mCapacity - 1)
+	, mBlocking(options.blocking)
+	, mBuffer(new char[mCapacity])
+{
+}
+
+// --- Producer side
+
+void Grafkit::RingStream::Write(const char * buffer, const size_t length)
+{
+	if (mFrameDropped || length == 0) return;
+	if (mWritePosition + length - mFrameStart > mCapacity)
+	{
+		mFrameDropped = true;
+		throw std::runtime_error("Frame exceeds the capacity of the RingStream");
+	}
+
+	if (!WaitForSpace(length))
+	{
+		// Non-blocking and full: the rest of the frame goes nowhere, Commit drops it
+		mFrameDropped = true;
+		return;
+	}
+	CopyIn(mWritePosition, buffer, length);
+	mWritePosition += length;
+}
+
+bool Grafkit::RingStream::Commit()
+{
+	if (mFrameDropped)
+	{
+		mWritePosition = mFrameStart;
+		mFrameDropped = false;
+		return false;
+	}
+	mHead.store(mWritePosition, std::memory_order_release);
+	mFrameStart = mWritePosition;
+	return true;
+}
+
+void Grafkit::RingStream::Close() { mClosed.store(true, std::memory_order_release); }
+
+bool Grafkit::RingStream::WaitForSpace(const size_t length)
+{
+	if (mWritePosition + length - mCachedTail <= mCapacity) return true;
+	mCachedTail = mTail.load(std::memory_order_acquire);
+	if (mWritePosition + length - mCachedTail <= mCapacity) return true;
+	if (!mBlocking) return false;
+
+	mProducerStalls.fetch_add(1, std::memory_order_relaxed);
+	unsigned round = 0;
+	while (true)
+	{
+		if (mClosed.load(std::memory_order_acquire)) { throw std::runtime_error("RingStream is closed"); }
+		Backoff(round);
+		mCachedTail = mTail.load(std::memory_order_acquire);
+		if (mWritePosition + length - mCachedTail <= mCapacity) return true;
+	}
+}
+
+void Grafkit::RingStream::CopyIn(const uint64_t position, const char * buffer, const size_t length)
+{
+	const size_t offset = position & mMask;
+	const auto first = std::min(length, mCapacity - offset);
+	std::memcpy(mBuffer.get() + offset, buffer, first);
+	std::memcpy(mBuffer.get(), buffer + first, length - first);
+}
+
+// --- Consumer side
+
+void Grafkit::RingStream::Read(char * const & buffer, const size_t length)
+{
+	if (length == 0) return;
+	if (!WaitForData(length))
+	{
+		mReadFailed.store(true, std::memory_order_relaxed);
+		return;
+	}
+	CopyOut(mReadPosition, buffer, length);
+	mReadPosition += length;
+
+	// Handing back space in batches keeps the producer's cache line quiet
+	if (mReadPosition - mPublishedTail >= mCapacity / 8) PublishTail();
+}
+
+bool Grafkit::RingStream::HasFrame()
+{
+	if (mCachedHead > mReadPosition) return true;
+	PublishTail();
+	mCachedHead = mHead.load(std::memory_order_acquire);
+	return mCachedHead > mReadPosition;
+}
+
+bool Grafkit::RingStream::WaitForFrame()
+{
+	unsigned round = 0;
+	bool stalled = false;
+	while (!HasFrame())
+	{
+		// Head is re-read after seeing the close flag, so frames committed right before closing are not lost
+		if (mClosed.load(std::memory_order_acquire) && !HasFrame()) return false;
+		if (!stalled) mConsumerStalls.fetch_add(1, std::memory_order_relaxed);
+		stalled = true;
+		Backoff(round);
+	}
+	return true;
+}
+
+bool Grafkit::RingStream::WaitForData(const size_t length)
+{
+	if (mCachedHead - mReadPosition >= length) return true;
+	mCachedHead = mHead.load(std::memory_order_acquire);
+	if (mCachedHead - mReadPosition >= length) return true;
+	if (!mBlocking) return false;
+
+	PublishTail();
+	mConsumerStalls.fetch_add(1, std::memory_order_relaxed);
+	unsigned round = 0;
+	while (true)
+	{
+		const bool closed = mClosed.load(std::memory_order_acquire);
+		mCachedHead = mHead.load(std::memory_order_acquire);
+		if (mCachedHead - mReadPosition >= length) return true;
+		if (closed) return false;
+		Backoff(round);
+	}
+}
+
+void Grafkit::RingStream::PublishTail()
+{
+	if (mPublishedTail == mReadPosition) return;
+	mTail.store(mReadPosition, std::memory_order_release);
+	mPublishedTail = mReadPosition;
+}
+
+bool Grafkit::RingStream::ReadAll(StreamData & outBuffer)
+{
+	while (WaitForFrame())
+	{
+		const size_t length = mCachedHead - mReadPosition;
+		const auto offset = outBuffer.size();
+		outBuffer.resize(offset + length);
+		CopyOut(mReadPosition, reinterpret_cast<char *>(outBuffer.data() + offset), length);
+		mReadPosition += length;
+	}
+	PublishTail();
+	return true;
+}
+
+void Grafkit::RingStream::CopyOut(const uint64_t position, char * buffer, const size_t length) const
+{
+	const size_t offset = position & mMask;
+	const auto first = std::min(length, mCapacity - offset);
+	std::memcpy(buffer, mBuffer.get() + offset, first);
+	std::memcpy(buffer + first, mBuffer.get(), length - first);
+}
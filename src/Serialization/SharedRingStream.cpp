@@ -0,0 +1,403 @@
+#ifdef __linux__
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <Serialization/SharedRingStream.h>
+//
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Layout of the segment: this header on its own page, the ring right after it.
+ * Positions are monotonic byte counters; the futex words are bumped whenever the matching position moves.
+ */
+struct Grafkit::SharedRingStream::Header
+{
+	Header(const uint64_t ringCapacity, const int32_t creator) : capacity(ringCapacity), creatorPid(creator) {}
+
+	std::atomic<uint64_t> magic{0}; // set last, once the creating side is done
+	uint64_t capacity;
+	std::atomic<int32_t> creatorPid; // set along with the header right after mapping, so a creator that died half way can be told apart
+
+	alignas(64) std::atomic<uint64_t> head{0}; // end of the last committed frame
+	std::atomic<uint32_t> headSignal{0};
+	std::atomic<uint32_t> consumerWaiting{0};
+
+	alignas(64) std::atomic<uint64_t> tail{0}; // end of the last frame the consumer finished
+	std::atomic<uint32_t> tailSignal{0};
+	std::atomic<uint32_t> producerWaiting{0};
+
+	alignas(64) std::atomic<int32_t> producerPid{0};
+	std::atomic<int32_t> consumerPid{0};
+	std::atomic<uint32_t> closed{0};
+};
+
+namespace
+{
+	constexpr uint64_t segmentMagic = 0x474b52494e470001; // "GKRING", version 1
+	constexpr size_t headerPageSize = 4096;
+	constexpr size_t frameHeaderSize = sizeof(uint64_t);
+	constexpr auto waitSlice = std::chrono::milliseconds(100);
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "Atomics in shared memory have to be lock-free");
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex words have to be plain 32 bit integers");
+
+	std::string ErrorText(const std::string & what, const int error) { return what + ": " + std::strerror(error); }
+
+	std::string SegmentName(const std::string & name) { return name.empty() || name[0] != '/' ? "/" + name : name; }
+
+	size_t RoundUpToPowerOfTwo(const size_t value)
+	{
+		size_t result = 1;
+		while (result < value) result <<= 1;
+		return result;
+	}
+
+	bool IsAlive(const int32_t pid) { return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH); }
+
+	void FutexWait(std::atomic<uint32_t> & word, const uint32_t expected)
+	{
+		timespec timeout{0, std::chrono::duration_cast<std::chrono::nanoseconds>(waitSlice).count()};
+		syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+	}
+
+	void FutexWake(std::atomic<uint32_t> & word) { syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0); }
+
+	// Bumps the futex word; only enters the kernel if the other side sleeps
+	void Signal(std::atomic<uint32_t> & word, const std::atomic<uint32_t> & waiting)
+	{
+		word.fetch_add(1);
+		if (waiting.load() > 0) FutexWake(word);
+	}
+
+	/**
+	 * Sleeps on the futex word until ready() holds, at most one wait slice.
+	 * The word is read before checking, so a Signal in between makes the wait return right away.
+	 */
+	template <typename Predicate> void SleepUnless(std::atomic<uint32_t> & word, std::atomic<uint32_t> & waiting, Predicate && ready)
+	{
+		const auto expected = word.load();
+		if (ready()) return;
+		waiting.fetch_add(1);
+		if (!ready()) FutexWait(word, expected);
+		waiting.fetch_sub(1);
+	}
+} // namespace
+
+Grafkit::SharedRingStream::SharedRingStream(const std::string & name, const ESharedRingRole role, const SharedRingOptions & options) : mRole(role)
+{
+	Attach(SegmentName(name), options);
+	try
+	{
+		ClaimRole();
+	}
+	catch (...)
+	{
+		munmap(mMapping, mMappingSize);
+		close(mFd);
+		throw;
+	}
+}
+
+Grafkit::SharedRingStream::~SharedRingStream() noexcept
+{
+	// A frame read to the end is done with; one read halfway is delivered again to the next consumer
+	if (mRole == ESharedRingRole::Consumer && mReadPosition == mFrameEnd) FinishFrame();
+
+	auto & slot = mRole == ESharedRingRole::Producer ? mHeader->producerPid : mHeader->consumerPid;
+	int32_t self = getpid();
+	slot.compare_exchange_strong(self, 0);
+	munmap(mMapping, mMappingSize);
+	close(mFd);
+}
+
+void Grafkit::SharedRingStream::Remove(const std::string & name) { shm_unlink(SegmentName(name).c_str()); }
+
+void Grafkit::SharedRingStream::Attach(const std::string & name, const SharedRingOptions & options)
+{
+	mFd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	if (mFd >= 0) { Create(name, options); }
+	else
+	{
+		if (errno != EEXIST) { throw std::runtime_error(ErrorText("Cannot create shared memory " + name, errno)); }
+		mFd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+		if (mFd < 0) { throw std::runtime_error(ErrorText("Cannot open shared memory " + name, errno)); }
+		if (!Open(name, options)) Create(name, options);
+	}
+	mRing = static_cast<char *>(mMapping) + headerPageSize;
+	mMask = mCapacity - 1;
+}
+
+void Grafkit::SharedRingStream::Create(const std::string & name, const SharedRingOptions & options)
+{
+	// Size it, set up the header, then publish the magic
+	mCapacity = RoundUpToPowerOfTwo(std::max<size_t>(options.capacity, headerPageSize));
+	mMappingSize = headerPageSize + mCapacity;
+	if (ftruncate(mFd, static_cast<off_t>(mMappingSize)) != 0)
+	{
+		const int error = errno;
+		close(mFd);
+		shm_unlink(name.c_str());
+		throw std::runtime_error(ErrorText("Cannot size shared memory " + name, error));
+	}
+	mMapping = mmap(nullptr, mMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+	if (mMapping == MAP_FAILED)
+	{
+		const int error = errno;
+		close(mFd);
+		shm_unlink(name.c_str());
+		throw std::runtime_error(ErrorText("Cannot map shared memory " + name, error));
+	}
+	// The pid goes in with the header itself: one taking over already holds it there, and it must not drop back to 0 meanwhile
+	mHeader = new (mMapping) Header(mCapacity, getpid());
+	mHeader->magic.store(segmentMagic, std::memory_order_release);
+}
+
+bool Grafkit::SharedRingStream::Open(const std::string & name, const SharedRingOptions & options)
+{
+	// The creating side may still be setting it up
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.attachTimeoutMs);
+	struct stat info = {};
+	while (true)
+	{
+		if (fstat(mFd, &info) == 0 && static_cast<size_t>(info.st_size) > headerPageSize)
+		{
+			if (!mMapping) mMapping = mmap(nullptr, headerPageSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+			if (mMapping == MAP_FAILED)
+			{
+				const int error = errno;
+				close(mFd);
+				throw std::runtime_error(ErrorText("Cannot map shared memory " + name, error));
+			}
+			auto & header = *static_cast<Header *>(mMapping);
+			if (header.magic.load(std::memory_order_acquire) == segmentMagic) break;
+
+			// A creator that died before publishing would keep everyone waiting; the first side to notice sets the segment up instead
+			int32_t creator = header.creatorPid.load();
+			if (creator != 0 && !IsAlive(creator) && header.creatorPid.compare_exchange_strong(creator, getpid()))
+			{
+				munmap(mMapping, headerPageSize);
+				mMapping = nullptr;
+				return false;
+			}
+		}
+		if (std::chrono::steady_clock::now() > deadline)
+		{
+			if (mMapping) munmap(mMapping, headerPageSize);
+			close(mFd);
+			throw std::runtime_error("Shared memory " + name + " is not a ring stream, or its creator did not finish setting it up");
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// The header comes from another process; its capacity has to match how the segment was sized
+	mCapacity = static_cast<Header *>(mMapping)->capacity;
+	munmap(mMapping, headerPageSize);
+	if (mCapacity < headerPageSize || (mCapacity & (mCapacity - 1)) != 0 || static_cast<size_t>(info.st_size) < headerPageSize + mCapacity)
+	{
+		close(mFd);
+		throw std::runtime_error("Shared memory " + name + " is not a ring stream");
+	}
+	mMappingSize = headerPageSize + mCapacity;
+	mMapping = mmap(nullptr, mMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+	if (mMapping == MAP_FAILED)
+	{
+		const int error = errno;
+		close(mFd);
+		throw std::runtime_error(ErrorText("Cannot map shared memory " + name, error));
+	}
+	mHeader = static_cast<Header *>(mMapping);
+	return true;
+}
+
+void Grafkit::SharedRingStream::ClaimRole()
+{
+	auto & slot = mRole == ESharedRingRole::Producer ? mHeader->producerPid : mHeader->consumerPid;
+	const int32_t self = getpid();
+	int32_t current = slot.load();
+	do
+	{
+		// Taking over from a process that died holding the role is the recovery path
+		if (current != 0 && current != self && IsAlive(current))
+		{ throw std::runtime_error(mRole == ESharedRingRole::Producer ? "Shared ring already has a producer" : "Shared ring already has a consumer"); }
+	} while (!slot.compare_exchange_weak(current, self));
+
+	// Resume from the last frame boundary; whatever a dead predecessor left half done is ignored
+	if (mRole == ESharedRingRole::Producer)
+	{
+		mWritePosition = mFrameStart = mHeader->head.load(std::memory_order_acquire);
+		// A close belongs to the producer that made it, the new one opens the stream again
+		mHeader->closed.store(0, std::memory_order_release);
+	}
+	else
+	{
+		mReadPosition = mFrameEnd = mHeader->tail.load(std::memory_order_acquire);
+	}
+}
+
+// --- Producer side
+
+void Grafkit::SharedRingStream::Write(const char * buffer, const size_t length)
+{
+	if (mRole != ESharedRingRole::Producer) { throw std::runtime_error("Can't write on the consumer side of a SharedRingStream"); }
+	if (mFrameDropped || length == 0) return;
+
+	if (!mInFrame)
+	{
+		// Room for the length, filled in on Commit
+		mFrameStart = mWritePosition;
+		WaitForSpace(frameHeaderSize);
+		mWritePosition += frameHeaderSize;
+		mInFrame = true;
+	}
+	if (mWritePosition + length - mFrameStart > mCapacity)
+	{
+		mFrameDropped = true;
+		throw std::runtime_error("Frame exceeds the capacity of the SharedRingStream");
+	}
+
+	WaitForSpace(length);
+	CopyIn(mWritePosition, buffer, length);
+	mWritePosition += length;
+}
+
+bool Grafkit::SharedRingStream::Commit()
+{
+	if (mFrameDropped)
+	{
+		mWritePosition = mFrameStart;
+		mInFrame = mFrameDropped = false;
+		return false;
+	}
+	if (!mInFrame) return true;
+
+	const uint64_t length = mWritePosition - mFrameStart - frameHeaderSize;
+	CopyIn(mFrameStart, reinterpret_cast<const char *>(&length), frameHeaderSize);
+	mHeader->head.store(mWritePosition, std::memory_order_release);
+	Signal(mHeader->headSignal, mHeader->consumerWaiting);
+	mInFrame = false;
+	return true;
+}
+
+void Grafkit::SharedRingStream::Close()
+{
+	mHeader->closed.store(1, std::memory_order_release);
+	Signal(mHeader->headSignal, mHeader->consumerWaiting);
+	Signal(mHeader->tailSignal, mHeader->producerWaiting);
+}
+
+void Grafkit::SharedRingStream::WaitForSpace(const size_t length)
+{
+	const auto fits = [&] { return mWritePosition + length - mHeader->tail.load(std::memory_order_acquire) <= mCapacity; };
+	// A missing or dead consumer is not an error: a new one can attach and drain the ring
+	while (!fits())
+	{
+		if (mHeader->closed.load(std::memory_order_acquire)) { throw std::runtime_error("SharedRingStream is closed"); }
+		SleepUnless(mHeader->tailSignal, mHeader->producerWaiting, fits);
+	}
+}
+
+void Grafkit::SharedRingStream::CopyIn(const uint64_t position, const char * buffer, const size_t length)
+{
+	const size_t offset = position & mMask;
+	const auto first = std::min(length, mCapacity - offset);
+	std::memcpy(mRing + offset, buffer, first);
+	std::memcpy(mRing, buffer + first, length - first);
+}
+
+// --- Consumer side
+
+void Grafkit::SharedRingStream::Read(char * const & buffer, size_t length)
+{
+	if (mRole != ESharedRingRole::Consumer) { throw std::runtime_error("Can't read on the producer side of a SharedRingStream"); }
+
+	size_t done = 0;
+	while (done < length)
+	{
+		if (mReadPosition == mFrameEnd && !WaitForFrame())
+		{
+			mReadFailed = true;
+			return;
+		}
+		const auto take = std::min<size_t>(length - done, mFrameEnd - mReadPosition);
+		CopyOut(mReadPosition, buffer + done, take);
+		mReadPosition += take;
+		done += take;
+	}
+}
+
+bool Grafkit::SharedRingStream::HasFrame() { return mReadPosition < mFrameEnd || mHeader->head.load(std::memory_order_acquire) > mFrameEnd; }
+
+bool Grafkit::SharedRingStream::WaitForFrame()
+{
+	FinishFrame();
+	if (!WaitForHead(mReadPosition)) return false;
+
+	// The length comes from the other process: the frame has to be committed in full, and fit in the ring
+	const uint64_t available = mHeader->head.load(std::memory_order_acquire) - mReadPosition;
+	uint64_t length = 0;
+	CopyOut(mReadPosition, reinterpret_cast<char *>(&length), frameHeaderSize);
+	if (available < frameHeaderSize || length > available - frameHeaderSize || length > mCapacity - frameHeaderSize)
+	{ throw std::runtime_error("malformed data - shared ring frame length"); }
+	mReadPosition += frameHeaderSize;
+	mFrameEnd = mReadPosition + length;
+	return true;
+}
+
+void Grafkit::SharedRingStream::FinishFrame()
+{
+	mReadPosition = mFrameEnd;
+	if (mHeader->tail.load(std::memory_order_relaxed) == mFrameEnd) return;
+	mHeader->tail.store(mFrameEnd, std::memory_order_release);
+	Signal(mHeader->tailSignal, mHeader->producerWaiting);
+}
+
+bool Grafkit::SharedRingStream::WaitForHead(const uint64_t position)
+{
+	const auto ready = [&] { return mHeader->head.load(std::memory_order_acquire) > position; };
+	while (!ready())
+	{
+		// Head is checked again after the producer is seen gone, frames committed right before are still read
+		const auto producer = mHeader->producerPid.load();
+		const bool gone = mHeader->closed.load(std::memory_order_acquire) || (producer != 0 && !IsAlive(producer));
+		if (gone) return ready();
+		SleepUnless(mHeader->headSignal, mHeader->consumerWaiting, ready);
+	}
+	return true;
+}
+
+bool Grafkit::SharedRingStream::ReadAll(StreamData & outBuffer)
+{
+	if (mRole != ESharedRingRole::Consumer) { throw std::runtime_error("Can't read on the producer side of a SharedRingStream"); }
+	while (mReadPosition < mFrameEnd || WaitForFrame())
+	{
+		const size_t length = mFrameEnd - mReadPosition;
+		const auto offset = outBuffer.size();
+		outBuffer.resize(offset + length);
+		CopyOut(mReadPosition, reinterpret_cast<char *>(outBuffer.data() + offset), length);
+		mReadPosition = mFrameEnd;
+	}
+	return true;
+}
+
+void Grafkit::SharedRingStream::CopyOut(const uint64_t position, char * buffer, const size_t length) const
+{
+	const size_t offset = position & mMask;
+	const auto first = std::min(length, mCapacity - offset);
+	std::memcpy(buffer, mRing + offset, first);
+	std::memcpy(buffer + first, mRing, length - first);
+}
+
+#endif
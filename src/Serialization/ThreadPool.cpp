@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <exception>
+#include <Serialization/ThreadPool.h>
+
+namespace
+{
+	// Index of the pool worker running on this thread, or none for outside threads
+	constexpr size_t noWorker = static_cast<size_t>(-1);
+	thread_local const Grafkit::ThreadPool * currentPool = nullptr;
+	thread_local size_t currentWorker = noWorker;
+} // namespace
+
+Grafkit::ThreadPool::ThreadPool(const size_t threadCount)
+{
+	const auto count = std::max<size_t>(threadCount, 1);
+	for (size_t i = 0; i < count; ++i) mWorkers.push_back(std::make_unique<Worker>());
+	for (size_t i = 0; i < count; ++i) mThreads.emplace_back(&ThreadPool::Run, this, i);
+}
+
+Grafkit::ThreadPool::~ThreadPool() noexcept
+{
+	{
+		std::lock_guard lock(mSleepMutex);
+		mStop = true;
+	}
+	mWake.notify_all();
+	for (auto & thread : mThreads) thread.join();
+}
+
+Grafkit::ThreadPool & Grafkit::ThreadPool::Default()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void Grafkit::ThreadPool::Push(const size_t worker, Task task)
+{
+	// Counted before it is visible, so the count never drops below zero
+	{
+		std::lock_guard lock(mSleepMutex);
+		++mQueued;
+	}
+	{
+		std::lock_guard lock(mWorkers[worker]->mutex);
+		mWorkers[worker]->tasks.push_back(std::move(task));
+	}
+	mWake.notify_one();
+}
+
+bool Grafkit::ThreadPool::TryRunOne(const size_t self)
+{
+	Task task;
+	const auto count = mWorkers.size();
+	if (self != noWorker)
+	{
+		auto & own = *mWorkers[self];
+		std::lock_guard lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+		}
+	}
+	for (size_t i = 1; !task && i <= count; ++i)
+	{
+		auto & victim = *mWorkers[(self == noWorker ? i : self + i) % count];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+		}
+	}
+	if (!task) return false;
+
+	--mQueued;
+	task();
+	return true;
+}
+
+void Grafkit::ThreadPool::Run(const size_t index)
+{
+	currentPool = this;
+	currentWorker = index;
+	while (true)
+	{
+		if (TryRunOne(index)) continue;
+
+		std::unique_lock lock(mSleepMutex);
+		mWake.wait(lock, [this] { return mStop || mQueued > 0; });
+		if (mStop) return;
+	}
+}
+
+void Grafkit::ThreadPool::ParallelFor(const size_t count, const std::function<void(size_t)> & body)
+{
+	if (count == 0) return;
+	if (count == 1)
+	{
+		body(0);
+		return;
+	}
+
+	struct Batch
+	{
+		std::atomic<size_t> remaining;
+		std::mutex errorMutex;
+		std::exception_ptr error;
+	};
+	auto batch = std::make_shared<Batch>();
+	batch->remaining = count;
+
+	// Spread the indices over the workers, stealing evens out the rest
+	const auto self = currentPool == this ? currentWorker : noWorker;
+	const auto workers = mWorkers.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		Push((self == noWorker ? i : self + i) % workers, [this, batch, &body, i] {
+			try
+			{
+				body(i);
+			}
+			catch (...)
+			{
+				std::lock_guard lock(batch->errorMutex);
+				if (!batch->error) batch->error = std::current_exception();
+			}
+			// Waiters on the batch sleep with the idle workers, the last task wakes them all
+			if (--batch->remaining == 0)
+			{
+				std::lock_guard lock(mSleepMutex);
+				mWake.notify_all();
+			}
+		});
+	}
+
+	// Help out while waiting; once there is nothing left to steal, sleep until the batch is done or new work comes in
+	while (batch->remaining > 0)
+	{
+		if (TryRunOne(self)) continue;
+		std::unique_lock lock(mSleepMutex);
+		mWake.wait(lock, [&batch, this] { return batch->remaining == 0 || mQueued > 0; });
+	}
+
+	if (batch->error) std::rethrow_exception(batch->error);
+}
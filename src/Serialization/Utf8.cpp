@@ -0,0 +1,294 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <Serialization/Utf8.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GK_UTF8_X86 1
+#include <immintrin.h>
+#define GK_TARGET(features) __attribute__((target(features)))
+#endif
+
+namespace
+{
+	// Accepted range of the byte after a lead byte, and the length of the sequence; length 0 is an invalid lead
+	struct LeadInfo
+	{
+		uint8_t length;
+		uint8_t low;
+		uint8_t high;
+	};
+
+	LeadInfo Lead(const uint8_t c)
+	{
+		if (c >= 0xc2 && c <= 0xdf) return {2, 0x80, 0xbf};
+		if (c == 0xe0) return {3, 0xa0, 0xbf};
+		if (c == 0xed) return {3, 0x80, 0x9f};
+		if (c >= 0xe1 && c <= 0xef) return {3, 0x80, 0xbf};
+		if (c == 0xf0) return {4, 0x90, 0xbf};
+		if (c == 0xf4) return {4, 0x80, 0x8f};
+		if (c >= 0xf1 && c <= 0xf3) return {4, 0x80, 0xbf};
+		return {0, 0, 0};
+	}
+
+	// Bytes of the valid prefix of the sequence at text, or 0 when even the lead is invalid; complete when it equals the lead length
+	size_t ValidPrefix(const uint8_t * text, const size_t size, const LeadInfo & lead)
+	{
+		if (lead.length == 0) return 0;
+		if (size < 2 || text[1] < lead.low || text[1] > lead.high) return 1;
+		size_t i = 2;
+		while (i < lead.length && i < size && (text[i] & 0xc0) == 0x80) ++i;
+		return i;
+	}
+
+	bool IsValidScalar(const uint8_t * text, const size_t size)
+	{
+		size_t i = 0;
+		while (i < size)
+		{
+			if (i + 8 <= size)
+			{
+				uint64_t word;
+				std::memcpy(&word, text + i, 8);
+				if ((word & 0x8080808080808080ull) == 0)
+				{
+					i += 8;
+					continue;
+				}
+			}
+			if (text[i] < 0x80)
+			{
+				++i;
+				continue;
+			}
+			const auto lead = Lead(text[i]);
+			if (lead.length == 0 || ValidPrefix(text + i, size - i, lead) != lead.length) return false;
+			i += lead.length;
+		}
+		return true;
+	}
+
+	using ValidateKernel = bool (*)(const uint8_t * text, size_t size);
+
+#ifdef GK_UTF8_X86
+	// Error bits of the lookup tables; a byte pair is invalid if the three lookups share a bit
+	constexpr uint8_t tooShort = 1 << 0;   // lead followed by a lead or ASCII
+	constexpr uint8_t tooLong = 1 << 1;    // ASCII followed by a continuation
+	constexpr uint8_t overlong3 = 1 << 2;  // E0 80..9F
+	constexpr uint8_t tooLarge = 1 << 3;   // F4 90..BF, F5..
+	constexpr uint8_t surrogate = 1 << 4;  // ED A0..BF
+	constexpr uint8_t overlong2 = 1 << 5;  // C0, C1
+	constexpr uint8_t tooLarge1000 = 1 << 6;
+	constexpr uint8_t overlong4 = 1 << 6;  // F0 80..8F
+	constexpr uint8_t twoConts = 1 << 7;   // continuation followed by a continuation, checked against the length of the sequence
+	constexpr uint8_t carry = tooShort | tooLong | twoConts;
+
+	// Indexed by the high nibble of the first byte of a pair, its low nibble, and the high nibble of the second byte
+	alignas(16) constexpr uint8_t byte1High[16] = {tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, twoConts, twoConts, twoConts,
+		twoConts, tooShort | overlong2, tooShort, tooShort | overlong3 | surrogate, tooShort | tooLarge | tooLarge1000 | overlong4};
+	alignas(16) constexpr uint8_t byte1Low[16] = {carry | overlong3 | overlong2 | overlong4, carry | overlong2, carry, carry, carry | tooLarge,
+		carry | tooLarge | tooLarge1000, carry | tooLarge | tooLarge1000, carry | tooLarge | tooLarge1000, carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000, carry | tooLarge | tooLarge1000, carry | tooLarge | tooLarge1000, carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000 | surrogate, carry | tooLarge | tooLarge1000, carry | tooLarge | tooLarge1000};
+	alignas(16) constexpr uint8_t byte2High[16] = {tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort,
+		tooLong | overlong2 | twoConts | overlong3 | tooLarge1000 | overlong4, tooLong | overlong2 | twoConts | overlong3 | tooLarge,
+		tooLong | overlong2 | twoConts | surrogate | tooLarge, tooLong | overlong2 | twoConts | surrogate | tooLarge, tooShort, tooShort, tooShort, tooShort};
+
+	// Subtracted from the last bytes of a block, nonzero where a sequence starting there runs past it
+	alignas(32) constexpr uint8_t incompleteLimits[32] = {255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+		255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1};
+
+	GK_TARGET("ssse3") inline __m128i Load16(const uint8_t * table) { return _mm_load_si128(reinterpret_cast<const __m128i *>(table)); }
+
+	GK_TARGET("ssse3") inline __m128i HighNibbles(const __m128i v) { return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f)); }
+
+	// Nonzero where the block is not valid given the 16 bytes before it
+	GK_TARGET("ssse3") inline __m128i CheckBlock(const __m128i input, const __m128i previous)
+	{
+		const auto prev1 = _mm_alignr_epi8(input, previous, 15);
+		const auto special = _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(Load16(byte1High), HighNibbles(prev1)),
+												   _mm_shuffle_epi8(Load16(byte1Low), _mm_and_si128(prev1, _mm_set1_epi8(0x0f)))),
+			_mm_shuffle_epi8(Load16(byte2High), HighNibbles(input)));
+
+		// Third and fourth bytes of a sequence have to be continuations, and only those may follow a continuation
+		const auto prev2 = _mm_alignr_epi8(input, previous, 14);
+		const auto prev3 = _mm_alignr_epi8(input, previous, 13);
+		const auto must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+			_mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xf0 - 0x80))));
+		return _mm_xor_si128(_mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80))), special);
+	}
+
+	GK_TARGET("ssse3") inline __m128i Incomplete(const __m128i input)
+	{
+		return _mm_subs_epu8(input, _mm_load_si128(reinterpret_cast<const __m128i *>(incompleteLimits + 16)));
+	}
+
+	GK_TARGET("ssse3") bool IsValidSsse3(const uint8_t * text, const size_t size)
+	{
+		auto error = _mm_setzero_si128();
+		auto previous = _mm_setzero_si128();
+		auto previousIncomplete = _mm_setzero_si128();
+
+		uint8_t tail[16] = {};
+		for (size_t i = 0; i < size; i += 16)
+		{
+			const uint8_t * block = text + i;
+			if (size - i < 16)
+			{
+				std::memcpy(tail, text + i, size - i);
+				block = tail;
+			}
+			const auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+			if (_mm_movemask_epi8(input) == 0) { error = _mm_or_si128(error, previousIncomplete); }
+			else
+			{
+				error = _mm_or_si128(error, CheckBlock(input, previous));
+				previousIncomplete = Incomplete(input);
+			}
+			previous = input;
+		}
+		error = _mm_or_si128(error, previousIncomplete);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xffff;
+	}
+
+	GK_TARGET("avx2") inline __m256i Load16x2(const uint8_t * table) { return _mm256_broadcastsi128_si256(Load16(table)); }
+
+	GK_TARGET("avx2") inline __m256i HighNibbles(const __m256i v) { return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f)); }
+
+	// Bytes before each of the input, the lanes across
+	template <int N> GK_TARGET("avx2") inline __m256i Prev(const __m256i input, const __m256i previous)
+	{
+		return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+	}
+
+	GK_TARGET("avx2") inline __m256i CheckBlock(const __m256i input, const __m256i previous)
+	{
+		const auto prev1 = Prev<1>(input, previous);
+		const auto special = _mm256_and_si256(_mm256_and_si256(_mm256_shuffle_epi8(Load16x2(byte1High), HighNibbles(prev1)),
+													  _mm256_shuffle_epi8(Load16x2(byte1Low), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)))),
+			_mm256_shuffle_epi8(Load16x2(byte2High), HighNibbles(input)));
+
+		const auto must23 = _mm256_or_si256(_mm256_subs_epu8(Prev<2>(input, previous), _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80))),
+			_mm256_subs_epu8(Prev<3>(input, previous), _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80))));
+		return _mm256_xor_si256(_mm256_and_si256(must23, _mm256_set1_epi8(static_cast<char>(0x80))), special);
+	}
+
+	GK_TARGET("avx2") inline __m256i Incomplete(const __m256i input)
+	{
+		return _mm256_subs_epu8(input, _mm256_load_si256(reinterpret_cast<const __m256i *>(incompleteLimits)));
+	}
+
+	GK_TARGET("avx2") bool IsValidAvx2(const uint8_t * text, const size_t size)
+	{
+		auto error = _mm256_setzero_si256();
+		auto previous = _mm256_setzero_si256();
+		auto previousIncomplete = _mm256_setzero_si256();
+
+		uint8_t tail[32] = {};
+		for (size_t i = 0; i < size; i += 32)
+		{
+			const uint8_t * block = text + i;
+			if (size - i < 32)
+			{
+				std::memcpy(tail, text + i, size - i);
+				block = tail;
+			}
+			const auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+			if (_mm256_movemask_epi8(input) == 0) { error = _mm256_or_si256(error, previousIncomplete); }
+			else
+			{
+				error = _mm256_or_si256(error, CheckBlock(input, previous));
+				previousIncomplete = Incomplete(input);
+			}
+			previous = input;
+		}
+		error = _mm256_or_si256(error, previousIncomplete);
+		return _mm256_testz_si256(error, error);
+	}
+#endif
+
+	bool CpuSupports(const Grafkit::Utils::Utf8::EKernel kernel)
+	{
+		using Grafkit::Utils::Utf8::EKernel;
+		if (kernel == EKernel::Best || kernel == EKernel::Scalar) return true;
+#ifdef GK_UTF8_X86
+		__builtin_cpu_init();
+		if (kernel == EKernel::Avx2) return __builtin_cpu_supports("avx2");
+		return __builtin_cpu_supports("ssse3");
+#else
+		return false;
+#endif
+	}
+
+	ValidateKernel SelectKernel()
+	{
+		using Grafkit::Utils::Utf8::EKernel;
+		static const ValidateKernel kernel = [] {
+			ValidateKernel selected = IsValidScalar;
+#ifdef GK_UTF8_X86
+			if (CpuSupports(EKernel::Avx2))
+				selected = IsValidAvx2;
+			else if (CpuSupports(EKernel::Ssse3))
+				selected = IsValidSsse3;
+#endif
+			return selected;
+		}();
+		return kernel;
+	}
+
+	ValidateKernel KernelFor(const Grafkit::Utils::Utf8::EKernel kernel)
+	{
+		using Grafkit::Utils::Utf8::EKernel;
+		if (kernel == EKernel::Best) return SelectKernel();
+		if (!CpuSupports(kernel)) throw std::runtime_error("UTF-8 kernel is not supported by the CPU");
+#ifdef GK_UTF8_X86
+		if (kernel == EKernel::Avx2) return IsValidAvx2;
+		if (kernel == EKernel::Ssse3) return IsValidSsse3;
+#endif
+		return IsValidScalar;
+	}
+} // namespace
+
+bool Grafkit::Utils::Utf8::IsValid(const char * text, const size_t size) { return SelectKernel()(reinterpret_cast<const uint8_t *>(text), size); }
+
+bool Grafkit::Utils::Utf8::IsSupported(const EKernel kernel) { return CpuSupports(kernel); }
+
+bool Grafkit::Utils::Utf8::IsValid(const std::string_view text, const EKernel kernel)
+{
+	return KernelFor(kernel)(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+std::string Grafkit::Utils::Utf8::ReplaceInvalid(const std::string_view text)
+{
+	static constexpr char replacement[] = "\xef\xbf\xbd";
+
+	const auto * bytes = reinterpret_cast<const uint8_t *>(text.data());
+	std::string result;
+	result.reserve(text.size() + text.size() / 8);
+	size_t i = 0;
+	while (i < text.size())
+	{
+		if (bytes[i] < 0x80)
+		{
+			result.push_back(text[i]);
+			++i;
+			continue;
+		}
+		const auto lead = Lead(bytes[i]);
+		const auto valid = ValidPrefix(bytes + i, text.size() - i, lead);
+		if (lead.length != 0 && valid == lead.length) { result.append(text.data() + i, valid); }
+		else
+		{
+			result.append(replacement, 3);
+		}
+		i += valid > 0 ? valid : 1;
+	}
+	return result;
+}
+
+void Grafkit::Utils::Utf8::Validate(std::string & text, const EValidation validation)
+{
+	if (validation == EValidation::Off || IsValid(text)) return;
+	if (validation == EValidation::Strict) throw std::runtime_error("malformed data - invalid UTF-8");
+	text = ReplaceInvalid(text);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cmath>
+//
+#include <refl.h>
+//
+#include <Serialization/Serialization.h>
+
+/**
+ * Small reflected types shared by the serialization tests and the benchmarks
+ */
+
+struct Point
+{
+	float x = 0.f;
+	float y = 0.f;
+	[[nodiscard]] float magnitude() const { return std::sqrt(x * x + y * y); }
+
+	bool operator==(const Point & rhs) const { return x == rhs.x && y == rhs.y; }
+	bool operator!=(const Point & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(Point, bases<>)
+REFL_FIELD(x, Grafkit::Attributes::Serializable())
+REFL_FIELD(y, Grafkit::Attributes::Serializable())
+REFL_FUNC(magnitude)
+REFL_END
+
+struct Line
+{
+	Point start = {};
+	Point end = {};
+
+	[[nodiscard]] float length() const { return Point{end.x - start.x, end.y - start.y}.magnitude(); }
+
+	bool operator==(const Line & rhs) const { return start == rhs.start && end == rhs.end; }
+	bool operator!=(const Line & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(Line, bases<>)
+REFL_FIELD(start, Grafkit::Attributes::Serializable())
+REFL_FIELD(end, Grafkit::Attributes::Serializable())
+REFL_FUNC(length)
+REFL_END
@@ -0,0 +1,86 @@
+#include <string>
+#include <vector>
+//
+#include <gtest/gtest.h>
+//
+#include <Serialization/Base64.h>
+
+namespace
+{
+	using Grafkit::Utils::Base64::EKernel;
+
+	std::string Encode(const std::string & text, const EKernel kernel = EKernel::Best)
+	{
+		std::string result(Grafkit::Utils::Base64::EncodedSize(text.size()), '\0');
+		Grafkit::Utils::Base64::Encode(text.data(), text.size(), result.data(), kernel);
+		return result;
+	}
+
+	std::string Decode(const std::string & text, const EKernel kernel = EKernel::Best)
+	{
+		std::string result(Grafkit::Utils::Base64::DecodedSize(text), '\0');
+		Grafkit::Utils::Base64::Decode(text, result.data(), kernel);
+		return result;
+	}
+
+	// Every kernel the CPU can run, not only the one it picks
+	std::vector<EKernel> SupportedKernels()
+	{
+		std::vector<EKernel> kernels;
+		for (const auto kernel : {EKernel::Scalar, EKernel::Ssse3, EKernel::Avx2})
+			if (Grafkit::Utils::Base64::IsSupported(kernel)) kernels.push_back(kernel);
+		return kernels;
+	}
+} // namespace
+
+// RFC 4648 test vectors
+TEST(Base64, Reference)
+{
+	const std::pair<std::string, std::string> vectors[] = {
+		{"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"}, {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"}};
+	for (const auto & [plain, encoded] : vectors)
+	{
+		ASSERT_EQ(encoded, Encode(plain));
+		ASSERT_EQ(plain, Decode(encoded));
+	}
+}
+
+// Long enough for the vector kernels and every tail length after them
+TEST(Base64, RoundTrip)
+{
+	for (const auto kernel : SupportedKernels())
+	{
+		for (size_t size = 0; size < 300; ++size)
+		{
+			std::string bytes(size, '\0');
+			for (size_t i = 0; i < size; ++i) bytes[i] = static_cast<char>(i * 167 + size);
+			const auto encoded = Encode(bytes, kernel);
+			ASSERT_EQ(Grafkit::Utils::Base64::EncodedSize(size), encoded.size());
+			// Kernels agree with each other, not only with themselves
+			ASSERT_EQ(Encode(bytes, EKernel::Scalar), encoded) << static_cast<int>(kernel);
+			ASSERT_EQ(bytes, Decode(encoded, kernel)) << static_cast<int>(kernel);
+		}
+	}
+}
+
+TEST(Base64, Malformed)
+{
+	EXPECT_THROW(Decode("Zm9"), std::runtime_error);
+	EXPECT_THROW(Decode("Zm=v"), std::runtime_error);
+	EXPECT_THROW(Decode("===="), std::runtime_error);
+
+	// Bad characters anywhere, in and out of the vector kernels
+	const auto encoded = Encode(std::string(200, 'x'));
+	for (const auto kernel : SupportedKernels())
+	{
+		for (const char bad : {'-', '_', ' ', '=', '\x80'})
+		{
+			for (size_t i = 0; i < encoded.size() - 2; i += 7)
+			{
+				auto text = encoded;
+				text[i] = bad;
+				EXPECT_THROW(Decode(text, kernel), std::runtime_error) << i << " " << static_cast<int>(kernel);
+			}
+		}
+	}
+}
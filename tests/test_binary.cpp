@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+//
+#include <gtest/gtest.h>
+//
+#include <Serialization/Serialization.h>
+
+using BinarySerializer = Grafkit::BinarySerializer;
+using Serializable = Grafkit::Attributes::Serializable;
+
+struct DenseEntity
+{
+	int id = 0;
+	int health = 100;
+	float speed = 1.f;
+	std::string name;
+
+	bool operator==(const DenseEntity & rhs) const { return id == rhs.id && health == rhs.health && speed == rhs.speed && name == rhs.name; }
+	bool operator!=(const DenseEntity & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(DenseEntity, bases<>)
+REFL_FIELD(id, Serializable())
+REFL_FIELD(health, Serializable())
+REFL_FIELD(speed, Serializable())
+REFL_FIELD(name, Serializable())
+REFL_END
+
+struct SparseEntity : DenseEntity
+{
+};
+
+REFL_TYPE(SparseEntity, bases<>, Grafkit::Attributes::Sparse())
+REFL_FIELD(id, Serializable())
+REFL_FIELD(health, Serializable())
+REFL_FIELD(speed, Serializable())
+REFL_FIELD(name, Serializable())
+REFL_END
+
+struct Transform
+{
+	float x = 0.f;
+	float y = 0.f;
+	float angle = 0.f;
+};
+
+REFL_TYPE(Transform, bases<>)
+REFL_FIELD(x, Serializable(), Grafkit::Attributes::Quantized(-1024.f, 1024.f, 16))
+REFL_FIELD(y, Serializable(), Grafkit::Attributes::Quantized(-1024.f, 1024.f, 16))
+REFL_FIELD(angle, Serializable(), Grafkit::Attributes::HalfFloat())
+REFL_END
+
+struct Flags
+{
+	bool visible = false;
+	bool selected = false;
+	bool locked = false;
+	int layer = 0;
+	bool dirty = false;
+};
+
+REFL_TYPE(Flags, bases<>)
+REFL_FIELD(visible, Serializable())
+REFL_FIELD(selected, Serializable())
+REFL_FIELD(locked, Serializable())
+REFL_FIELD(layer, Serializable())
+REFL_FIELD(dirty, Serializable())
+REFL_END
+
+template <class T> size_t SerializedSize(const T & value)
+{
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer << value;
+	return s.str().size();
+}
+
+// --- Chunked sequences
+
+TEST(BinaryChunked, InputRange)
+{
+	std::vector<int> values;
+	for (int i = 0; i < 1000; ++i) values.push_back(i * 3);
+
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+
+	serializer.WriteChunked(values.begin(), values.end(), 64);
+	serializer << 42;
+
+	std::vector<int> readValues;
+	const auto count = serializer.ReadChunked<int>([&](int && value) { readValues.push_back(value); });
+	int trailer = 0;
+	serializer >> trailer;
+
+	ASSERT_EQ(values.size(), count);
+	ASSERT_EQ(values, readValues);
+	ASSERT_EQ(42, trailer);
+}
+
+TEST(BinaryChunked, Generator)
+{
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+
+	int next = 0;
+	serializer.WriteChunkedFrom(
+		[&]() -> std::optional<std::string> {
+			if (next == 100) return std::nullopt;
+			return std::to_string(next++);
+		},
+		7);
+
+	std::vector<std::string> readValues;
+	serializer.ReadChunked<std::string>([&](std::string && value) { readValues.push_back(std::move(value)); });
+
+	ASSERT_EQ(100u, readValues.size());
+	for (int i = 0; i < 100; ++i) ASSERT_EQ(std::to_string(i), readValues[i]);
+}
+
+TEST(BinaryChunked, EmptySequence)
+{
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+
+	auto writer = serializer.BeginChunked<int>();
+	writer.Finish();
+
+	size_t calls = 0;
+	ASSERT_EQ(0u, serializer.ReadChunked<int>([&](int &&) { ++calls; }));
+	ASSERT_EQ(0u, calls);
+}
+
+TEST(BinaryChunked, UnfinishedWhileUnwinding)
+{
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+
+	ASSERT_THROW(
+		{
+			auto writer = serializer.BeginChunked<int>();
+			writer.Push(1);
+			throw std::runtime_error("producer failed");
+		},
+		std::runtime_error);
+}
+
+// --- Sparse types
+
+TEST(BinarySparse, SkipsDefaultValues)
+{
+	SparseEntity entity;
+	entity.id = 42;
+
+	// checksum + presence byte + id
+	ASSERT_EQ(sizeof(uint32_t) + 1 + sizeof(int), SerializedSize(entity));
+	ASSERT_LT(SerializedSize(entity), SerializedSize(static_cast<const DenseEntity &>(entity)));
+
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer << entity;
+
+	SparseEntity readEntity;
+	readEntity.health = 0;
+	readEntity.name = "leftover";
+	serializer >> readEntity;
+
+	ASSERT_EQ(42, readEntity.id);
+	ASSERT_EQ(100, readEntity.health);
+	ASSERT_EQ(1.f, readEntity.speed);
+	ASSERT_TRUE(readEntity.name.empty());
+}
+
+TEST(BinarySparse, ChecksumDiffersFromDense)
+{
+	ASSERT_NE(Grafkit::Utils::Signature::CalcChecksum<DenseEntity>(), Grafkit::Utils::Signature::CalcChecksum<SparseEntity>());
+}
+
+// --- Encoded fields
+
+TEST(BinaryEncoding, CompactSize)
+{
+	// checksum + 3 * 16 bit
+	ASSERT_EQ(sizeof(uint32_t) + 3 * sizeof(uint16_t), SerializedSize(Transform{}));
+}
+
+TEST(BinaryEncoding, QuantizationError)
+{
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+
+	const Transform transform{123.456f, -1000.f, 3.14159f};
+	serializer << transform;
+
+	Transform readTransform;
+	serializer >> readTransform;
+
+	ASSERT_NEAR(transform.x, readTransform.x, 2048.f / 65535.f);
+	ASSERT_NEAR(transform.y, readTransform.y, 2048.f / 65535.f);
+	ASSERT_NEAR(transform.angle, readTransform.angle, 2e-3f);
+}
+
+TEST(BinaryEncoding, HalfFloat)
+{
+	using namespace Grafkit::Utils::Encoding;
+	for (const float value : {0.f, -0.f, 1.f, -2.5f, 65504.f, 6.103515625e-05f, 5.960464477539063e-08f}) ASSERT_EQ(value, HalfToFloat(FloatToHalf(value)));
+	ASSERT_TRUE(std::isinf(HalfToFloat(FloatToHalf(1e6f))));
+	ASSERT_TRUE(std::isnan(HalfToFloat(FloatToHalf(std::nanf("")))));
+}
+
+// --- Packed bits
+
+TEST(BinaryBits, PackedBoolMembers)
+{
+	// checksum + bits of visible, selected, locked + layer + bits of dirty
+	ASSERT_EQ(sizeof(uint32_t) + 1 + sizeof(int) + 1, SerializedSize(Flags{}));
+
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer << Flags{true, false, true, 7, true};
+
+	Flags flags;
+	serializer >> flags;
+	ASSERT_TRUE(flags.visible);
+	ASSERT_FALSE(flags.selected);
+	ASSERT_TRUE(flags.locked);
+	ASSERT_EQ(7, flags.layer);
+	ASSERT_TRUE(flags.dirty);
+}
+
+TEST(BinaryBits, BoolVectorAndBitset)
+{
+	std::vector<bool> mask(1000);
+	for (size_t i = 0; i < mask.size(); ++i) mask[i] = (i % 3) == 0;
+	std::bitset<130> bitset;
+	bitset.set(0).set(64).set(129);
+
+	// count + 16 words
+	ASSERT_EQ(sizeof(uint64_t) + 16 * sizeof(uint64_t), SerializedSize(mask));
+
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer << mask << bitset;
+
+	std::vector<bool> readMask;
+	std::bitset<130> readBitset;
+	serializer >> readMask >> readBitset;
+	ASSERT_EQ(mask, readMask);
+	ASSERT_EQ(bitset, readBitset);
+}
+
+TEST(BinaryBits, BoolVectorCorruptCount)
+{
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer << (uint64_t(1) << 62) << uint64_t(0xffffffff);
+
+	std::vector<bool> readMask;
+	ASSERT_THROW(serializer >> readMask, std::runtime_error);
+}
+
+// --- Sequence codecs
+
+template <class T> std::pair<T, size_t> RoundTripCoded(const T & value, const Grafkit::Serializer::BinaryAdapter::SequenceCodecPolicy policy)
+{
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer.SetSequenceCodecPolicy(policy);
+	serializer << value;
+	const auto size = s.str().size();
+
+	T readValue;
+	serializer >> readValue;
+	return {readValue, size};
+}
+
+TEST(BinarySequenceCodecs, PicksCompactCodec)
+{
+	using Policy = Grafkit::Serializer::BinaryAdapter::SequenceCodecPolicy;
+
+	std::vector<int64_t> timestamps;
+	for (int64_t i = 0; i < 10000; ++i) timestamps.push_back(1700000000000 + i * 16 + (i % 3));
+	std::vector<int> categories;
+	for (int i = 0; i < 10000; ++i) categories.push_back((i * 7919) % 5 * 1000);
+	std::vector<uint8_t> runs(10000, 0);
+	std::fill(runs.begin() + 5000, runs.end(), 1);
+	std::vector<double> samples;
+	for (int i = 0; i < 10000; ++i) samples.push_back(i < 5000 ? 20.5 : 21.25);
+	const std::vector<int> constant(10000, 7);
+
+	for (const auto policy : {Policy::FavorSize, Policy::FavorSpeed})
+	{
+		const auto [readTimestamps, timestampsSize] = RoundTripCoded(timestamps, policy);
+		ASSERT_EQ(timestamps, readTimestamps);
+		ASSERT_LT(timestampsSize, timestamps.size() * sizeof(int64_t) / 4);
+
+		const auto [readCategories, categoriesSize] = RoundTripCoded(categories, policy);
+		ASSERT_EQ(categories, readCategories);
+		ASSERT_LT(categoriesSize, categories.size() * sizeof(int) / 4);
+
+		const auto [readRuns, runsSize] = RoundTripCoded(runs, policy);
+		ASSERT_EQ(runs, readRuns);
+		ASSERT_LT(runsSize, 64u);
+
+		const auto [readSamples, samplesSize] = RoundTripCoded(samples, policy);
+		ASSERT_EQ(samples, readSamples);
+		ASSERT_LT(samplesSize, samples.size() * sizeof(double) / 4);
+
+		const auto [readConstant, constantSize] = RoundTripCoded(constant, policy);
+		ASSERT_EQ(constant, readConstant);
+		ASSERT_LT(constantSize, 64u);
+	}
+}
+
+TEST(BinarySequenceCodecs, EveryCodecRoundTrips)
+{
+	using namespace Grafkit::Utils::SequenceCodecs;
+
+	std::vector<float> floats = {0.f, -0.f, 1.f, 1.f, 3.5f, -1e30f, std::numeric_limits<float>::infinity(), 1e-40f};
+	std::vector<int16_t> shorts = {0, -32768, 32767, 5, 5, 5, -1};
+	for (const auto codec : {ECodec::Raw, ECodec::DeltaBitPacked, ECodec::XorFloat, ECodec::Dictionary, ECodec::RunLength})
+	{
+		std::vector<uint8_t> payload;
+		if (Encode(codec, floats.data(), floats.size(), payload))
+		{
+			std::vector<float> decoded(floats.size());
+			Decode(codec, payload.data(), payload.size(), decoded.data(), decoded.size());
+			ASSERT_EQ(0, std::memcmp(floats.data(), decoded.data(), floats.size() * sizeof(float)));
+		}
+
+		payload.clear();
+		if (Encode(codec, shorts.data(), shorts.size(), payload))
+		{
+			std::vector<int16_t> decoded(shorts.size());
+			Decode(codec, payload.data(), payload.size(), decoded.data(), decoded.size());
+			ASSERT_EQ(shorts, decoded);
+		}
+	}
+}
+
+TEST(BinarySequenceCodecs, NonVectorContainers)
+{
+	using Policy = Grafkit::Serializer::BinaryAdapter::SequenceCodecPolicy;
+
+	std::list<int> list = {3, 3, 3, 1, 2};
+	std::set<uint32_t> set = {1, 2, 4, 8, 16, 32};
+	std::vector<int> empty;
+	ASSERT_EQ(list, RoundTripCoded(list, Policy::FavorSize).first);
+	ASSERT_EQ(set, RoundTripCoded(set, Policy::FavorSize).first);
+	ASSERT_EQ(empty, RoundTripCoded(empty, Policy::FavorSpeed).first);
+
+	// Off keeps the plain format
+	ASSERT_EQ(sizeof(uint64_t) + 5 * sizeof(int), RoundTripCoded(list, Policy::Off).second);
+}
+
+TEST(BinarySequenceCodecs, CorruptSizes)
+{
+	using namespace Grafkit::Utils::SequenceCodecs;
+
+	const auto readCorrupt = [](const uint64_t count, const ECodec codec, const uint64_t payloadSize, const std::vector<uint8_t> & payload) {
+		std::stringstream s;
+		Grafkit::Stream<std::stringstream> stream(s);
+		BinarySerializer serializer(stream);
+		serializer.SetSequenceCodecPolicy(EPolicy::FavorSize);
+		serializer << count << static_cast<uint8_t>(codec) << payloadSize;
+		for (const auto byte : payload) serializer << byte;
+
+		std::vector<int> values;
+		serializer >> values;
+	};
+
+	// payload size past the end of the stream
+	ASSERT_THROW(readCorrupt(4, ECodec::DeltaBitPacked, uint64_t(1) << 50, {1, 2, 3}), std::runtime_error);
+	// more elements than the payload can hold
+	ASSERT_THROW(readCorrupt(uint64_t(1) << 50, ECodec::Dictionary, 2, {2, 0}), std::runtime_error);
+	ASSERT_THROW(readCorrupt(uint64_t(1) << 50, ECodec::Dictionary, 2, {1, 0}), std::runtime_error);
+	ASSERT_THROW(readCorrupt(uint64_t(1) << 50, ECodec::RunLength, 5, {0, 0, 0, 0, 1}), std::runtime_error);
+}
+
+// --- Parallel chunks
+
+namespace
+{
+	std::vector<DenseEntity> MakeEntities(const int count)
+	{
+		std::vector<DenseEntity> entities(count);
+		for (int i = 0; i < count; ++i) entities[i] = {i, i % 100, i * 0.5f, "entity_" + std::to_string(i)};
+		return entities;
+	}
+
+	std::string SerializeEntities(const std::vector<DenseEntity> & entities, Grafkit::ThreadPool * pool)
+	{
+		Grafkit::MemoryStream memory;
+		Grafkit::BasicBinarySerializer<Grafkit::MemoryStream> serializer(memory);
+		serializer.SetParallelOptions({pool, 1000, 777});
+		serializer << entities;
+		const auto data = memory.Data();
+		return {reinterpret_cast<const char *>(data.data()), data.size()};
+	}
+} // namespace
+
+TEST(BinaryParallel, RoundTrip)
+{
+	Grafkit::ThreadPool pool(4);
+	const auto entities = MakeEntities(20000);
+
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer.SetParallelOptions({&pool, 1000, 777});
+	serializer << entities << MakeEntities(10);
+
+	std::vector<DenseEntity> read = MakeEntities(3); // appended to, like every other container
+	std::vector<DenseEntity> small;
+	serializer >> read >> small;
+
+	ASSERT_EQ(entities.size() + 3, read.size());
+	for (size_t i = 0; i < entities.size(); ++i)
+	{
+		ASSERT_EQ(entities[i].id, read[i + 3].id);
+		ASSERT_EQ(entities[i].name, read[i + 3].name);
+		ASSERT_EQ(entities[i].speed, read[i + 3].speed);
+	}
+	ASSERT_EQ(10u, small.size());
+}
+
+TEST(BinaryParallel, OutputDoesNotDependOnThreads)
+{
+	const auto entities = MakeEntities(5000);
+	Grafkit::ThreadPool one(1);
+	Grafkit::ThreadPool many(8);
+	ASSERT_EQ(SerializeEntities(entities, &one), SerializeEntities(entities, &many));
+	// Chunk table in front of the plain elements: chunk size and one size per chunk
+	ASSERT_EQ(SerializeEntities(entities, nullptr).size() + sizeof(uint64_t) * (1 + 7), SerializeEntities(entities, &one).size());
+}
+
+TEST(BinaryParallel, RejectsChunkSizeMismatch)
+{
+	Grafkit::ThreadPool pool(2);
+	auto bytes = SerializeEntities(MakeEntities(5000), &pool);
+
+	// The last chunk claims one byte more than its elements take
+	constexpr size_t lastSizeOffset = sizeof(uint64_t) * (2 + 6);
+	uint64_t lastSize = 0;
+	std::memcpy(&lastSize, bytes.data() + lastSizeOffset, sizeof(lastSize));
+	++lastSize;
+	std::memcpy(bytes.data() + lastSizeOffset, &lastSize, sizeof(lastSize));
+	bytes.push_back('\0');
+
+	std::stringstream s(bytes);
+	Grafkit::Stream<std::stringstream> stream(s);
+	BinarySerializer serializer(stream);
+	serializer.SetParallelOptions({&pool, 1000, 777});
+	std::vector<DenseEntity> read;
+	ASSERT_THROW(serializer >> read, std::runtime_error);
+}
+
+TEST(ThreadPool, ParallelForNestedAndErrors)
+{
+	Grafkit::ThreadPool pool(3);
+	std::vector<std::atomic<int>> hits(64);
+	pool.ParallelFor(8, [&](const size_t outer) { pool.ParallelFor(8, [&](const size_t inner) { ++hits[outer * 8 + inner]; }); });
+	for (const auto & hit : hits) ASSERT_EQ(1, hit.load());
+
+	std::atomic<int> ran = 0;
+	EXPECT_THROW(pool.ParallelFor(16,
+					 [&](const size_t i) {
+						 ++ran;
+						 if (i == 5) throw std::runtime_error("task failed");
+					 }),
+		std::runtime_error);
+	EXPECT_EQ(16, ran.load());
+}
+
+// --- Batches
+
+TEST(BinaryBatch, RoundTrip)
+{
+	Grafkit::ThreadPool pool(4);
+	const auto entities = MakeEntities(1000);
+
+	const auto messages = Grafkit::SerializeBatch<DenseEntity>(entities, pool);
+	ASSERT_EQ(entities.size(), messages.size());
+	for (size_t i = 0; i < entities.size(); i += 97) ASSERT_EQ(Grafkit::ToBytes(entities[i]), messages[i]);
+
+	const auto read = Grafkit::DeserializeBatch<DenseEntity>(messages, pool);
+	ASSERT_EQ(entities.size(), read.size());
+	ASSERT_EQ(entities, read);
+
+	auto broken = messages;
+	broken[500].resize(3);
+	EXPECT_THROW(Grafkit::DeserializeBatch<DenseEntity>(broken, pool), std::runtime_error);
+}
@@ -0,0 +1,158 @@
+#include <string>
+#include <vector>
+//
+#include <gtest/gtest.h>
+//
+#include <Serialization/Framing.h>
+#include <Serialization/GatherStream.h>
+#include <Serialization/Serialization.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using Serializable = Grafkit::Attributes::Serializable;
+
+struct RpcMessage
+{
+	uint32_t id = 0;
+	std::string method;
+	std::vector<float> arguments;
+
+	bool operator==(const RpcMessage & rhs) const { return id == rhs.id && method == rhs.method && arguments == rhs.arguments; }
+	bool operator!=(const RpcMessage & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(RpcMessage, bases<>)
+REFL_FIELD(id, Serializable())
+REFL_FIELD(method, Serializable())
+REFL_FIELD(arguments, Serializable())
+REFL_END
+
+namespace
+{
+	RpcMessage MakeMessage(const uint32_t id) { return {id, "call_" + std::to_string(id), std::vector<float>(id % 7, 0.5f * id)}; }
+} // namespace
+
+TEST(Framing, ReaderRoundTrip)
+{
+	Grafkit::MemoryStream stream;
+	for (uint32_t i = 0; i < 100; ++i) Grafkit::Framing::WriteFrame(stream, MakeMessage(i));
+
+	Grafkit::Framing::FrameReader reader(stream);
+	RpcMessage message;
+	uint32_t count = 0;
+	while (reader.Next(message)) EXPECT_EQ(MakeMessage(count++), message);
+	EXPECT_EQ(100u, count);
+}
+
+TEST(Framing, TruncatedAndOversizedFrames)
+{
+	Grafkit::MemoryStream stream;
+	const auto size = Grafkit::Framing::WriteFrame(stream, MakeMessage(5));
+	EXPECT_THROW(Grafkit::Framing::WriteFrame(stream, MakeMessage(6), 8), std::runtime_error);
+
+	auto bytes = stream.Release();
+	ASSERT_EQ(size, bytes.size());
+	bytes.pop_back();
+
+	Grafkit::MemoryStream truncated(bytes);
+	Grafkit::Framing::FrameReader reader(truncated);
+	RpcMessage message;
+	EXPECT_THROW(reader.Next(message), std::runtime_error);
+
+	Grafkit::Framing::FrameDecoder decoder(8);
+	decoder.Feed(bytes);
+	EXPECT_THROW(decoder.Next(message), std::runtime_error);
+}
+
+TEST(Framing, PartialHeaderAndLeftoverPayload)
+{
+	Grafkit::MemoryStream stream;
+	Grafkit::Framing::WriteFrame(stream, MakeMessage(3));
+	auto bytes = stream.Release();
+
+	// The stream ends two bytes into the next header
+	auto partialHeader = bytes;
+	partialHeader.insert(partialHeader.end(), bytes.begin(), bytes.begin() + 2);
+	Grafkit::MemoryStream partial(partialHeader);
+	Grafkit::Framing::FrameReader reader(partial);
+	RpcMessage message;
+	ASSERT_TRUE(reader.Next(message));
+	EXPECT_EQ(MakeMessage(3), message);
+	EXPECT_THROW(reader.Next(message), std::runtime_error);
+
+	// The length covers more bytes than the message takes
+	auto padded = bytes;
+	padded.insert(padded.end(), 3, std::byte{0});
+	padded[0] = static_cast<std::byte>(static_cast<unsigned>(padded[0]) + 3);
+	Grafkit::MemoryStream paddedStream(padded);
+	Grafkit::Framing::FrameReader paddedReader(paddedStream);
+	EXPECT_THROW(paddedReader.Next(message), std::runtime_error);
+
+	Grafkit::Framing::FrameDecoder decoder;
+	decoder.Feed(padded);
+	EXPECT_THROW(decoder.Next(message), std::runtime_error);
+}
+
+#ifndef _WIN32
+
+TEST(Framing, DecoderOverPipe)
+{
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+
+	constexpr uint32_t messageCount = 200;
+	{
+		// Pipe capacity is at least 4 KiB, these frames stay well below that
+		Grafkit::GatherWriteStream out(fds[1]);
+		for (uint32_t i = 0; i < messageCount; i += 10) Grafkit::Framing::WriteFrame(out, MakeMessage(i));
+		out.Flush();
+	}
+	close(fds[1]);
+
+	// Arbitrary chunk sizes split headers and payloads
+	Grafkit::Framing::FrameDecoder decoder;
+	std::byte chunk[13];
+	RpcMessage message;
+	uint32_t next = 0;
+	ssize_t got = 0;
+	while ((got = read(fds[0], chunk, sizeof(chunk))) > 0)
+	{
+		decoder.Feed(Grafkit::Span<const std::byte>(chunk, static_cast<size_t>(got)));
+		while (decoder.Next(message))
+		{
+			EXPECT_EQ(MakeMessage(next), message);
+			next += 10;
+		}
+	}
+	close(fds[0]);
+
+	EXPECT_EQ(messageCount, next);
+	EXPECT_EQ(0u, decoder.Pending());
+}
+
+#endif
+
+TEST(Framing, Batches)
+{
+	Grafkit::ThreadPool pool(4);
+	std::vector<RpcMessage> messages;
+	for (uint32_t i = 0; i < 500; ++i) messages.push_back(MakeMessage(i));
+
+	Grafkit::MemoryStream single;
+	for (const auto & message : messages) Grafkit::Framing::WriteFrame(single, message);
+	Grafkit::MemoryStream batch;
+	const auto size = Grafkit::Framing::WriteFrames<RpcMessage>(batch, messages, pool);
+
+	auto bytes = batch.Release();
+	ASSERT_EQ(size, bytes.size());
+	ASSERT_EQ(single.Release(), bytes);
+
+	const auto read = Grafkit::Framing::DecodeFrames<RpcMessage>(bytes, pool);
+	ASSERT_EQ(messages.size(), read.size());
+	for (size_t i = 0; i < messages.size(); ++i) EXPECT_EQ(messages[i], read[i]);
+
+	bytes.pop_back();
+	EXPECT_THROW(Grafkit::Framing::DecodeFrames<RpcMessage>(bytes, pool), std::runtime_error);
+}
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+//
+#include <gtest/gtest.h>
+//
+#include <Serialization/JsonLines.h>
+#include <Serialization/LazyJson.h>
+#include <Serialization/Serialization.h>
+
+using Serializable = Grafkit::Attributes::Serializable;
+
+struct LogEvent
+{
+	uint64_t timestamp = 0;
+	std::string source;
+	std::vector<int> values;
+
+	bool operator==(const LogEvent & rhs) const { return timestamp == rhs.timestamp && source == rhs.source && values == rhs.values; }
+	bool operator!=(const LogEvent & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(LogEvent, bases<>)
+REFL_FIELD(timestamp, Serializable())
+REFL_FIELD(source, Serializable())
+REFL_FIELD(values, Serializable())
+REFL_END
+
+namespace
+{
+	LogEvent MakeEvent(const uint64_t i) { return {i, "host\n" + std::to_string(i % 13), std::vector<int>(i % 5, static_cast<int>(i))}; }
+
+	std::vector<LogEvent> MakeEvents(const size_t count)
+	{
+		std::vector<LogEvent> events;
+		for (size_t i = 0; i < count; ++i) events.push_back(MakeEvent(i));
+		return events;
+	}
+
+	std::string TempPath(const std::string & name) { return (std::filesystem::temp_directory_path() / name).string(); }
+} // namespace
+
+// --- JSON Lines
+
+TEST(JsonLines, WriteAndReadInOrder)
+{
+	Grafkit::ThreadPool pool(4);
+	const auto events = MakeEvents(20000);
+
+	std::stringstream single;
+	{
+		Grafkit::Stream<std::stringstream> stream(single);
+		for (const auto & event : events) Grafkit::JsonLines::WriteLine(stream, event);
+	}
+	std::stringstream batch;
+	{
+		Grafkit::Stream<std::stringstream> stream(batch);
+		Grafkit::JsonLines::WriteLines<LogEvent>(stream, events, pool);
+	}
+	const auto text = batch.str();
+	ASSERT_EQ(single.str(), text);
+	ASSERT_EQ(events.size(), static_cast<size_t>(std::count(text.begin(), text.end(), '\n')));
+
+	// Large enough to be cut into several parts
+	const auto read = Grafkit::JsonLines::ReadLines<LogEvent>(text, pool);
+	ASSERT_EQ(events.size(), read.size());
+	for (size_t i = 0; i < events.size(); ++i) ASSERT_EQ(events[i], read[i]);
+}
+
+TEST(JsonLines, FileWithBlankLinesAndCrlf)
+{
+	const auto path = TempPath("grafkit_events.jsonl");
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << "\n" << Grafkit::JsonLines::ToLine(MakeEvent(1));
+		file << "  \r\n";
+		auto line = Grafkit::JsonLines::ToLine(MakeEvent(2));
+		line.insert(line.size() - 1, "\r");
+		file << line << Grafkit::JsonLines::ToLine(MakeEvent(3)).substr(0, 10);
+	}
+
+	Grafkit::ThreadPool pool(2);
+	EXPECT_ANY_THROW(Grafkit::JsonLines::ReadFile<LogEvent>(path, pool));
+
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::app);
+		file << Grafkit::JsonLines::ToLine(MakeEvent(3)).substr(10);
+	}
+	const auto read = Grafkit::JsonLines::ReadFile<LogEvent>(path, pool);
+	ASSERT_EQ(3u, read.size());
+	for (uint64_t i = 0; i < 3; ++i) ASSERT_EQ(MakeEvent(i + 1), read[i]);
+
+	std::filesystem::remove(path);
+	EXPECT_THROW(Grafkit::JsonLines::ReadFile<LogEvent>(path, pool), std::runtime_error);
+}
+
+// --- Lazy documents
+
+struct EventSummary
+{
+	uint64_t timestamp = 0;
+	std::vector<int> values;
+};
+
+REFL_TYPE(EventSummary, bases<>)
+REFL_FIELD(timestamp, Serializable())
+REFL_FIELD(values, Serializable())
+REFL_END
+
+TEST(LazyJson, Navigation)
+{
+	// Escapes, brackets inside strings and blocks boundaries in all the wrong places
+	std::string text = R"( {"a\\": "x\"]}\\", "list": [1, -2.5e3, true, null, {"k": [ ]}, "s"], )";
+	text += R"("pad": ")" + std::string(100, '\\') + R"(", "last" : {"n":7}} )";
+	const Grafkit::LazyJsonDocument document(text);
+	const auto root = document.Root();
+
+	ASSERT_EQ(Grafkit::EJsonType::Object, root.Type());
+	ASSERT_EQ(4u, root.Size());
+	ASSERT_EQ("x\"]}\\", root["a\\"].GetString());
+	ASSERT_FALSE(root.Find("missing"));
+
+	const auto list = root["list"];
+	ASSERT_EQ(6u, list.Size());
+	ASSERT_EQ(1, list[0].Get<int>());
+	ASSERT_EQ(-2500.0, list[1].Get<double>());
+	ASSERT_TRUE(list[2].Get<bool>());
+	ASSERT_EQ(Grafkit::EJsonType::Null, list[3].Type());
+	ASSERT_EQ(R"({"k": [ ]})", list[4].Raw());
+	ASSERT_EQ(0u, list[4]["k"].Size());
+	ASSERT_EQ("s", list[5].Get<std::string>());
+
+	ASSERT_EQ(std::string(50, '\\'), root["pad"].GetString());
+	ASSERT_EQ(7, root["last"]["n"].Get<int>());
+
+	// Same navigation as the DOM everywhere
+	ASSERT_EQ(Grafkit::Json::parse(text), root.Parse());
+
+	EXPECT_THROW(Grafkit::LazyJsonDocument(std::string(R"({"a": [1, 2})")), std::runtime_error);
+	EXPECT_THROW(Grafkit::LazyJsonDocument(std::string(R"({"a": "open})")), std::runtime_error);
+}
+
+TEST(LazyJson, PartialReflectedRead)
+{
+	std::vector<LogEvent> events = MakeEvents(300);
+	Grafkit::Json json;
+	Grafkit::JsonSerializer serializer(json);
+	serializer << events;
+
+	const Grafkit::LazyJsonDocument document(json.dump());
+
+	// Only the members of the type are touched
+	std::vector<EventSummary> summaries;
+	Grafkit::Serializer::LazyJsonAdapter(document.Root()) >> summaries;
+	ASSERT_EQ(events.size(), summaries.size());
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		ASSERT_EQ(events[i].timestamp, summaries[i].timestamp);
+		ASSERT_EQ(events[i].values, summaries[i].values);
+	}
+
+	// The full type reads the same as through the DOM
+	LogEvent event;
+	Grafkit::Serializer::LazyJsonAdapter(document.Root()[size_t(42)]) >> event;
+	ASSERT_EQ(events[42], event);
+}
+
+// --- Parallel dump
+
+TEST(JsonDump, ParallelMatchesSequential)
+{
+	Grafkit::ThreadPool pool(4);
+	const auto events = MakeEvents(50000);
+	Grafkit::Json json;
+	Grafkit::JsonSerializer serializer(json);
+	serializer << events;
+	json.push_back("\xc3\xa9t\xc3\xa9 \"quoted\"");
+	json.push_back(Grafkit::Json::array());
+
+	for (const auto & value : {json, Grafkit::Json::array(), Grafkit::Json{{"not", "an array"}}})
+	{
+		std::stringstream s;
+		Grafkit::Stream<std::stringstream> stream(s);
+		Grafkit::JsonSerializer::DumpJson(stream, value, pool, 1);
+		ASSERT_EQ(value.dump(), s.str());
+	}
+
+	// An element that can't be dumped late in the array leaves nothing behind
+	json.push_back("\xff invalid");
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	ASSERT_ANY_THROW(Grafkit::JsonSerializer::DumpJson(stream, json, pool, 1));
+	ASSERT_TRUE(s.str().empty());
+}
+
+// --- Arena DOM
+
+TEST(JsonArena, MatchesHeapDom)
+{
+	const auto events = MakeEvents(2000);
+	Grafkit::Json json;
+	Grafkit::JsonSerializer serializer(json);
+	serializer << events;
+	const auto expected = json.dump();
+
+	Grafkit::JsonArena arena;
+	{
+		Grafkit::ArenaJson arenaJson;
+		Grafkit::ArenaJsonSerializer arenaSerializer(arenaJson);
+		arenaSerializer << events;
+		ASSERT_EQ(expected, arenaJson.dump());
+		ASSERT_GT(arena.BytesAllocated(), 0u);
+		ASSERT_LE(arena.BytesAllocated(), arena.BytesReserved());
+
+		std::vector<LogEvent> read;
+		auto parsed = Grafkit::ArenaJson::parse(expected);
+		Grafkit::ArenaJsonSerializer(parsed) >> read;
+		ASSERT_EQ(events.size(), read.size());
+		for (size_t i = 0; i < events.size(); ++i) ASSERT_EQ(events[i], read[i]);
+	}
+
+	// Arenas nest
+	{
+		Grafkit::JsonArena inner;
+		ASSERT_EQ(&inner, Grafkit::JsonArena::Current());
+	}
+	ASSERT_EQ(&arena, Grafkit::JsonArena::Current());
+}
+
+// --- Blobs
+
+struct Thumbnail
+{
+	std::string name;
+	std::vector<uint8_t> pixels;
+	std::vector<float> weights;
+	std::array<uint16_t, 4> rect = {};
+
+	bool operator==(const Thumbnail & rhs) const { return name == rhs.name && pixels == rhs.pixels && weights == rhs.weights && rect == rhs.rect; }
+	bool operator!=(const Thumbnail & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(Thumbnail, bases<>)
+REFL_FIELD(name, Serializable())
+REFL_FIELD(pixels, Serializable())
+REFL_FIELD(weights, Serializable(), Grafkit::Attributes::Blob())
+REFL_FIELD(rect, Serializable(), Grafkit::Attributes::Blob())
+REFL_END
+
+TEST(JsonBlob, Base64AndLegacyArrays)
+{
+	Thumbnail thumbnail{"thumb", std::vector<uint8_t>(1000), {.5f, -1.f, 3.25f}, {1, 2, 640, 480}};
+	for (size_t i = 0; i < thumbnail.pixels.size(); ++i) thumbnail.pixels[i] = static_cast<uint8_t>(i * 31);
+
+	Grafkit::Json json;
+	Grafkit::JsonSerializer serializer(json);
+	serializer << thumbnail;
+	ASSERT_TRUE(json["pixels"].is_string());
+	ASSERT_TRUE(json["weights"].is_string());
+	ASSERT_TRUE(json["rect"].is_string());
+	ASSERT_LT(json.dump().size(), 1500u);
+
+	Thumbnail read;
+	serializer >> read;
+	ASSERT_EQ(thumbnail, read);
+
+	Thumbnail lazyRead;
+	const Grafkit::LazyJsonDocument document(json.dump());
+	Grafkit::Serializer::LazyJsonAdapter(document.Root()) >> lazyRead;
+	ASSERT_EQ(thumbnail, lazyRead);
+
+	// Arrays of numbers, as written before
+	json["pixels"] = thumbnail.pixels;
+	json["weights"] = thumbnail.weights;
+	json["rect"] = thumbnail.rect;
+	Thumbnail legacyRead;
+	serializer >> legacyRead;
+	ASSERT_EQ(thumbnail, legacyRead);
+
+	json["weights"] = Grafkit::Utils::Base64::Encode("abcdef", 6);
+	EXPECT_THROW(serializer >> legacyRead, std::runtime_error);
+}
+
+// Only raw bytes become base64, text and signed bytes keep their number arrays
+TEST(JsonBlob, CharVectorsStayArrays)
+{
+	const std::vector<char> text = {'a', 'b', 'c'};
+	const std::vector<int8_t> numbers = {-1, 0, 1};
+
+	Grafkit::Json json;
+	Grafkit::JsonSerializer serializer(json);
+	serializer << text;
+	ASSERT_EQ(Grafkit::Json::parse("[97,98,99]"), json);
+	serializer << numbers;
+	ASSERT_EQ(Grafkit::Json::parse("[-1,0,1]"), json);
+
+	std::vector<int8_t> read;
+	serializer >> read;
+	ASSERT_EQ(numbers, read);
+}
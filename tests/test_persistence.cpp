@@ -29,6 +29,35 @@ struct UseBinarySerializer
 	}
 };
 
+// Model of the stream concept without IStream; Dynamics goes through the type-erased fallback
+struct DirectStringStream
+{
+	std::stringstream & s;
+
+	void Read(char * buffer, size_t length) { s.read(buffer, length); }
+	void Write(const char * buffer, size_t length) { s.write(buffer, length); }
+	[[nodiscard]] bool IsSuccess() const { return bool(s); }
+};
+
+struct UseStaticBinarySerializer
+{
+	using Serializer = Grafkit::BasicBinarySerializer<DirectStringStream>;
+
+	template <class T> void Serialize(const T & obj, std::stringstream & s)
+	{
+		DirectStringStream stream{s};
+		Serializer serializer(stream);
+		serializer << obj;
+	}
+
+	template <class T> void Deserialize(std::stringstream & s, T & obj)
+	{
+		DirectStringStream stream{s};
+		Serializer serializer(stream);
+		serializer >> obj;
+	}
+};
+
 struct UseJsonSerializer
 {
 	using Serializer = Grafkit::JsonSerializer;
@@ -44,7 +73,7 @@ template <class SerializerAdapter> class TestPersistence : public testing::Test,
 {
 };
 
-typedef testing::Types<UseBinarySerializer /*,UseJsonSerializer*/> PersistenceTestImplementations;
+typedef testing::Types<UseBinarySerializer, UseStaticBinarySerializer /*,UseJsonSerializer*/> PersistenceTestImplementations;
 
 // ---
 
@@ -339,6 +368,115 @@ TYPED_TEST(TestPersistence, STLContainerObjects)
 	// ASSERT_THAT(readList, ElementsAreArray(list));
 }
 
+// --- Length-prefixed subtrees, decoded in parallel
+
+class SceneNode : public DynamicObject
+{
+public:
+	int id = 0;
+	std::shared_ptr<SimpleClass> payload;
+	std::vector<std::shared_ptr<SceneNode>> children;
+
+	DYNAMICS_DECL(SceneNode)
+};
+
+REFL_TYPE(SceneNode, bases<>)
+REFL_FIELD(id, Serializable())
+REFL_FIELD(payload, Serializable())
+REFL_FIELD(children, Serializable())
+REFL_END
+
+DYNAMICS_IMPL(SceneNode)
+
+namespace
+{
+	std::shared_ptr<SceneNode> MakeScene(const int id, const int depth)
+	{
+		auto node = std::make_shared<SceneNode>();
+		node->id = id;
+		if (id % 3 != 0) node->payload = std::make_shared<SimpleClass>(id, "node " + std::to_string(id));
+		if (depth > 0)
+			for (int i = 0; i < 4; ++i) node->children.push_back(MakeScene(id * 4 + i + 1, depth - 1));
+		return node;
+	}
+
+	void ExpectSameScene(const SceneNode & expected, const SceneNode & actual)
+	{
+		ASSERT_EQ(expected.id, actual.id);
+		ASSERT_EQ(bool(expected.payload), bool(actual.payload));
+		if (expected.payload) { ASSERT_EQ(expected.payload->String(), actual.payload->String()); }
+		ASSERT_EQ(expected.children.size(), actual.children.size());
+		for (size_t i = 0; i < expected.children.size(); ++i) ExpectSameScene(*expected.children[i], *actual.children[i]);
+	}
+} // namespace
+
+TEST(PersistenceSubtrees, SceneGraph)
+{
+	Grafkit::ThreadPool pool(4);
+	std::vector<std::shared_ptr<SceneNode>> scene;
+	for (int i = 0; i < 32; ++i) scene.push_back(MakeScene(i * 1000, 3));
+
+	std::stringstream s;
+	{
+		Grafkit::OutputStream<std::stringstream> stream(s);
+		Grafkit::BinarySerializer serializer(stream);
+		serializer.SetParallelOptions({nullptr, 1 << 16, 1 << 14, true});
+		serializer << scene;
+	}
+	const auto bytes = s.str();
+
+	// The format does not depend on the pool, only on the subtrees flag
+	for (auto * readPool : {&pool, static_cast<Grafkit::ThreadPool *>(nullptr)})
+	{
+		std::stringstream in(bytes);
+		Grafkit::InputStream<std::stringstream> stream(in);
+		Grafkit::BinarySerializer serializer(stream);
+		serializer.SetParallelOptions({readPool, 1 << 16, 1 << 14, true});
+
+		std::vector<std::shared_ptr<SceneNode>> read;
+		serializer >> read;
+		ASSERT_EQ(scene.size(), read.size());
+		for (size_t i = 0; i < scene.size(); ++i) ExpectSameScene(*scene[i], *read[i]);
+	}
+}
+
+TEST(PersistenceSubtrees, PropertySettersAndMalformedSize)
+{
+	Grafkit::ThreadPool pool(2);
+	const Grafkit::Serializer::ParallelOptions options{&pool, 1 << 16, 1 << 14, true};
+	const auto obj = std::make_shared<NestedClass>(std::make_shared<SimpleClass>(666, "Devil"), nullptr);
+
+	std::stringstream s;
+	{
+		Grafkit::OutputStream<std::stringstream> stream(s);
+		Grafkit::BinarySerializer serializer(stream);
+		serializer.SetParallelOptions(options);
+		serializer << obj;
+	}
+
+	{
+		std::stringstream in(s.str());
+		Grafkit::InputStream<std::stringstream> stream(in);
+		Grafkit::BinarySerializer serializer(stream);
+		serializer.SetParallelOptions(options);
+		std::shared_ptr<NestedClass> read;
+		serializer >> read;
+		ASSERT_TRUE(read && read->Obj1());
+		ASSERT_EQ(666, read->Obj1()->Integer());
+		ASSERT_FALSE(read->Obj2());
+	}
+
+	// The size of the outermost subtree is one byte short
+	auto bytes = s.str();
+	bytes[0] = static_cast<char>(bytes[0] - 1);
+	std::stringstream in(bytes);
+	Grafkit::InputStream<std::stringstream> stream(in);
+	Grafkit::BinarySerializer serializer(stream);
+	serializer.SetParallelOptions(options);
+	std::shared_ptr<NestedClass> read;
+	ASSERT_THROW(serializer >> read, std::runtime_error);
+}
+
 // TODO (1) + map
 // TODO (1) + pair
 
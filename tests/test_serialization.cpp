@@ -1,3 +1,4 @@
+#include <bitset>
 #include <cmath>
 #include <list>
 #include <queue>
@@ -13,42 +14,71 @@
 #include <refl.h>
 //
 #include <Serialization/Serialization.h>
+//
+#include "Geometry.h"
 
 // TODO: https://www.sandordargo.com/blog/2019/04/24/parameterized-testing-with-gtest
 
 using Serializable = Grafkit::Attributes::Serializable;
 
-struct Point
+struct SparseConfig
+{
+	int width = 1920;
+	int height = 1080;
+	float scale = 1.f;
+	std::string title;
+	std::vector<int> layers;
+	Point origin = {};
+
+	bool operator==(const SparseConfig & rhs) const
+	{
+		return width == rhs.width && height == rhs.height && scale == rhs.scale && title == rhs.title && layers == rhs.layers && origin == rhs.origin;
+	}
+	bool operator!=(const SparseConfig & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(SparseConfig, bases<>, Grafkit::Attributes::Sparse())
+REFL_FIELD(width, Serializable())
+REFL_FIELD(height, Serializable())
+REFL_FIELD(scale, Serializable())
+REFL_FIELD(title, Serializable())
+REFL_FIELD(layers, Serializable())
+REFL_FIELD(origin, Serializable())
+REFL_END
+
+struct Direction
 {
 	float x = 0.f;
 	float y = 0.f;
-	[[nodiscard]] float magnitude() const { return std::sqrt(x * x + y * y); }
+	float z = 1.f;
 
-	bool operator==(const Point & rhs) const { return x == rhs.x && y == rhs.y; }
-	bool operator!=(const Point & rhs) const { return !(rhs == *this); }
+	// Octahedral encoding is lossy
+	bool operator==(const Direction & rhs) const { return std::abs(x - rhs.x) < 1e-3f && std::abs(y - rhs.y) < 1e-3f && std::abs(z - rhs.z) < 1e-3f; }
+	bool operator!=(const Direction & rhs) const { return !(rhs == *this); }
 };
 
-REFL_TYPE(Point, bases<>)
+REFL_TYPE(Direction, bases<>)
 REFL_FIELD(x, Serializable())
 REFL_FIELD(y, Serializable())
-REFL_FUNC(magnitude)
+REFL_FIELD(z, Serializable())
 REFL_END
 
-struct Line
+struct EncodedTransform
 {
-	Point start = {};
-	Point end = {};
-
-	[[nodiscard]] float length() const { return Point{end.x - start.x, end.y - start.y}.magnitude(); }
+	Point position = {};
+	float rotation = 0.f;
+	float scale = 1.f;
+	Direction forward = {};
 
-	bool operator==(const Line & rhs) const { return start == rhs.start && end == rhs.end; }
-	bool operator!=(const Line & rhs) const { return !(rhs == *this); }
+	bool operator==(const EncodedTransform & rhs) const { return position == rhs.position && rotation == rhs.rotation && scale == rhs.scale && forward == rhs.forward; }
+	bool operator!=(const EncodedTransform & rhs) const { return !(rhs == *this); }
 };
 
-REFL_TYPE(Line, bases<>)
-REFL_FIELD(start, Serializable())
-REFL_FIELD(end, Serializable())
-REFL_FUNC(length)
+REFL_TYPE(EncodedTransform, bases<>)
+REFL_FIELD(position, Serializable(), Grafkit::Attributes::Quantized(-128.f, 127.f, 8))
+REFL_FIELD(rotation, Serializable(), Grafkit::Attributes::HalfFloat())
+REFL_FIELD(scale, Serializable(), Grafkit::Attributes::FixedPoint(8))
+REFL_FIELD(forward, Serializable(), Grafkit::Attributes::Octahedral(16))
 REFL_END
 
 // --- 
@@ -194,6 +224,20 @@ TYPED_TEST(TestSerialization, Struct)
 	VerifySerialization(Line{{2., 2.}, {1., 1.}});
 }
 
+TYPED_TEST(TestSerialization, SparseStruct)
+{
+	VerifySerialization(SparseConfig{});
+	VerifySerialization(SparseConfig{1920, 1200, 1.f, "", {}, {}});
+	VerifySerialization(SparseConfig{640, 480, 2.f, "Window", {1, 2, 3}, {4, 5}});
+}
+
+TYPED_TEST(TestSerialization, EncodedFields)
+{
+	VerifySerialization(EncodedTransform{});
+	VerifySerialization(EncodedTransform{{3.f, -5.f}, 1.5f, 2.25f, {0.f, 0.6f, -0.8f}});
+	VerifySerialization(EncodedTransform{{-128.f, 127.f}, -0.125f, -3.5f, {1.f, 0.f, 0.f}});
+}
+
 TYPED_TEST(TestSerialization, STLContainers)
 {
 	std::set<int> c;
@@ -214,6 +258,29 @@ TYPED_TEST(TestSerialization, STLContainers)
 	VerifySerialization(std::unordered_map<int, std::string>({std::make_pair(1, "a"), std::make_pair(2, "bb")}));
 	VerifySerialization(std::multimap<int, std::string>({std::make_pair(1, "a"), std::make_pair(2, "bb")}));
 	VerifySerialization(std::unordered_multimap<int, std::string>({std::make_pair(1, "a"), std::make_pair(2, "bb")}));
+	VerifySerialization(Grafkit::FlatMap<int, std::string>({std::make_pair(1, "a"), std::make_pair(2, "bb")}));
+	VerifySerialization(std::vector<bool>({true, false, false, true, true}));
+	VerifySerialization(std::bitset<70>("1000000000000000000000000000000000000000000000000000000000000000001011"));
+}
+
+TYPED_TEST(TestSerialization, SortedContainers)
+{
+	std::map<int, int> map;
+	std::multimap<int, int> multimap;
+	std::set<int> set;
+	Grafkit::FlatMap<int, int> flatMap;
+	for (int i = 0; i < 4096; ++i)
+	{
+		map.emplace(i, i * i);
+		multimap.emplace(i / 2, i);
+		set.insert(i);
+		flatMap[i] = -i;
+	}
+
+	VerifySerialization(map);
+	VerifySerialization(multimap);
+	VerifySerialization(set);
+	VerifySerialization(flatMap);
 }
 
 // TODO ... the rest of the tests
@@ -40,6 +40,65 @@ REFL_FIELD(p1, Serializable())
 REFL_FIELD(w, Serializable())
 REFL_END
 
+struct SparsePoint
+{
+	float x = 0.f;
+	float y = 0.f;
+};
+
+REFL_TYPE(SparsePoint, bases<>, Grafkit::Attributes::Sparse())
+REFL_FIELD(x, Serializable())
+REFL_FIELD(y, Serializable())
+REFL_END
+
+struct HalfPoint
+{
+	float x = 0.f;
+	float y = 0.f;
+};
+
+REFL_TYPE(HalfPoint, bases<>)
+REFL_FIELD(x, Serializable(), Grafkit::Attributes::HalfFloat())
+REFL_FIELD(y, Serializable(), Grafkit::Attributes::HalfFloat())
+REFL_END
+
+struct QuantizedPoint
+{
+	float x = 0.f;
+	float y = 0.f;
+};
+
+REFL_TYPE(QuantizedPoint, bases<>)
+REFL_FIELD(x, Serializable(), Grafkit::Attributes::Quantized(-1.5f, 2.f, 12))
+REFL_FIELD(y, Serializable(), Grafkit::Attributes::Quantized(-1e30f, 1e30f, 16))
+REFL_END
+
+struct Switches
+{
+	bool on = false;
+	bool visible = false;
+	std::vector<bool> mask;
+};
+
+REFL_TYPE(Switches, bases<>)
+REFL_FIELD(on, Serializable())
+REFL_FIELD(visible, Serializable())
+REFL_FIELD(mask, Serializable())
+REFL_END
+
+struct SwitchesApart
+{
+	bool on = false;
+	int level = 0;
+	bool visible = false;
+};
+
+REFL_TYPE(SwitchesApart, bases<>)
+REFL_FIELD(on, Serializable())
+REFL_FIELD(level, Serializable())
+REFL_FIELD(visible, Serializable())
+REFL_END
+
 struct TestingBaseTypes
 {
 	bool b;
@@ -210,6 +269,24 @@ TEST(SignatureTest, STLs)
 		signature.data);
 }
 
+TEST(SignatureTest, SparseStruct)
+{
+	constexpr auto signature = Grafkit::Utils::Signature::CalcString<SparsePoint>();
+	ASSERT_STREQ("float x; float y; [sparse] ", signature.c_str());
+}
+
+TEST(SignatureTest, Bitset)
+{
+	constexpr auto typeName = Grafkit::Utils::Signature::FindTypeName<std::bitset<128>>::value;
+	ASSERT_STREQ("std::bitset<128>", typeName.c_str());
+}
+
+TEST(SignatureTest, FlatMap)
+{
+	constexpr auto typeName = Grafkit::Utils::Signature::FindTypeName<Grafkit::FlatMap<int, std::string>>::value;
+	ASSERT_STREQ("Grafkit::FlatMap<int, std::string>", typeName.c_str());
+}
+
 TEST(SignatureTest, SimpleClass)
 {
 	constexpr auto signature = Grafkit::Utils::Signature::CalcString<SimpleClazz>();
@@ -248,6 +325,46 @@ TEST(ChecksumTests, STLs)
 	ASSERT_EQ(checksum, Checksum(signature.c_str(), signature.size()));
 }
 
+TEST(ChecksumTests, SparseStruct)
+{
+	constexpr auto signature = Grafkit::Utils::Signature::CalcString<SparsePoint>();
+	const auto checksum = Grafkit::Utils::Signature::CalcChecksum<SparsePoint>();
+	ASSERT_EQ(checksum, Checksum(signature.c_str(), signature.size));
+}
+
+TEST(ChecksumTests, EncodedFields)
+{
+	const auto checksum = Grafkit::Utils::Signature::CalcChecksum<HalfPoint>();
+	ASSERT_NE(checksum, Grafkit::Utils::Signature::CalcChecksum<Point>());
+
+	constexpr auto signature = Grafkit::Utils::Signature::CalcString<HalfPoint>();
+	ASSERT_STREQ("float x:half; float y:half; ", signature.c_str());
+	ASSERT_EQ(checksum, Checksum(signature.c_str(), signature.size));
+}
+
+TEST(ChecksumTests, EncodingParameters)
+{
+	// Parameters too large for the fingerprint saturate
+	constexpr auto signature = Grafkit::Utils::Signature::CalcString<QuantizedPoint>();
+	ASSERT_STREQ("float x:quantized(-1500000,2000000,12); float y:quantized(-9223372036854775808,9223372036854775807,16); ", signature.c_str());
+
+	const auto checksum = Grafkit::Utils::Signature::CalcChecksum<QuantizedPoint>();
+	ASSERT_EQ(checksum, Checksum(signature.c_str(), signature.size));
+}
+
+TEST(ChecksumTests, PackedBits)
+{
+	constexpr auto signature = Grafkit::Utils::Signature::CalcString<Switches>();
+	ASSERT_STREQ("bool on; bool visible; std::vector<bool> mask:packed; [packed bools] ", signature.c_str());
+
+	const auto checksum = Grafkit::Utils::Signature::CalcChecksum<Switches>();
+	ASSERT_EQ(checksum, Checksum(signature.c_str(), signature.size));
+
+	// Bools with other members in between are not packed
+	constexpr auto apartSignature = Grafkit::Utils::Signature::CalcString<SwitchesApart>();
+	ASSERT_STREQ("bool on; int level; bool visible; ", apartSignature.c_str());
+}
+
 // ...
 TEST(ChecksumTests, SimpleClass)
 {
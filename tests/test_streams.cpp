@@ -0,0 +1,857 @@
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+//
+#include <gtest/gtest.h>
+//
+#include <Serialization/AsyncStream.h>
+#include <Serialization/DirectFileStream.h>
+#include <Serialization/FilterPipeline.h>
+#include <Serialization/GatherStream.h>
+#include <Serialization/MemoryStream.h>
+#include <Serialization/RingStream.h>
+#include <Serialization/SharedRingStream.h>
+#include <Serialization/Serialization.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using BinarySerializer = Grafkit::BinarySerializer;
+using Serializable = Grafkit::Attributes::Serializable;
+using Property = Grafkit::Attributes::Property;
+
+struct TextureAsset
+{
+	std::string name;
+	std::vector<uint8_t> pixels;
+	int width = 0;
+	int height = 0;
+
+	bool operator==(const TextureAsset & rhs) const { return name == rhs.name && pixels == rhs.pixels && width == rhs.width && height == rhs.height; }
+	bool operator!=(const TextureAsset & rhs) const { return !(rhs == *this); }
+};
+
+REFL_TYPE(TextureAsset, bases<>)
+REFL_FIELD(name, Serializable())
+REFL_FIELD(pixels, Serializable())
+REFL_FIELD(width, Serializable())
+REFL_FIELD(height, Serializable())
+REFL_END
+
+class GeneratedAsset
+{
+public:
+	std::string Header() const { return std::string(32 * 1024, 'h'); }
+	void SetHeader(const std::string & header) { mHeader = header; }
+	std::string Body() const { return std::string(48 * 1024, 'b'); }
+	void SetBody(const std::string & body) { mBody = body; }
+
+	std::string mHeader, mBody;
+};
+
+REFL_TYPE(GeneratedAsset, bases<>)
+REFL_FUNC(Header, Property("header"), Serializable())
+REFL_FUNC(SetHeader, Property("header"), Serializable())
+REFL_FUNC(Body, Property("body"), Serializable())
+REFL_FUNC(SetBody, Property("body"), Serializable())
+REFL_END
+
+namespace
+{
+	std::string TempPath(const std::string & name) { return (std::filesystem::temp_directory_path() / name).string(); }
+
+	std::vector<int> MakeValues(const int count)
+	{
+		std::vector<int> values;
+		for (int i = 0; i < count; ++i) values.push_back(i * 31 - 7);
+		return values;
+	}
+} // namespace
+
+// --- Async output
+
+TEST(AsyncOutputStream, WritesThroughBackgroundThread)
+{
+	const auto path = TempPath("grafkit_async_output.bin");
+	const auto values = MakeValues(100000);
+	{
+		Grafkit::AsyncOutputStream stream(path, {4096, 2, Grafkit::EFsyncPolicy::OnClose});
+		BinarySerializer serializer(stream);
+		serializer << values << std::string("trailer");
+		ASSERT_NO_THROW(stream.Close().get());
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	Grafkit::InputStream<std::ifstream> stream(file);
+	BinarySerializer serializer(stream);
+	std::vector<int> readValues;
+	std::string trailer;
+	serializer >> readValues >> trailer;
+
+	ASSERT_EQ(values, readValues);
+	ASSERT_EQ("trailer", trailer);
+	std::filesystem::remove(path);
+}
+
+TEST(AsyncOutputStream, BackPressureKeepsOrder)
+{
+	const auto path = TempPath("grafkit_async_backpressure.bin");
+	std::string expected;
+	{
+		// Tiny buffers with a single one in flight, so the writer has to wait for the disk every now and then
+		Grafkit::AsyncOutputStream stream(path, {16, 1, Grafkit::EFsyncPolicy::EveryBuffer});
+		for (int i = 0; i < 2000; ++i)
+		{
+			const auto chunk = std::to_string(i) + ",";
+			stream.Write(chunk.data(), chunk.size());
+			expected += chunk;
+		}
+		stream.Flush();
+		// Destructor closes and waits for the background thread
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	ASSERT_EQ(expected, content);
+	std::filesystem::remove(path);
+}
+
+TEST(AsyncOutputStream, RejectsWritesAfterClose)
+{
+	const auto path = TempPath("grafkit_async_closed.bin");
+	Grafkit::AsyncOutputStream stream(path);
+	stream.Close().wait();
+	ASSERT_FALSE(stream.IsSuccess());
+	ASSERT_THROW(stream.Write("x", 1), std::runtime_error);
+	std::filesystem::remove(path);
+}
+
+TEST(AsyncOutputStream, InvalidPathThrows)
+{
+	ASSERT_THROW(Grafkit::AsyncOutputStream(TempPath("no_such_directory/file.bin")), std::runtime_error);
+}
+
+// --- Prefetching input
+
+TEST(PrefetchInputStream, ReadsAcrossBlocks)
+{
+	const auto path = TempPath("grafkit_prefetch.bin");
+	const auto values = MakeValues(50000);
+	{
+		std::ofstream file(path, std::ios::binary);
+		Grafkit::OutputStream<std::ofstream> stream(file);
+		BinarySerializer serializer(stream);
+		serializer << values << std::string("trailer");
+	}
+
+	{
+		// Odd block size, so values straddle block boundaries
+		Grafkit::PrefetchInputStream stream(path, {1000, 3});
+		BinarySerializer serializer(stream);
+		std::vector<int> readValues;
+		std::string trailer;
+		serializer >> readValues >> trailer;
+
+		ASSERT_EQ(values, readValues);
+		ASSERT_EQ("trailer", trailer);
+
+		int pastEnd = 0;
+		ASSERT_THROW(serializer >> pastEnd, std::runtime_error);
+		ASSERT_FALSE(stream.IsSuccess());
+	}
+	std::filesystem::remove(path);
+}
+
+TEST(PrefetchInputStream, ReadAll)
+{
+	const auto path = TempPath("grafkit_prefetch_all.bin");
+	const std::string content(10000, 'x');
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << content;
+	}
+
+	Grafkit::PrefetchInputStream stream(path, {256, 2});
+	char head[10];
+	stream.Read(head, sizeof(head));
+	Grafkit::StreamData rest;
+	ASSERT_TRUE(stream.ReadAll(rest));
+	ASSERT_EQ(content.size() - sizeof(head), rest.size());
+	std::filesystem::remove(path);
+}
+
+TEST(PrefetchInputStream, EarlyDestruction)
+{
+	const auto path = TempPath("grafkit_prefetch_early.bin");
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << std::string(100000, 'y');
+	}
+
+	// Background thread still has blocks to read when the stream goes away
+	{
+		Grafkit::PrefetchInputStream stream(path, {64, 2});
+		char c = 0;
+		stream.Read(&c, 1);
+		ASSERT_EQ('y', c);
+	}
+	std::filesystem::remove(path);
+}
+
+#ifdef __linux__
+
+TEST(PrefetchInputStream, ReadErrorReachesReader)
+{
+	// A directory opens fine, reading it fails on the background thread
+	Grafkit::PrefetchInputStream stream(std::filesystem::temp_directory_path().string(), {64, 2});
+	char c = 0;
+	ASSERT_THROW(stream.Read(&c, 1), std::runtime_error);
+}
+
+#endif
+
+// --- Direct file I/O
+
+#ifdef __linux__
+
+TEST(DirectFileStream, RoundTripAllBackends)
+{
+	const auto path = TempPath("grafkit_direct.bin");
+	const auto values = MakeValues(300000);
+
+	for (const bool useIoUring : {true, false})
+	{
+		for (const bool directIo : {false, true})
+		{
+			const Grafkit::DirectFileOptions options{8192, 3, directIo, useIoUring};
+			{
+				Grafkit::DirectFileStream stream(path, Grafkit::EFileMode::Write, options);
+				BinarySerializer serializer(stream);
+				serializer << values << std::string("trailer");
+				stream.Close();
+			}
+
+			// Size is exact, even when the last block was padded for O_DIRECT
+			ASSERT_EQ(sizeof(uint64_t) + values.size() * sizeof(int) + sizeof(uint64_t) + 8, std::filesystem::file_size(path));
+
+			Grafkit::DirectFileStream stream(path, Grafkit::EFileMode::Read, options);
+			BinarySerializer serializer(stream);
+			std::vector<int> readValues;
+			std::string trailer;
+			serializer >> readValues >> trailer;
+			ASSERT_EQ(values, readValues);
+			ASSERT_EQ("trailer", trailer);
+
+			char pastEnd = 0;
+			stream.Read(&pastEnd, 1);
+			ASSERT_FALSE(stream.IsSuccess());
+		}
+	}
+	std::filesystem::remove(path);
+}
+
+TEST(DirectFileStream, EmptyFile)
+{
+	const auto path = TempPath("grafkit_direct_empty.bin");
+	{
+		Grafkit::DirectFileStream stream(path, Grafkit::EFileMode::Write);
+	}
+	Grafkit::DirectFileStream stream(path, Grafkit::EFileMode::Read);
+	Grafkit::StreamData data;
+	ASSERT_TRUE(stream.ReadAll(data));
+	ASSERT_TRUE(data.empty());
+	std::filesystem::remove(path);
+}
+
+#endif
+
+// --- Gather write
+
+#ifndef _WIN32
+
+TEST(GatherWriteStream, LargePayloadsAreNotCopied)
+{
+	const auto path = TempPath("grafkit_gather.bin");
+
+	std::vector<TextureAsset> textures;
+	for (int i = 0; i < 8; ++i)
+	{
+		TextureAsset texture{"texture_" + std::to_string(i), std::vector<uint8_t>(256 * 256 * 4, static_cast<uint8_t>(i)), 256, 256};
+		textures.push_back(std::move(texture));
+	}
+
+	std::stringstream expected;
+	{
+		Grafkit::Stream<std::stringstream> stream(expected);
+		BinarySerializer serializer(stream);
+		serializer << textures;
+	}
+
+	size_t copiedBytes = 0;
+	size_t borrowedBytes = 0;
+	{
+		Grafkit::GatherWriteStream stream(path, {4096, 1024});
+		BinarySerializer serializer(stream);
+		serializer << textures;
+		copiedBytes = stream.CopiedBytes();
+		borrowedBytes = stream.BorrowedBytes();
+	}
+
+	ASSERT_EQ(textures.size() * textures[0].pixels.size(), borrowedBytes);
+	ASSERT_LT(copiedBytes, 1024u);
+
+	std::ifstream file(path, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	ASSERT_EQ(expected.str(), content);
+	std::filesystem::remove(path);
+}
+
+TEST(GatherWriteStream, GetterTemporariesAreNotBorrowed)
+{
+	const auto path = TempPath("grafkit_gather_getters.bin");
+	{
+		Grafkit::GatherWriteStream stream(path, {4096, 1024});
+		BinarySerializer serializer(stream);
+		serializer << GeneratedAsset{};
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	Grafkit::InputStream<std::ifstream> stream(file);
+	BinarySerializer serializer(stream);
+	GeneratedAsset readAsset;
+	serializer >> readAsset;
+	ASSERT_EQ(GeneratedAsset{}.Header(), readAsset.mHeader);
+	ASSERT_EQ(GeneratedAsset{}.Body(), readAsset.mBody);
+	std::filesystem::remove(path);
+}
+
+TEST(GatherWriteStream, SmallWritesAreCoalesced)
+{
+	const auto path = TempPath("grafkit_gather_small.bin");
+	const auto values = MakeValues(1000);
+	size_t writevCalls = 0;
+	{
+		Grafkit::GatherWriteStream stream(path);
+		BinarySerializer serializer(stream);
+		for (const auto value : values) serializer << value;
+		stream.Flush();
+		writevCalls = stream.WritevCalls();
+	}
+	ASSERT_EQ(1u, writevCalls);
+
+	std::ifstream file(path, std::ios::binary);
+	Grafkit::InputStream<std::ifstream> stream(file);
+	BinarySerializer serializer(stream);
+	for (const auto value : values)
+	{
+		int readValue = 0;
+		serializer >> readValue;
+		ASSERT_EQ(value, readValue);
+	}
+	std::filesystem::remove(path);
+}
+
+#endif
+
+// --- Memory streams
+
+TEST(MemoryStream, RoundTrip)
+{
+	const TextureAsset asset{"albedo", std::vector<uint8_t>(300, 0x7f), 10, 30};
+
+	Grafkit::MemoryStream stream;
+	Grafkit::BasicBinarySerializer<Grafkit::MemoryStream> serializer(stream);
+	serializer << asset << 42;
+
+	TextureAsset loaded;
+	int tail = 0;
+	serializer >> loaded >> tail;
+
+	EXPECT_EQ(asset, loaded);
+	EXPECT_EQ(42, tail);
+
+	// Nothing left to read
+	EXPECT_THROW(serializer >> tail, std::runtime_error);
+}
+
+TEST(MemoryStream, MatchesStringStreamOutput)
+{
+	const TextureAsset asset{"normal", std::vector<uint8_t>(64, 3), 8, 8};
+
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stringStream(s);
+	BinarySerializer(stringStream) << asset;
+	const auto expected = s.str();
+
+	const auto bytes = Grafkit::ToBytes(asset);
+	ASSERT_EQ(expected.size(), bytes.size());
+	EXPECT_EQ(0, std::memcmp(expected.data(), bytes.data(), bytes.size()));
+	EXPECT_EQ(bytes.size(), Grafkit::SerializedSize(asset));
+
+	// Type-erased use through StreamRef
+	Grafkit::MemoryStream memory;
+	Grafkit::StreamRef<Grafkit::MemoryStream> ref(memory);
+	BinarySerializer(ref) << asset;
+	EXPECT_EQ(bytes.size(), memory.Size());
+}
+
+TEST(MemoryStream, ToBytesFromBytes)
+{
+	const TextureAsset asset{"height", std::vector<uint8_t>(1000, 9), 25, 40};
+
+	const auto bytes = Grafkit::ToBytes(asset);
+	const auto loaded = Grafkit::FromBytes<TextureAsset>(bytes);
+	EXPECT_EQ(asset, loaded);
+
+	// Truncated input
+	const Grafkit::Span<const std::byte> truncated(bytes.data(), bytes.size() - 1);
+	EXPECT_THROW(Grafkit::FromBytes<TextureAsset>(truncated), std::runtime_error);
+}
+
+TEST(SpanOutputStream, FixedBuffer)
+{
+	const auto values = MakeValues(16);
+	std::vector<std::byte> buffer(Grafkit::SerializedSize(values));
+
+	EXPECT_EQ(buffer.size(), Grafkit::ToBytes(values, buffer));
+	EXPECT_EQ(values, Grafkit::FromBytes<std::vector<int>>(buffer));
+
+	std::vector<std::byte> small(buffer.size() / 2);
+	EXPECT_THROW(Grafkit::ToBytes(values, small), std::runtime_error);
+}
+
+TEST(SpanOutputStream, UndersizedBufferThrows)
+{
+	// Strings go element by element, so writing carries on after the first one that does not fit
+	const std::vector<std::string> values(10, std::string(10, 'a'));
+	std::vector<std::byte> small(16);
+	EXPECT_THROW(Grafkit::ToBytes(values, small), std::runtime_error);
+}
+
+// --- SPSC ring
+
+TEST(RingStream, ProducerConsumer)
+{
+	// Small ring, so frames wrap around and both sides stall
+	Grafkit::RingStream ring({4096, true});
+	constexpr int frameCount = 2000;
+
+	std::thread producer([&ring] {
+		BinarySerializer serializer(ring);
+		for (int i = 0; i < frameCount; ++i)
+		{
+			serializer << TextureAsset{"t" + std::to_string(i), std::vector<uint8_t>(i % 300, uint8_t(i)), i, -i};
+			ring.Commit();
+		}
+		ring.Close();
+	});
+
+	BinarySerializer serializer(ring);
+	int count = 0;
+	while (ring.WaitForFrame())
+	{
+		TextureAsset asset;
+		serializer >> asset;
+		ASSERT_EQ("t" + std::to_string(count), asset.name);
+		ASSERT_EQ(size_t(count % 300), asset.pixels.size());
+		ASSERT_EQ(-count, asset.height);
+		++count;
+	}
+	producer.join();
+	EXPECT_EQ(frameCount, count);
+}
+
+TEST(RingStream, BatchCommit)
+{
+	Grafkit::RingStream ring({1024, false});
+	BinarySerializer serializer(ring);
+
+	serializer << 1 << 2;
+	EXPECT_FALSE(ring.HasFrame());
+	EXPECT_TRUE(ring.Commit());
+	EXPECT_TRUE(ring.HasFrame());
+
+	int a = 0, b = 0;
+	serializer >> a >> b;
+	EXPECT_EQ(1, a);
+	EXPECT_EQ(2, b);
+	EXPECT_FALSE(ring.HasFrame());
+
+	// Reading past the committed data fails in non-blocking mode
+	EXPECT_THROW(serializer >> a, std::runtime_error);
+}
+
+TEST(RingStream, NonBlockingDropsFrameThatDoesNotFit)
+{
+	Grafkit::RingStream ring({256, false});
+	BinarySerializer serializer(ring);
+
+	// Frames larger than the whole ring are an error
+	EXPECT_THROW(serializer << std::vector<uint8_t>(300, 2), std::runtime_error);
+	EXPECT_FALSE(ring.Commit());
+
+	const std::vector<uint8_t> payload(100, 1);
+	serializer << payload;
+	EXPECT_TRUE(ring.Commit());
+	serializer << payload;
+	EXPECT_TRUE(ring.Commit());
+	serializer << payload;
+	EXPECT_FALSE(ring.Commit());
+
+	std::vector<uint8_t> loaded;
+	serializer >> loaded;
+	EXPECT_EQ(payload, loaded);
+
+	// The dropped frame fits once space is released
+	serializer << payload;
+	EXPECT_TRUE(ring.Commit());
+	for (int i = 0; i < 2; ++i)
+	{
+		loaded.clear();
+		serializer >> loaded;
+		EXPECT_EQ(payload, loaded);
+	}
+	EXPECT_FALSE(ring.HasFrame());
+}
+
+// --- Shared memory ring
+
+#ifdef __linux__
+
+namespace
+{
+	TextureAsset MakeAsset(const int i) { return {"frame" + std::to_string(i), std::vector<uint8_t>((i * 37) % 3000, uint8_t(i)), i, i * 2}; }
+
+	// Runs body in a child process, which exits with 0 unless body threw
+	template <typename Body> pid_t Spawn(Body && body)
+	{
+		const pid_t pid = fork();
+		if (pid == 0)
+		{
+			int status = 0;
+			try
+			{
+				body();
+			}
+			catch (...)
+			{
+				status = 1;
+			}
+			_exit(status);
+		}
+		return pid;
+	}
+
+	int Join(const pid_t pid)
+	{
+		int status = 0;
+		waitpid(pid, &status, 0);
+		return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	}
+} // namespace
+
+TEST(SharedRingStream, TwoProcessStress)
+{
+	const auto name = "/gk_ring_stress_" + std::to_string(getpid());
+	constexpr int frameCount = 5000;
+
+	// Both sides race for creating the segment
+	const auto producer = Spawn([&name] {
+		Grafkit::SharedRingStream ring(name, Grafkit::ESharedRingRole::Producer, {64 << 10});
+		BinarySerializer serializer(ring);
+		for (int i = 0; i < frameCount; ++i)
+		{
+			serializer << MakeAsset(i);
+			ring.Commit();
+		}
+		ring.Close();
+	});
+
+	{
+		Grafkit::SharedRingStream ring(name, Grafkit::ESharedRingRole::Consumer, {64 << 10});
+		BinarySerializer serializer(ring);
+		int count = 0;
+		while (ring.WaitForFrame())
+		{
+			TextureAsset asset;
+			serializer >> asset;
+			ASSERT_EQ(MakeAsset(count++), asset);
+		}
+		EXPECT_EQ(frameCount, count);
+	}
+
+	EXPECT_EQ(0, Join(producer));
+	Grafkit::SharedRingStream::Remove(name);
+}
+
+TEST(SharedRingStream, RecoversFromCrashes)
+{
+	const auto name = "/gk_ring_crash_" + std::to_string(getpid());
+	Grafkit::SharedRingStream::Remove(name);
+
+	auto consumer = std::make_unique<Grafkit::SharedRingStream>(name, Grafkit::ESharedRingRole::Consumer, Grafkit::SharedRingOptions{1 << 16});
+
+	// Producer dies in the middle of a frame, without closing
+	const auto crashed = Spawn([&name] {
+		Grafkit::SharedRingStream ring(name, Grafkit::ESharedRingRole::Producer);
+		BinarySerializer serializer(ring);
+		for (int i = 0; i < 10; ++i)
+		{
+			serializer << MakeAsset(i);
+			ring.Commit();
+		}
+		serializer << MakeAsset(99);
+		_exit(0);
+	});
+	EXPECT_EQ(0, Join(crashed));
+
+	int next = 0;
+	TextureAsset asset;
+	{
+		BinarySerializer serializer(*consumer);
+		while (consumer->WaitForFrame())
+		{
+			asset = {};
+			serializer >> asset;
+			EXPECT_EQ(MakeAsset(next++), asset);
+		}
+	}
+	EXPECT_EQ(10, next);
+
+	// A new producer takes over from the last committed frame
+	const auto restarted = Spawn([&name] {
+		Grafkit::SharedRingStream ring(name, Grafkit::ESharedRingRole::Producer);
+		BinarySerializer serializer(ring);
+		for (int i = 10; i < 15; ++i)
+		{
+			serializer << MakeAsset(i);
+			ring.Commit();
+		}
+		ring.Close();
+	});
+	EXPECT_EQ(0, Join(restarted));
+
+	// The consumer goes away halfway into a frame, its successor gets that frame again
+	ASSERT_TRUE(consumer->WaitForFrame());
+	int32_t partial = 0;
+	consumer->Read(reinterpret_cast<char *>(&partial), sizeof(partial));
+	consumer.reset();
+
+	Grafkit::SharedRingStream successor(name, Grafkit::ESharedRingRole::Consumer);
+	BinarySerializer serializer(successor);
+	while (successor.WaitForFrame())
+	{
+		asset = {};
+		serializer >> asset;
+		EXPECT_EQ(MakeAsset(next++), asset);
+	}
+	EXPECT_EQ(15, next);
+
+	// Another producer opens the closed stream again, and fills the ring more than once
+	const auto reopened = Spawn([&name] {
+		Grafkit::SharedRingStream ring(name, Grafkit::ESharedRingRole::Producer);
+		BinarySerializer serializer(ring);
+		for (int i = 15; i < 215; ++i)
+		{
+			serializer << MakeAsset(i);
+			ring.Commit();
+		}
+		ring.Close();
+	});
+	while (!successor.HasFrame()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	while (successor.WaitForFrame())
+	{
+		asset = {};
+		serializer >> asset;
+		EXPECT_EQ(MakeAsset(next++), asset);
+	}
+	EXPECT_EQ(215, next);
+	EXPECT_EQ(0, Join(reopened));
+	Grafkit::SharedRingStream::Remove(name);
+}
+
+// The tests below poke at the segment directly: the header takes the first page, its creator pid is at offset 16, the ring follows
+
+TEST(SharedRingStream, RejectsCorruptFrameLength)
+{
+	const auto name = "/gk_ring_corrupt_" + std::to_string(getpid());
+	Grafkit::SharedRingStream::Remove(name);
+
+	Grafkit::SharedRingStream producer(name, Grafkit::ESharedRingRole::Producer, {1 << 16});
+	BinarySerializer(producer) << MakeAsset(1);
+	producer.Commit();
+
+	const int fd = shm_open(name.c_str(), O_RDWR, 0);
+	ASSERT_GE(fd, 0);
+	void * mapping = mmap(nullptr, 4096 + 8, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	ASSERT_NE(MAP_FAILED, mapping);
+	const uint64_t length = uint64_t(1) << 40;
+	std::memcpy(static_cast<char *>(mapping) + 4096, &length, sizeof(length));
+	munmap(mapping, 4096 + 8);
+	close(fd);
+
+	Grafkit::SharedRingStream consumer(name, Grafkit::ESharedRingRole::Consumer);
+	EXPECT_THROW(consumer.WaitForFrame(), std::runtime_error);
+	Grafkit::SharedRingStream::Remove(name);
+}
+
+TEST(SharedRingStream, TakesOverFromDeadCreator)
+{
+	const auto name = "/gk_ring_creator_" + std::to_string(getpid());
+	Grafkit::SharedRingStream::Remove(name);
+
+	// Creator dies after sizing the segment, before publishing it
+	const auto crashed = Spawn([&name] {
+		const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd < 0 || ftruncate(fd, 4096 + (1 << 16)) != 0) throw std::runtime_error("setup");
+		void * mapping = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED) throw std::runtime_error("setup");
+		const int32_t self = getpid();
+		std::memcpy(static_cast<char *>(mapping) + 16, &self, sizeof(self));
+		_exit(0);
+	});
+	ASSERT_EQ(0, Join(crashed));
+
+	const auto start = std::chrono::steady_clock::now();
+	Grafkit::SharedRingStream consumer(name, Grafkit::ESharedRingRole::Consumer, {1 << 16, 60000});
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+
+	const auto producer = Spawn([&name] {
+		Grafkit::SharedRingStream ring(name, Grafkit::ESharedRingRole::Producer);
+		BinarySerializer(ring) << MakeAsset(3);
+		ring.Commit();
+		ring.Close();
+	});
+
+	BinarySerializer serializer(consumer);
+	ASSERT_TRUE(consumer.WaitForFrame());
+	TextureAsset asset;
+	serializer >> asset;
+	EXPECT_EQ(MakeAsset(3), asset);
+	EXPECT_EQ(0, Join(producer));
+	Grafkit::SharedRingStream::Remove(name);
+}
+
+#endif
+
+// --- Filter pipeline
+
+namespace
+{
+	std::vector<std::byte> RunPipeline(const Grafkit::FilterPipelineOptions & options, uint32_t & crc)
+	{
+		Grafkit::MemoryStream memory;
+		Grafkit::StreamRef<Grafkit::MemoryStream> sink(memory);
+		{
+			Grafkit::FilterPipeline pipeline(sink, options);
+			auto & checksum = pipeline.Emplace<Grafkit::Crc32Stage>(true);
+			pipeline.Emplace<Grafkit::TransformStage>([](Grafkit::FilterBlock & block) {
+				for (auto & c : block.data) c = static_cast<char>(c ^ 0x5a);
+			});
+
+			BinarySerializer serializer(pipeline);
+			for (int i = 0; i < 200; ++i) serializer << TextureAsset{"tex" + std::to_string(i), std::vector<uint8_t>(i * 13, uint8_t(i)), i, i};
+			pipeline.Close();
+			crc = checksum.Value();
+		}
+		return memory.Release();
+	}
+} // namespace
+
+TEST(FilterPipeline, Crc32)
+{
+	const char check[] = "123456789";
+	EXPECT_EQ(0xcbf43926u, ~Grafkit::Crc32Stage::Update(0xffffffff, check, 9));
+}
+
+TEST(FilterPipeline, ParallelMatchesSerial)
+{
+	uint32_t serialCrc = 0, parallelCrc = 0;
+	const auto serial = RunPipeline({4096, false}, serialCrc);
+	const auto parallel = RunPipeline({4096, true, 1}, parallelCrc);
+	EXPECT_EQ(serial, parallel);
+	EXPECT_EQ(serialCrc, parallelCrc);
+
+	// Undo the transform and check the trailing checksum
+	std::vector<char> plain(serial.size());
+	for (size_t i = 0; i < serial.size(); ++i) plain[i] = static_cast<char>(static_cast<char>(serial[i]) ^ 0x5a);
+	uint32_t trailer = 0;
+	for (int i = 0; i < 4; ++i) trailer |= uint32_t(uint8_t(plain[plain.size() - 4 + i])) << (8 * i);
+	EXPECT_EQ(serialCrc, trailer);
+	EXPECT_EQ(serialCrc, ~Grafkit::Crc32Stage::Update(0xffffffff, plain.data(), plain.size() - 4));
+
+	Grafkit::MemoryStream decoded(std::vector<std::byte>(reinterpret_cast<std::byte *>(plain.data()), reinterpret_cast<std::byte *>(plain.data()) + plain.size() - 4));
+	Grafkit::BasicBinarySerializer<Grafkit::MemoryStream> serializer(decoded);
+	for (int i = 0; i < 200; ++i)
+	{
+		TextureAsset asset;
+		serializer >> asset;
+		ASSERT_EQ(size_t(i * 13), asset.pixels.size());
+	}
+}
+
+TEST(FilterPipeline, StageErrorReachesWriter)
+{
+	Grafkit::MemoryStream memory;
+	Grafkit::StreamRef<Grafkit::MemoryStream> sink(memory);
+	Grafkit::FilterPipeline pipeline(sink, {1024, true, 1});
+	int blocks = 0;
+	pipeline.Emplace<Grafkit::TransformStage>([&blocks](Grafkit::FilterBlock &) {
+		if (++blocks == 3) throw std::runtime_error("stage failed");
+	});
+
+	const std::vector<char> chunk(1024, 'x');
+	EXPECT_THROW(
+		{
+			for (int i = 0; i < 100; ++i) pipeline.Write(chunk.data(), chunk.size());
+			pipeline.Close();
+		},
+		std::runtime_error);
+	EXPECT_FALSE(pipeline.IsSuccess());
+}
+
+TEST(FilterPipeline, SerialCloseAfterStageError)
+{
+	Grafkit::MemoryStream memory;
+	Grafkit::StreamRef<Grafkit::MemoryStream> sink(memory);
+	Grafkit::FilterPipeline pipeline(sink, {1024, false});
+	int blocks = 0;
+	pipeline.Emplace<Grafkit::TransformStage>([&blocks](Grafkit::FilterBlock &) {
+		if (++blocks == 2) throw std::runtime_error("stage failed");
+	});
+
+	const std::vector<char> chunk(1024, 'x');
+	pipeline.Write(chunk.data(), chunk.size());
+	EXPECT_THROW(pipeline.Write(chunk.data(), chunk.size()), std::runtime_error);
+
+	// Closing rethrows, without sending the failed block through the stages again
+	EXPECT_THROW(pipeline.Close(), std::runtime_error);
+	EXPECT_EQ(2, blocks);
+	EXPECT_EQ(chunk.size(), memory.Size());
+}
+
+TEST(FilterPipeline, RateLimit)
+{
+	Grafkit::MemoryStream memory;
+	Grafkit::StreamRef<Grafkit::MemoryStream> sink(memory);
+	const auto start = std::chrono::steady_clock::now();
+	{
+		Grafkit::FilterPipeline pipeline(sink, {16 << 10, true});
+		pipeline.Emplace<Grafkit::RateLimitStage>(1 << 20);
+		const std::vector<char> chunk(64 << 10, 'x');
+		for (int i = 0; i < 2; ++i) pipeline.Write(chunk.data(), chunk.size());
+		pipeline.Close();
+	}
+	// 128 KiB at 1 MiB/s
+	EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+	EXPECT_EQ(size_t(128 << 10), memory.Size());
+}
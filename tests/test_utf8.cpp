@@ -0,0 +1,128 @@
+#include <sstream>
+#include <string>
+#include <vector>
+//
+#include <gtest/gtest.h>
+//
+#include <Serialization/LazyJson.h>
+#include <Serialization/Serialization.h>
+#include <Serialization/Utf8.h>
+
+using Grafkit::Utils::Utf8::EKernel;
+using Grafkit::Utils::Utf8::EValidation;
+
+namespace
+{
+	// Long enough for the vector kernels, with the interesting part at every offset of a block
+	std::string Embed(const std::string & part, const size_t offset) { return std::string(offset, 'a') + part + std::string(40, 'z'); }
+
+	// Every kernel the CPU can run, not only the one it picks
+	std::vector<EKernel> SupportedKernels()
+	{
+		std::vector<EKernel> kernels;
+		for (const auto kernel : {EKernel::Scalar, EKernel::Ssse3, EKernel::Avx2})
+			if (Grafkit::Utils::Utf8::IsSupported(kernel)) kernels.push_back(kernel);
+		return kernels;
+	}
+} // namespace
+
+TEST(Utf8, Validation)
+{
+	const std::string valid[] = {"", "plain", "\xc3\xa9t\xc3\xa9", "\xe2\x82\xac", "\xed\x9f\xbf", "\xee\x80\x80", "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf"};
+	const std::string invalid[] = {
+		"\x80",             // lone continuation
+		"\xc3",             // truncated
+		"\xc3\x28",         // lead followed by ASCII
+		"\xc0\xaf",         // overlong 2 byte
+		"\xe0\x80\xaf",     // overlong 3 byte
+		"\xf0\x80\x80\xaf", // overlong 4 byte
+		"\xed\xa0\x80",     // surrogate
+		"\xf4\x90\x80\x80", // above U+10FFFF
+		"\xf8\x88\x80\x80\x80",
+		"\xe2\x82\xac\x80", // one continuation too many
+	};
+	for (const auto kernel : SupportedKernels())
+	{
+		for (size_t offset = 0; offset < 40; ++offset)
+		{
+			for (const auto & text : valid) ASSERT_TRUE(Grafkit::Utils::Utf8::IsValid(Embed(text, offset), kernel)) << offset << " " << static_cast<int>(kernel);
+			for (const auto & text : invalid) ASSERT_FALSE(Grafkit::Utils::Utf8::IsValid(Embed(text, offset), kernel)) << offset << " " << static_cast<int>(kernel);
+			// Truncated at the very end
+			ASSERT_FALSE(Grafkit::Utils::Utf8::IsValid(std::string(offset, 'a') + "\xf0\x90\x80", kernel)) << offset << " " << static_cast<int>(kernel);
+		}
+	}
+}
+
+TEST(Utf8, Replace)
+{
+	// One replacement for each maximal invalid subpart
+	ASSERT_EQ("a\xef\xbf\xbd(\xef\xbf\xbd\xef\xbf\xbd"
+			  "b\xef\xbf\xbd"
+			  "c",
+		Grafkit::Utils::Utf8::ReplaceInvalid("a\xf0(\x8c\xbc"
+											 "b\xe2\x82"
+											 "c"));
+	ASSERT_EQ("\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd", Grafkit::Utils::Utf8::ReplaceInvalid("\xed\xa0\x80"));
+
+	std::string text = "\xc3\xa9t\xc3\xa9";
+	Grafkit::Utils::Utf8::Validate(text, EValidation::Strict);
+	text.push_back('\xc3');
+	EXPECT_THROW(Grafkit::Utils::Utf8::Validate(text, EValidation::Strict), std::runtime_error);
+	Grafkit::Utils::Utf8::Validate(text, EValidation::Replace);
+	ASSERT_EQ("\xc3\xa9t\xc3\xa9\xef\xbf\xbd", text);
+}
+
+TEST(Utf8, BinaryAdapterStrings)
+{
+	const std::vector<std::string> strings = {"valid \xe2\x82\xac", std::string(10000, 'x') + "\xc3\xa9", "bad \xff end"};
+
+	std::stringstream s;
+	Grafkit::Stream<std::stringstream> stream(s);
+	Grafkit::BinarySerializer serializer(stream);
+	serializer << strings << strings;
+
+	// Off by default
+	std::vector<std::string> read;
+	serializer >> read;
+	ASSERT_EQ(strings, read);
+
+	serializer.SetUtf8Validation(EValidation::Replace);
+	read.clear();
+	serializer >> read;
+	ASSERT_EQ(strings[0], read[0]);
+	ASSERT_EQ(strings[1], read[1]);
+	ASSERT_EQ("bad \xef\xbf\xbd end", read[2]);
+
+	std::stringstream again;
+	Grafkit::Stream<std::stringstream> againStream(again);
+	Grafkit::BinarySerializer strict(againStream);
+	strict << strings;
+	strict.SetUtf8Validation(EValidation::Strict);
+	read.clear();
+	EXPECT_THROW(strict >> read, std::runtime_error);
+}
+
+TEST(Utf8, JsonStrings)
+{
+	const std::string text = "[\"ok\xc3\xa9\",\"bad\xc3(\"]";
+
+	std::stringstream s(text);
+	Grafkit::Stream<std::stringstream> stream(s);
+	EXPECT_ANY_THROW(Grafkit::JsonSerializer::ParseJson(stream));
+
+	std::stringstream replaceSource(text);
+	Grafkit::Stream<std::stringstream> replaceStream(replaceSource);
+	const auto json = Grafkit::JsonSerializer::ParseJson(replaceStream, EValidation::Replace);
+	ASSERT_EQ("bad\xef\xbf\xbd(", json[1].get<std::string>());
+
+	// Lazy documents are not validated, their strings are as they are read
+	const Grafkit::LazyJsonDocument document(text);
+	std::vector<std::string> read;
+	Grafkit::Serializer::LazyJsonAdapter adapter(document.Root());
+	adapter >> read;
+	ASSERT_EQ("bad\xc3(", read[1]);
+
+	adapter.SetUtf8Validation(EValidation::Strict);
+	read.clear();
+	EXPECT_THROW(adapter >> read, std::runtime_error);
+}